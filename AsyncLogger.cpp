@@ -0,0 +1,380 @@
+#include "AsyncLogger.h"
+#include "RiskCheck.h"
+#include "RingBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<LogLevel> AsyncLogger::threshold(LogLevel::INFO);
+
+namespace {
+    const size_t WRITE_BATCH_BYTES = 64 * 1024;
+    const size_t RECORDS_PER_ROUND = 4096;   // per producer, so one busy thread cannot starve the rest
+
+    // One producing thread's ring. Producers are never freed, so a thread's
+    // cached pointer stays valid across stop()/start().
+    struct Producer {
+        SpscRing<LogRecord> ring;
+        std::atomic<size_t> written;    // records popped and written to the sink
+
+        explicit Producer(size_t capacity) : ring(capacity), written(0) {}
+    };
+
+    struct LoggerState {
+        std::mutex mutex;               // producers list, lifecycle, synchronous writes
+        std::vector<std::unique_ptr<Producer>> producers;
+        std::atomic<bool> running;
+        std::thread worker;
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        LoggerOptions options;
+        std::ofstream file;
+        uint64_t startTicks;
+        std::atomic<uint64_t> dropped;
+        uint64_t droppedReported;
+
+        LoggerState() : running(false), startTicks(0), dropped(0), droppedReported(0) {}
+    };
+
+    LoggerState& state() {
+        static LoggerState instance;
+        return instance;
+    }
+
+    thread_local Producer* localProducer = nullptr;
+
+    // Registry names resolved once per id; Registry keeps names at stable
+    // addresses, so caching the pointer avoids its mutex on every record
+    class NameCache {
+    public:
+        const char* symbol(SymbolId id) { return lookup(symbols, id, Registry::symbolName); }
+        const char* user(UserId id) { return lookup(users, id, Registry::userName); }
+
+    private:
+        std::vector<const std::string*> symbols;
+        std::vector<const std::string*> users;
+
+        static const char* lookup(std::vector<const std::string*>& cache, uint32_t id,
+                                  const std::string& (*resolve)(uint32_t)) {
+            if (id == Registry::INVALID_ID) {
+                return "?";
+            }
+            if (id >= cache.size()) {
+                cache.resize(id + 1, nullptr);
+            }
+            if (!cache[id]) {
+                cache[id] = &resolve(id);
+            }
+            return cache[id]->c_str();
+        }
+    };
+
+    // Render one record as the line(s) the console used to print directly
+    void formatRecord(const LogRecord& record, bool withPrefix, NameCache& names, std::string& out) {
+        char line[256];
+        int length = 0;
+        if (withPrefix) {
+            length = std::snprintf(line, sizeof(line), "[%llu %s] ",
+                                   static_cast<unsigned long long>(EngineClock::elapsedNanos(state().startTicks, record.ticks)),
+                                   AsyncLogger::levelName(record.level));
+        }
+        char* p = line + length;
+        size_t room = sizeof(line) - length;
+        const char* gap = withPrefix ? "" : "\n";
+        const unsigned long long id = record.id;
+        const unsigned long long otherId = record.otherId;
+
+        switch (record.event) {
+            case LogRecord::ORDER_PLACED:
+            case LogRecord::ORDER_REJECTED:
+            case LogRecord::INVALID_ORDER_ADD: {
+                const char* what = (record.event == LogRecord::ORDER_PLACED) ? "Placing"
+                                 : (record.event == LogRecord::ORDER_REJECTED) ? "Invalid order rejected"
+                                 : "Invalid order cannot be added to order book";
+                length += std::snprintf(p, room, "%s%s: Order[%llu]: %s %s %d@%f User: %s\n",
+                                        record.event == LogRecord::ORDER_PLACED ? gap : "", what,
+                                        id, names.symbol(record.symbolId),
+                                        record.side == OrderSide::BUY ? "BUY" : "SELL",
+                                        record.quantity, record.price, names.user(record.userId));
+                break;
+            }
+            case LogRecord::RISK_REJECTED:
+                length += std::snprintf(p, room, "Order %llu rejected by risk check: %s\n", id,
+                                        getRiskCheckName(static_cast<RiskCheck>(record.quantity)));
+                break;
+            case LogRecord::ORDER_RESTED:
+                length += std::snprintf(p, room, "Order placed in book (no immediate matches)\n");
+                break;
+            case LogRecord::EXECUTION_SUMMARY:
+                length += std::snprintf(p, room, "%s=== Trade Execution Summary ===\n", gap);
+                break;
+            case LogRecord::TRADE:
+            case LogRecord::TRADE_EXECUTED:
+                length += std::snprintf(p, room, "%sTrade[%llu]: %s %d@%f Buyer: %s Seller: %s\n",
+                                        record.event == LogRecord::TRADE_EXECUTED ? "TRADE EXECUTED: " : "",
+                                        id, names.symbol(record.symbolId), record.quantity, record.price,
+                                        names.user(record.userId), names.user(record.otherUserId));
+                break;
+            case LogRecord::ORDER_FILLED:
+                length += std::snprintf(p, room, "Order processed with %d trade(s)\n", record.quantity);
+                break;
+            case LogRecord::ORDER_CANCELLED:
+                length += std::snprintf(p, room, "Order %llu cancelled successfully!\n", id);
+                break;
+            case LogRecord::ORDER_MODIFIED:
+                length += std::snprintf(p, room, "%sOrder %llu modified to %d@%f\n", gap, id, record.quantity, record.price);
+                break;
+            case LogRecord::ORDER_EXPIRED:
+                length += std::snprintf(p, room, "Order %llu: unfilled quantity %d cancelled\n", id, record.quantity);
+                break;
+            case LogRecord::CANCEL_NOT_FOUND:
+                length += std::snprintf(p, room, "Order %llu not found!\n", id);
+                break;
+            case LogRecord::NO_ORDER_BOOK:
+                length += std::snprintf(p, room, "No order book exists for symbol %s\n", names.symbol(record.symbolId));
+                break;
+            case LogRecord::CALL_OPENED:
+                length += std::snprintf(p, room, "%sCall auction opened for %s\n", gap, names.symbol(record.symbolId));
+                break;
+            case LogRecord::AUCTION_UNCROSSED:
+                length += std::snprintf(p, room, "Auction %s uncrossed: %llu@%f in %llu trade(s)\n",
+                                        names.symbol(record.symbolId), otherId, record.price, id);
+                break;
+            case LogRecord::INVALID_ORDER_MATCH:
+                length += std::snprintf(p, room, "Invalid order cannot be matched: %llu\n", id);
+                break;
+            case LogRecord::INVALID_ORDER_PAIR:
+                length += std::snprintf(p, room, "Invalid orders for matching: %llu / %llu\n", id, otherId);
+                break;
+        }
+        out.append(line, std::min<size_t>(static_cast<size_t>(length), sizeof(line) - 1));
+    }
+
+    // Write one record immediately (logger not running)
+    void writeNow(const LogRecord& record) {
+        NameCache names;
+        std::string line;
+        formatRecord(record, false, names, line);
+        std::lock_guard<std::mutex> lock(state().mutex);
+        std::ostream& sink = (record.level >= LogLevel::WARN) ? std::cerr : std::cout;
+        sink << line;
+        sink.flush();
+    }
+
+    // Write buffered text to the configured sink(s)
+    void writeBuffers(LoggerState& s, std::string& normal, std::string& warnings) {
+        if (s.file.is_open()) {
+            s.file << normal;
+            s.file.flush();
+        } else {
+            if (!normal.empty()) {
+                std::cout << normal;
+                std::cout.flush();
+            }
+            if (!warnings.empty()) {
+                std::cerr << warnings;
+                std::cerr.flush();
+            }
+        }
+        normal.clear();
+        warnings.clear();
+    }
+
+    // Background thread: drain every ring, format, write in batches
+    void workerLoop() {
+        LoggerState& s = state();
+        bool toFile = s.file.is_open();
+        std::string normal;
+        std::string warnings;
+        std::vector<Producer*> producers;
+        std::vector<size_t> popped;
+        NameCache names;
+        LogRecord record;
+
+        for (;;) {
+            bool stopping = !s.running.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                producers.clear();
+                for (const auto& producer : s.producers) {
+                    producers.push_back(producer.get());
+                }
+            }
+            popped.assign(producers.size(), 0);
+
+            size_t drained = 0;
+            for (size_t i = 0; i < producers.size(); ++i) {
+                size_t taken = 0;
+                while (taken < RECORDS_PER_ROUND && producers[i]->ring.tryPop(record)) {
+                    std::string& target = (!toFile && record.level >= LogLevel::WARN) ? warnings : normal;
+                    formatRecord(record, toFile, names, target);
+                    ++taken;
+                    if (normal.size() + warnings.size() >= WRITE_BATCH_BYTES) {
+                        writeBuffers(s, normal, warnings);
+                    }
+                }
+                popped[i] = taken;
+                drained += taken;
+            }
+
+            uint64_t dropped = s.dropped.load(std::memory_order_relaxed);
+            if (dropped != s.droppedReported) {
+                std::string& target = toFile ? normal : warnings;
+                target += "[logger] " + std::to_string(dropped - s.droppedReported)
+                        + " record(s) dropped: ring full\n";
+                s.droppedReported = dropped;
+            }
+            writeBuffers(s, normal, warnings);
+            for (size_t i = 0; i < producers.size(); ++i) {
+                if (popped[i]) {
+                    producers[i]->written.fetch_add(popped[i], std::memory_order_release);
+                }
+            }
+
+            if (drained == 0) {
+                if (stopping) {
+                    break;
+                }
+                std::unique_lock<std::mutex> lock(s.wakeMutex);
+                s.wake.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    // Create and register this thread's ring
+    Producer* registerThread() {
+        LoggerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.producers.emplace_back(new Producer(s.options.ringCapacity));
+        localProducer = s.producers.back().get();
+        return localProducer;
+    }
+}
+
+// Start the background writer
+void AsyncLogger::start(const LoggerOptions& options) {
+    LoggerState& s = state();
+    if (s.running.load(std::memory_order_acquire)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.options = options;
+        if (!options.path.empty()) {
+            s.file.open(options.path, std::ios::out | std::ios::app);
+            if (!s.file) {
+                std::cerr << "Cannot open log file " << options.path << ", logging to console" << std::endl;
+            }
+        }
+        s.startTicks = EngineClock::now();
+    }
+    setLevel(options.level);
+    s.running.store(true, std::memory_order_release);
+    s.worker = std::thread(workerLoop);
+
+    static bool stopRegistered = false;
+    if (!stopRegistered) {
+        std::atexit(AsyncLogger::stop);
+        stopRegistered = true;
+    }
+}
+
+// Drain and stop the background writer
+void AsyncLogger::stop() {
+    LoggerState& s = state();
+    if (!s.running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    s.wake.notify_one();
+    s.worker.join();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.file.is_open()) {
+        s.file.close();
+    }
+}
+
+bool AsyncLogger::isRunning() {
+    return state().running.load(std::memory_order_acquire);
+}
+
+// Wait until every record pushed before this call has been written
+void AsyncLogger::flush() {
+    LoggerState& s = state();
+    if (!isRunning()) {
+        return;
+    }
+    std::vector<std::pair<Producer*, size_t>> targets;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const auto& producer : s.producers) {
+            targets.emplace_back(producer.get(), producer->ring.getPushedCount());
+        }
+    }
+    s.wake.notify_one();
+    for (const auto& target : targets) {
+        while (target.first->written.load(std::memory_order_acquire) < target.second && isRunning()) {
+            s.wake.notify_one();
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+// Queue a record (or write it now when the logger is not running)
+void AsyncLogger::submit(const LogRecord& record) {
+    LoggerState& s = state();
+    if (!s.running.load(std::memory_order_acquire)) {
+        writeNow(record);
+        return;
+    }
+    Producer* producer = localProducer ? localProducer : registerThread();
+    if (producer->ring.tryPush(record)) {
+        return;
+    }
+    if (s.options.overflow == LogOverflow::DROP) {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Wait for room; if stop() begins meanwhile nothing will drain the ring, so write directly
+    s.wake.notify_one();
+    while (!producer->ring.tryPush(record)) {
+        if (!s.running.load(std::memory_order_acquire)) {
+            writeNow(record);
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+uint64_t AsyncLogger::getDroppedCount() {
+    return state().dropped.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogger::parseLevel(const std::string& text, LogLevel& level) {
+    static const LogLevel levels[] = { LogLevel::DEBUG, LogLevel::INFO, LogLevel::WARN, LogLevel::ERROR, LogLevel::OFF };
+    for (LogLevel candidate : levels) {
+        if (text == levelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* AsyncLogger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "debug";
+        case LogLevel::INFO: return "info";
+        case LogLevel::WARN: return "warn";
+        case LogLevel::ERROR: return "error";
+        case LogLevel::OFF: return "off";
+    }
+    return "?";
+}
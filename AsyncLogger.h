@@ -0,0 +1,160 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include "EngineClock.h"
+#include "Order.h"
+#include "Trade.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class LogLevel : uint8_t { DEBUG, INFO, WARN, ERROR, OFF };
+
+// What a producer does when its ring is full
+enum class LogOverflow { DROP, BLOCK };
+
+// Logger configuration
+struct LoggerOptions {
+    LogLevel level;
+    LogOverflow overflow;
+    size_t ringCapacity;    // records per producing thread
+    std::string path;       // empty = stdout (WARN and above to stderr)
+
+    LoggerOptions() : level(LogLevel::INFO), overflow(LogOverflow::BLOCK), ringCapacity(16384) {}
+};
+
+// One fixed-size binary log record. Producers copy ids and numbers only;
+// names and text are rendered later on the logger thread.
+struct LogRecord {
+    enum Event : uint8_t {
+        ORDER_PLACED,           // order fields
+        ORDER_RESTED,           // orderId
+        EXECUTION_SUMMARY,      // orderId; trades follow
+        TRADE,                  // trade fields
+        TRADE_EXECUTED,         // trade fields (batch matching)
+        ORDER_FILLED,           // orderId, count = trades
+        ORDER_CANCELLED,        // orderId
+        ORDER_MODIFIED,         // orderId, quantity, price
+        ORDER_EXPIRED,          // orderId, count = unfilled quantity (market, IOC, FOK)
+        CANCEL_NOT_FOUND,       // orderId
+        NO_ORDER_BOOK,          // symbolId
+        CALL_OPENED,            // symbolId
+        AUCTION_UNCROSSED,      // symbolId, price, otherId = volume, id = trades
+        ORDER_REJECTED,         // order fields
+        RISK_REJECTED,          // orderId, count = RiskCheck
+        INVALID_ORDER_ADD,      // order fields
+        INVALID_ORDER_MATCH,    // orderId
+        INVALID_ORDER_PAIR      // orderId, otherId
+    };
+
+    uint64_t ticks;         // EngineClock time of the event
+    double price;
+    uint64_t id;            // order or trade id
+    uint64_t otherId;       // second order id, or a 64-bit total
+    int32_t quantity;       // quantity, or a count for summary events
+    SymbolId symbolId;
+    UserId userId;          // order owner, or buyer for trades
+    UserId otherUserId;     // seller for trades
+    LogLevel level;
+    Event event;
+    OrderSide side;
+};
+
+// Process-wide asynchronous logger.
+// Every producing thread gets its own lock-free SPSC ring of LogRecords;
+// a background thread drains the rings, formats the text and writes it in
+// batches, so the hot path never formats, locks or flushes. Before start()
+// (and after stop()) records are formatted and written synchronously.
+class AsyncLogger {
+public:
+    // Lifecycle
+    static void start(const LoggerOptions& options = LoggerOptions());  // also registers stop() at exit
+    static void stop();                 // drains outstanding records first
+    static void flush();                // returns once everything logged so far is written
+    static bool isRunning();
+
+    // Level filter
+    static void setLevel(LogLevel level) { threshold.store(level, std::memory_order_relaxed); }
+    static LogLevel getLevel() { return threshold.load(std::memory_order_relaxed); }
+    static bool isEnabled(LogLevel level) { return level >= getLevel(); }
+
+    // Event helpers
+    static void logOrder(LogLevel level, LogRecord::Event event, const Order& order) {
+        if (!isEnabled(level)) return;
+        LogRecord record = makeRecord(level, event);
+        record.id = order.orderId;
+        record.symbolId = order.symbolId;
+        record.userId = order.userId;
+        record.side = order.side;
+        record.quantity = order.quantity;
+        record.price = order.price;
+        submit(record);
+    }
+    static void logFill(LogLevel level, LogRecord::Event event, const Fill& fill) {
+        if (!isEnabled(level)) return;
+        LogRecord record = makeRecord(level, event);
+        record.id = fill.tradeId;
+        record.symbolId = fill.symbolId;
+        record.userId = fill.buyUserId;
+        record.otherUserId = fill.sellUserId;
+        record.quantity = fill.quantity;
+        record.price = fill.price;
+        submit(record);
+    }
+    static void logAuction(LogLevel level, LogRecord::Event event, SymbolId symbolId,
+                           double price, int64_t volume, int trades) {
+        if (!isEnabled(level)) return;
+        LogRecord record = makeRecord(level, event);
+        record.symbolId = symbolId;
+        record.price = price;
+        record.otherId = static_cast<uint64_t>(volume);
+        record.id = trades;
+        submit(record);
+    }
+    static void logModify(LogLevel level, SymbolId symbolId, OrderId orderId, int quantity, double price) {
+        if (!isEnabled(level)) return;
+        LogRecord record = makeRecord(level, LogRecord::ORDER_MODIFIED);
+        record.symbolId = symbolId;
+        record.id = orderId;
+        record.quantity = quantity;
+        record.price = price;
+        submit(record);
+    }
+    static void logEvent(LogLevel level, LogRecord::Event event, SymbolId symbolId,
+                         OrderId id, int count = 0, OrderId otherId = 0) {
+        if (!isEnabled(level)) return;
+        LogRecord record = makeRecord(level, event);
+        record.symbolId = symbolId;
+        record.id = id;
+        record.quantity = count;
+        record.otherId = otherId;
+        submit(record);
+    }
+
+    // Core entry point
+    static void submit(const LogRecord& record);
+
+    // Statistics
+    static uint64_t getDroppedCount();
+
+    // Level names ("debug", "info", "warn", "error", "off")
+    static bool parseLevel(const std::string& text, LogLevel& level);
+    static const char* levelName(LogLevel level);
+
+private:
+    static std::atomic<LogLevel> threshold;
+
+    static LogRecord makeRecord(LogLevel level, LogRecord::Event event) {
+        LogRecord record = {};
+        record.ticks = EngineClock::now();
+        record.level = level;
+        record.event = event;
+        record.symbolId = Registry::INVALID_ID;
+        record.userId = Registry::INVALID_ID;
+        record.otherUserId = Registry::INVALID_ID;
+        return record;
+    }
+};
+
+#endif // ASYNCLOGGER_H
@@ -0,0 +1,326 @@
+#include "BatchDriver.h"
+#include "OrderLog.h"
+#include "ShardedEngine.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    // Advance past spaces and tabs
+    const char* skipBlanks(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        return p;
+    }
+
+    // Read one whitespace-delimited token
+    bool nextToken(const char*& p, const char* end, std::string& token) {
+        p = skipBlanks(p, end);
+        const char* start = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+        token.assign(start, p);
+        return !token.empty();
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+// Constructor
+BatchDriver::BatchDriver(TradeBookingSystem& tradingSystem)
+    : system(tradingSystem), parseErrors(0), parseSeconds(0.0), snapshots(nullptr) {
+}
+
+// Load commands from a file or stdin
+bool BatchDriver::load(const std::string& path) {
+    std::stringstream buffer;
+    if (path == "-") {
+        buffer << std::cin.rdbuf();
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open batch file: " << path << std::endl;
+            return false;
+        }
+        buffer << file.rdbuf();
+    }
+    loadFromString(buffer.str());
+    return true;
+}
+
+// Parse commands held in memory
+void BatchDriver::loadFromString(const std::string& text) {
+    auto start = std::chrono::steady_clock::now();
+    const char* p = text.data();
+    const char* end = p + text.size();
+    size_t lineNumber = 0;
+
+    while (p < end) {
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n') ++lineEnd;
+        ++lineNumber;
+        if (!parseLine(p, lineEnd, lineNumber)) {
+            ++parseErrors;
+        }
+        p = lineEnd + 1;
+    }
+
+    parseSeconds += secondsSince(start);
+}
+
+// Parse one command line
+bool BatchDriver::parseLine(const char* p, const char* end, size_t lineNumber) {
+    p = skipBlanks(p, end);
+    if (p == end || *p == '#') {
+        return true; // blank or comment
+    }
+
+    std::string kind, ref, user, symbol, side, quantity, price, orderType;
+    nextToken(p, end, kind);
+    BatchCommand command;
+    command.side = OrderSide::BUY;
+    command.orderType = OrderType::LIMIT;
+    command.symbol = Registry::INVALID_ID;
+    command.userId = Registry::INVALID_ID;
+    command.quantity = 0;
+    command.price = 0.0;
+
+    bool ok = nextToken(p, end, ref);
+    if (kind == "N") {
+        command.type = BatchCommand::NEW_ORDER;
+        ok = ok && nextToken(p, end, user) && nextToken(p, end, symbol) && nextToken(p, end, side)
+                && nextToken(p, end, quantity) && nextToken(p, end, price);
+        if (ok && nextToken(p, end, orderType) && !parseOrderType(orderType, command.orderType)) {
+            std::cerr << "Batch line " << lineNumber << ": unknown order type " << orderType << std::endl;
+            return false;
+        }
+        if (ok && side != "B" && side != "b" && side != "S" && side != "s") {
+            std::cerr << "Batch line " << lineNumber << ": side must be B or S, not " << side << std::endl;
+            return false;
+        }
+    } else if (kind == "C") {
+        command.type = BatchCommand::CANCEL_ORDER;
+    } else if (kind == "M") {
+        command.type = BatchCommand::MODIFY_ORDER;
+        ok = ok && nextToken(p, end, quantity) && nextToken(p, end, price);
+    } else if (kind == "A" || kind == "U") {
+        // Auctions name a symbol where orders carry their reference
+        command.type = (kind == "A") ? BatchCommand::OPEN_CALL : BatchCommand::UNCROSS;
+        symbol = ref;
+        ref = "0";
+    } else {
+        ok = false;
+    }
+
+    if (!ok) {
+        std::cerr << "Batch line " << lineNumber << ": malformed command" << std::endl;
+        return false;
+    }
+
+    command.ref = std::strtoull(ref.c_str(), nullptr, 10);
+    if (command.type == BatchCommand::NEW_ORDER || command.type == BatchCommand::MODIFY_ORDER) {
+        command.quantity = std::atoi(quantity.c_str());
+        command.price = std::strtod(price.c_str(), nullptr);
+        bool priced = command.price > 0 || command.orderType == OrderType::MARKET;
+        if (command.quantity <= 0 || !priced) {
+            std::cerr << "Batch line " << lineNumber << ": quantity must be positive, and price too unless MARKET" << std::endl;
+            return false;
+        }
+    }
+
+    if (command.type != BatchCommand::CANCEL_ORDER && command.type != BatchCommand::MODIFY_ORDER) {
+        command.symbol = Registry::findSymbol(symbol);
+        if (!system.isSymbolAvailable(command.symbol)) {
+            std::cerr << "Batch line " << lineNumber << ": unknown symbol " << symbol << std::endl;
+            return false;
+        }
+    }
+    if (command.type == BatchCommand::NEW_ORDER) {
+        command.userId = system.createUserIfNotExists(user);
+        command.side = (side == "B" || side == "b") ? OrderSide::BUY : OrderSide::SELL;   // checked above
+    }
+
+    commands.push_back(command);
+    return true;
+}
+
+// Execute the loaded commands
+BatchStatistics BatchDriver::run(size_t shards) {
+    BatchStatistics stats = (shards > 0) ? runSharded(shards) : runInline();
+    stats.parseSeconds = parseSeconds;
+    return stats;
+}
+
+// Run through TradeBookingSystem on this thread
+BatchStatistics BatchDriver::runInline() {
+    BatchStatistics stats;
+    std::unordered_map<uint64_t, OrderRef> refs;
+    refs.reserve(commands.size());
+    size_t tradesBefore = system.getTotalTradesExecuted();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& command : commands) {
+        ++stats.commands;
+        switch (command.type) {
+            case BatchCommand::NEW_ORDER: {
+                ++stats.newOrders;
+                OrderId orderId = system.placeOrderDirect(command.userId, command.symbol, command.side,
+                                                      command.quantity, command.price, command.orderType);
+                if (orderId == 0) {
+                    ++stats.rejected;   // refused by the risk gate: there is nothing to cancel or modify
+                    break;
+                }
+                OrderRef entry = { command.symbol, command.userId, command.side, orderId };
+                refs[command.ref] = entry;
+                break;
+            }
+            case BatchCommand::CANCEL_ORDER: {
+                ++stats.cancels;
+                auto it = refs.find(command.ref);
+                if (it == refs.end() || !system.cancelOrderDirect(it->second.orderId)) {
+                    ++stats.rejected;
+                }
+                if (it != refs.end()) {
+                    refs.erase(it);
+                }
+                break;
+            }
+            case BatchCommand::MODIFY_ORDER: {
+                ++stats.modifies;
+                auto it = refs.find(command.ref);
+                if (it == refs.end() || !system.modifyOrderDirect(it->second.symbol, it->second.orderId,
+                                                                  command.quantity, command.price)) {
+                    ++stats.rejected;
+                }
+                break;
+            }
+            case BatchCommand::OPEN_CALL:
+                ++stats.auctions;
+                if (!system.openCallAuction(command.symbol)) {
+                    ++stats.rejected;
+                }
+                break;
+            case BatchCommand::UNCROSS: {
+                ++stats.auctions;
+                const OrderBook* book = system.getOrderBook(command.symbol);
+                if (!book || !book->isInCall()) {
+                    ++stats.rejected;
+                    break;
+                }
+                system.uncrossAuction(command.symbol);
+                break;
+            }
+        }
+        if (snapshots) {
+            snapshots->onEvent();
+        }
+    }
+    stats.runSeconds = secondsSince(start);
+    stats.trades = system.getTotalTradesExecuted() - tradesBefore;
+    return stats;
+}
+
+// Run through a ShardedEngine (matching only; portfolios are not updated)
+BatchStatistics BatchDriver::runSharded(size_t shards) {
+    BatchStatistics stats;
+    std::unordered_map<uint64_t, OrderRef> refs;
+    refs.reserve(commands.size());
+    ShardedEngine engine(shards);
+    engine.start();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& command : commands) {
+        ++stats.commands;
+        switch (command.type) {
+            case BatchCommand::NEW_ORDER: {
+                ++stats.newOrders;
+                OrderId orderId = engine.submitNewOrder(command.userId, command.symbol, command.side,
+                                                    command.quantity, command.price, command.orderType);
+                OrderRef entry = { command.symbol, command.userId, command.side, orderId };
+                refs[command.ref] = entry;
+                break;
+            }
+            case BatchCommand::CANCEL_ORDER: {
+                ++stats.cancels;
+                auto it = refs.find(command.ref);
+                if (it == refs.end()) {
+                    ++stats.rejected;
+                    break;
+                }
+                engine.submitCancel(it->second.symbol, it->second.orderId);
+                refs.erase(it);
+                break;
+            }
+            case BatchCommand::MODIFY_ORDER: {
+                ++stats.modifies;
+                auto it = refs.find(command.ref);
+                if (it == refs.end()) {
+                    ++stats.rejected;
+                    break;
+                }
+                engine.submitModify(it->second.symbol, it->second.orderId, command.quantity, command.price);
+                break;
+            }
+            case BatchCommand::OPEN_CALL:
+            case BatchCommand::UNCROSS:
+                ++stats.auctions;
+                engine.submitAuction(command.symbol, (command.type == BatchCommand::OPEN_CALL)
+                                                         ? OrderCommand::OPEN_CALL : OrderCommand::UNCROSS);
+                break;
+        }
+    }
+    engine.waitUntilIdle();
+    stats.runSeconds = secondsSince(start);
+    stats.trades = engine.getTradesExecuted();
+    engine.stop();
+    return stats;
+}
+
+// Write the loaded commands as a binary order log. Text batches carry no
+// capture times, so events are stamped 1 microsecond apart.
+bool BatchDriver::exportOrderLog(const std::string& path) const {
+    OrderLogWriter writer;
+    uint64_t timestampNs = 0;
+    for (const auto& command : commands) {
+        switch (command.type) {
+            case BatchCommand::NEW_ORDER:
+                writer.addNewOrder(timestampNs, command.ref, Registry::userName(command.userId),
+                                   Registry::symbolName(command.symbol), command.side,
+                                   command.quantity, command.price, command.orderType);
+                break;
+            case BatchCommand::CANCEL_ORDER:
+                writer.addCancel(timestampNs, command.ref);
+                break;
+            case BatchCommand::MODIFY_ORDER:
+                writer.addModify(timestampNs, command.ref, command.quantity, command.price);
+                break;
+            case BatchCommand::OPEN_CALL:
+            case BatchCommand::UNCROSS:
+                writer.addAuction(timestampNs, Registry::symbolName(command.symbol),
+                                  command.type == BatchCommand::OPEN_CALL ? OrderLogEvent::OPEN_CALL
+                                                                          : OrderLogEvent::UNCROSS);
+                break;
+        }
+        timestampNs += 1000;
+    }
+    return writer.write(path);
+}
+
+// Print a throughput report
+void BatchDriver::printReport(const BatchStatistics& stats, std::ostream& out) {
+    double seconds = stats.runSeconds > 0 ? stats.runSeconds : 1e-9;
+    out << "\n=== Batch Run Report ===" << std::endl;
+    out << "Commands: " << stats.commands << " (new " << stats.newOrders
+        << ", cancel " << stats.cancels << ", modify " << stats.modifies
+        << ", auction " << stats.auctions << ", rejected " << stats.rejected << ")" << std::endl;
+    out << "Trades: " << stats.trades << std::endl;
+    out << std::fixed << std::setprecision(3);
+    out << "Parse time: " << stats.parseSeconds << " s" << std::endl;
+    out << "Run time: " << stats.runSeconds << " s" << std::endl;
+    out << std::setprecision(0);
+    out << "Commands/sec: " << stats.commands / seconds << std::endl;
+    out << "New orders/sec: " << stats.newOrders / seconds << std::endl;
+    out << "Trades/sec: " << stats.trades / seconds << std::endl;
+}
@@ -0,0 +1,92 @@
+#ifndef BATCHDRIVER_H
+#define BATCHDRIVER_H
+
+#include "TradeBookingSystem.h"
+#include "Snapshot.h"
+#include "Registry.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One pre-parsed batch command. Orders are referred to by a client-chosen
+// reference so that input files do not depend on engine-assigned order ids.
+struct BatchCommand {
+    enum Type : uint8_t { NEW_ORDER, CANCEL_ORDER, MODIFY_ORDER, OPEN_CALL, UNCROSS };
+
+    Type type;
+    OrderSide side;
+    OrderType orderType;    // NEW_ORDER only
+    SymbolId symbol;        // NEW_ORDER, OPEN_CALL, UNCROSS
+    UserId userId;
+    uint64_t ref;
+    int quantity;
+    double price;
+};
+
+// Results of a batch run
+struct BatchStatistics {
+    uint64_t commands;
+    uint64_t newOrders;
+    uint64_t cancels;
+    uint64_t modifies;
+    uint64_t auctions;      // call opens and uncrosses
+    uint64_t rejected;
+    uint64_t trades;
+    double parseSeconds;
+    double runSeconds;
+
+    BatchStatistics()
+        : commands(0), newOrders(0), cancels(0), modifies(0), auctions(0), rejected(0), trades(0),
+          parseSeconds(0.0), runSeconds(0.0) {}
+};
+
+// Headless order-entry driver.
+// The whole input is parsed up front (names resolved to ids once) and the
+// commands are then replayed back-to-back into the system, so the timed
+// section measures order handling rather than text parsing.
+class BatchDriver {
+public:
+    // Constructor
+    explicit BatchDriver(TradeBookingSystem& tradingSystem);
+
+    // Input ("-" reads stdin)
+    bool load(const std::string& path); // false when the input cannot be read
+    void loadFromString(const std::string& text);
+
+    // Execution (shards > 0 runs the orders through a ShardedEngine instead)
+    BatchStatistics run(size_t shards = 0);
+    
+    // Inline runs tell the writer about every command (null = no periodic snapshots)
+    void setSnapshotWriter(SnapshotWriter* writer) { snapshots = writer; }
+
+    // Conversion to the binary order-log format (see OrderLog.h)
+    bool exportOrderLog(const std::string& path) const;
+
+    // Reporting
+    static void printReport(const BatchStatistics& stats, std::ostream& out = std::cout);
+    size_t getCommandCount() const { return commands.size(); }
+    size_t getParseErrorCount() const { return parseErrors; }
+
+private:
+    // Engine-side identity of a live client reference
+    struct OrderRef {
+        SymbolId symbol;
+        UserId userId;
+        OrderSide side;
+        OrderId orderId;
+    };
+
+    TradeBookingSystem& system;
+    std::vector<BatchCommand> commands;
+    size_t parseErrors;
+    double parseSeconds;
+    SnapshotWriter* snapshots;
+
+    bool parseLine(const char* begin, const char* end, size_t lineNumber);
+    BatchStatistics runInline();
+    BatchStatistics runSharded(size_t shards);
+};
+
+#endif // BATCHDRIVER_H
@@ -0,0 +1,595 @@
+// Microbenchmarks for the OrderBook / MatchingEngine / Portfolio / RiskGate hot paths.
+// Built by `make bench` into ./trading_bench; not part of trading_system.
+
+#include "MatchingEngine.h"
+#include "OrderBook.h"
+#include "Portfolio.h"
+#include "Registry.h"
+#include "RiskGate.h"
+#include "Util.h"
+#include "ValuationEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Count every heap allocation so each benchmark can report allocations/op
+namespace {
+    std::atomic<uint64_t> allocationCount(0);
+}
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// GCC cannot see that operator new above is malloc-backed and flags the free()
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#pragma GCC diagnostic pop
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    const int64_t BID_TOP_TICK = 10000000;  // best bid 100000.00, levels step down
+    const int64_t ASK_TOP_TICK = 10000001;  // best ask 100000.01, levels step up
+    const int ORDER_QUANTITY = 100;
+    const size_t SWEEP_LEVELS = 5;
+    const int READS_PER_SAMPLE = 16;        // cheap reads are timed in groups
+    const double ROW_SECONDS = 2.0;         // cap per row, so O(depth) paths still finish
+
+    volatile double doubleSink;
+    volatile size_t sizeSink;
+
+    // Consumes fills from the streaming matchOrder without collecting them
+    struct FillSink : public ExecutionListener {
+        void onFill(const Fill& fill) override { sizeSink = static_cast<size_t>(fill.quantity); }
+    };
+    FillSink fillSink;
+
+    double tickPrice(int64_t tick) {
+        return tick * 0.01;
+    }
+
+    // Per-operation samples plus allocation count for one benchmark
+    class Recorder {
+    public:
+        explicit Recorder(size_t samples)
+            : requested(samples), allocations(0), totalOps(0), started(Clock::now()) {
+            nanos.reserve(samples);
+        }
+
+        // True once the row has used up its time budget
+        bool expired() const {
+            return std::chrono::duration<double>(Clock::now() - started).count() > ROW_SECONDS;
+        }
+
+        // Time one call of fn, which performs `ops` operations
+        template<typename Fn>
+        void measure(Fn&& fn, int ops = 1) {
+            uint64_t allocsBefore = allocationCount.load(std::memory_order_relaxed);
+            auto start = Clock::now();
+            fn();
+            auto end = Clock::now();
+            allocations += allocationCount.load(std::memory_order_relaxed) - allocsBefore;
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            nanos.push_back(ns / ops);
+            totalOps += ops;
+        }
+
+        void report(const std::string& name, size_t depth, size_t perLevel) {
+            if (nanos.empty()) {
+                return;
+            }
+            double total = 0;
+            for (double ns : nanos) total += ns;
+            std::sort(nanos.begin(), nanos.end());
+
+            std::cout << std::left << std::setw(24) << name << std::right;
+            if (depth > 0) {
+                std::cout << std::setw(9) << depth << std::setw(8) << perLevel;
+            } else {
+                std::cout << std::setw(9) << "-" << std::setw(8) << "-";
+            }
+            std::cout << std::fixed << std::setprecision(1)
+                      << std::setw(12) << total / nanos.size()
+                      << std::setprecision(2)
+                      << std::setw(11) << static_cast<double>(allocations) / totalOps
+                      << std::setprecision(0)
+                      << std::setw(11) << percentile(0.50)
+                      << std::setw(11) << percentile(0.90)
+                      << std::setw(11) << percentile(0.99)
+                      << std::setw(11) << percentile(0.999)
+                      << std::setw(11) << nanos.back()
+                      << (nanos.size() < requested ? "  (time-capped)" : "") << std::endl;
+        }
+
+    private:
+        std::vector<double> nanos;
+        size_t requested;
+        uint64_t allocations;
+        uint64_t totalOps;
+        Clock::time_point started;
+
+        double percentile(double q) const {
+            size_t index = static_cast<size_t>(q * (nanos.size() - 1));
+            return nanos[index];
+        }
+    };
+
+    // A resting order the fixture can re-create at the same place
+    struct Slot {
+        OrderId orderId;
+        OrderSide side;
+        int64_t tick;
+    };
+
+    // A book holding `depth` resting orders, split evenly between the sides,
+    // with `perLevel` orders on each price level
+    class Fixture {
+    public:
+        Fixture(SymbolId symbol, UserId user, size_t depth, size_t perLevel)
+            : book(symbol, 0.01, depth + 1024), userId(user), perLevel(perLevel) {
+            levelsPerSide = std::max<size_t>(1, depth / 2 / perLevel);
+            slots.reserve(levelsPerSide * perLevel * 2);
+            for (size_t level = 0; level < levelsPerSide; ++level) {
+                for (size_t i = 0; i < perLevel; ++i) {
+                    slots.push_back(rest(OrderSide::BUY, BID_TOP_TICK - static_cast<int64_t>(level)));
+                    slots.push_back(rest(OrderSide::SELL, ASK_TOP_TICK + static_cast<int64_t>(level)));
+                }
+            }
+        }
+
+        Slot rest(OrderSide side, int64_t tick) {
+            Order* order = book.createOrder(side, ORDER_QUANTITY, tickPrice(tick), userId);
+            Slot slot = { order->getOrderId(), side, tick };
+            book.addOrder(order);
+            return slot;
+        }
+
+        // A non-crossing price on an existing level
+        int64_t passiveTick(OrderSide side, Random& random) const {
+            int64_t level = static_cast<int64_t>(random.below(levelsPerSide));
+            return side == OrderSide::BUY ? BID_TOP_TICK - level : ASK_TOP_TICK + level;
+        }
+
+        OrderBook book;
+        UserId userId;
+        size_t perLevel;
+        size_t levelsPerSide;
+        std::vector<Slot> slots;
+    };
+
+    struct Config {
+        size_t depth;
+        size_t perLevel;
+        size_t ops;
+    };
+
+    OrderSide sideFor(uint64_t n) {
+        return (n & 1) ? OrderSide::SELL : OrderSide::BUY;
+    }
+
+    // OrderBook::addOrder of a passive order; the order is cancelled untimed
+    void benchAddOrder(Fixture& f, const Config& config, Recorder& recorder) {
+        Random random(1);
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            OrderSide side = sideFor(random.next());
+            Order* order = f.book.createOrder(side, ORDER_QUANTITY, tickPrice(f.passiveTick(side, random)), f.userId);
+            OrderId orderId = order->getOrderId();
+            recorder.measure([&] { f.book.addOrder(order); });
+            f.book.cancelOrder(orderId);
+        }
+    }
+
+    // OrderBook::cancelOrder of a random resting order; it is replaced untimed
+    void benchCancelOrder(Fixture& f, const Config& config, Recorder& recorder) {
+        Random random(2);
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            Slot& slot = f.slots[random.below(f.slots.size())];
+            recorder.measure([&] { f.book.cancelOrder(slot.orderId); });
+            slot = f.rest(slot.side, slot.tick);
+        }
+    }
+
+    // MatchingEngine::modifyOrder shrinking a random resting order in place; it is replaced untimed
+    void benchModifySizeDown(Fixture& f, const Config& config, Recorder& recorder) {
+        Random random(6);
+        size_t fills = 0;
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            Slot& slot = f.slots[random.below(f.slots.size())];
+            recorder.measure([&] {
+                MatchingEngine::modifyOrder(f.book, slot.orderId, ORDER_QUANTITY / 2, tickPrice(slot.tick),
+                                            fillSink, fills);
+            });
+            f.book.cancelOrder(slot.orderId);
+            slot = f.rest(slot.side, slot.tick);
+        }
+    }
+
+    // MatchingEngine::modifyOrder moving a random resting order to another passive level
+    void benchModifyReprice(Fixture& f, const Config& config, Recorder& recorder) {
+        Random random(7);
+        size_t fills = 0;
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            Slot& slot = f.slots[random.below(f.slots.size())];
+            int64_t tick = f.passiveTick(slot.side, random);
+            recorder.measure([&] {
+                MatchingEngine::modifyOrder(f.book, slot.orderId, ORDER_QUANTITY, tickPrice(tick), fillSink, fills);
+            });
+            slot.tick = tick;
+        }
+    }
+
+    void benchBestAndSpread(Fixture& f, const Config& config, Recorder& recorder) {
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            recorder.measure([&] {
+                for (int r = 0; r < READS_PER_SAMPLE; ++r) {
+                    doubleSink = f.book.getBestBidPrice() + f.book.getSpread();
+                }
+            }, READS_PER_SAMPLE);
+        }
+    }
+
+    void benchTotalOrderCount(Fixture& f, const Config& config, Recorder& recorder) {
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            recorder.measure([&] {
+                for (int r = 0; r < READS_PER_SAMPLE; ++r) {
+                    sizeSink = f.book.getTotalOrderCount();
+                }
+            }, READS_PER_SAMPLE);
+        }
+    }
+
+    // Top five levels of each side, as a depth poll would read them
+    void benchDepthTop5(Fixture& f, const Config& config, Recorder& recorder) {
+        std::vector<DepthLevel> levels;
+        levels.reserve(5);
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            recorder.measure([&] {
+                f.book.getDepth(OrderSide::BUY, 5, levels);
+                sizeSink = levels.size();
+                f.book.getDepth(OrderSide::SELL, 5, levels);
+                sizeSink = levels.size();
+            });
+        }
+    }
+
+    // MatchingEngine::matchOrder of an order that rests without trading
+    void benchMatchPassive(Fixture& f, const Config& config, Recorder& recorder) {
+        Random random(3);
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            OrderSide side = sideFor(random.next());
+            Order* order = f.book.createOrder(side, ORDER_QUANTITY, tickPrice(f.passiveTick(side, random)), f.userId);
+            OrderId orderId = order->getOrderId();
+            recorder.measure([&] { MatchingEngine::matchOrder(f.book, order, fillSink); });
+            f.book.cancelOrder(orderId);
+        }
+    }
+
+    // MatchingEngine::matchOrder filling exactly one resting order at the touch
+    void benchMatchSingleFill(Fixture& f, const Config& config, Recorder& recorder) {
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            OrderSide side = sideFor(i);
+            OrderSide restingSide = (side == OrderSide::BUY) ? OrderSide::SELL : OrderSide::BUY;
+            int64_t touch = (side == OrderSide::BUY) ? ASK_TOP_TICK : BID_TOP_TICK;
+            Order* order = f.book.createOrder(side, ORDER_QUANTITY, tickPrice(touch), f.userId);
+            recorder.measure([&] { MatchingEngine::matchOrder(f.book, order, fillSink); });
+            f.rest(restingSide, touch);
+        }
+    }
+
+    // MatchingEngine::matchOrder sweeping several whole levels
+    void benchMatchSweep(Fixture& f, const Config& config, Recorder& recorder) {
+        size_t levels = std::min(SWEEP_LEVELS, f.levelsPerSide);
+        int quantity = static_cast<int>(levels * f.perLevel) * ORDER_QUANTITY;
+        for (size_t i = 0; i < config.ops && !recorder.expired(); ++i) {
+            OrderSide side = sideFor(i);
+            OrderSide restingSide = (side == OrderSide::BUY) ? OrderSide::SELL : OrderSide::BUY;
+            int64_t step = (side == OrderSide::BUY) ? 1 : -1;
+            int64_t touch = (side == OrderSide::BUY) ? ASK_TOP_TICK : BID_TOP_TICK;
+            int64_t limit = touch + step * static_cast<int64_t>(levels - 1);
+            Order* order = f.book.createOrder(side, quantity, tickPrice(limit), f.userId);
+            recorder.measure([&] { MatchingEngine::matchOrder(f.book, order, fillSink); });
+            for (size_t level = 0; level < levels; ++level) {
+                for (size_t n = 0; n < f.perLevel; ++n) {
+                    f.rest(restingSide, touch + step * static_cast<int64_t>(level));
+                }
+            }
+        }
+    }
+
+    // Portfolio::addTrade alternating buys and sells across a few symbols
+    void benchPortfolioAddTrade(size_t ops) {
+        const size_t symbolCount = 8;
+        UserId userId = Registry::internUser("bench-portfolio");
+        std::vector<SymbolId> symbols;
+        for (size_t i = 0; i < symbolCount; ++i) {
+            symbols.push_back(Registry::internSymbol("BENCH" + std::to_string(i)));
+        }
+        std::vector<Trade> trades;
+        trades.reserve(ops);
+        for (size_t i = 0; i < ops; ++i) {
+            trades.push_back(Trade(symbols[i % symbolCount], 1, 2, userId, userId,
+                                   ORDER_QUANTITY, 100.0 + static_cast<double>(i % 50) * 0.01));
+        }
+
+        Portfolio portfolio(userId, 1e12);
+        Recorder recorder(ops);
+        for (size_t i = 0; i < ops; ++i) {
+            bool buyer = ((i / symbolCount) & 1) == 0;
+            recorder.measure([&] { portfolio.addTrade(trades[i], buyer); });
+        }
+        recorder.report("Portfolio::addTrade", 0, 0);
+    }
+
+    // Pre-trade check of a passing order across many accounts, released right after
+    void benchRiskCheck(size_t ops) {
+        const size_t userCount = 10000;
+        const size_t symbolCount = 32;
+        RiskLimits limits;
+        limits.maxOrderQuantity = 1000000;
+        limits.maxOrderNotional = 1e12;
+        limits.maxPosition = 1000000000;
+        limits.maxOpenNotional = 1e15;
+        limits.requireBuyingPower = true;
+        RiskGate gate(limits);
+        std::vector<UserId> users;
+        std::vector<SymbolId> symbols;
+        for (size_t i = 0; i < symbolCount; ++i) {
+            symbols.push_back(Registry::internSymbol("RISK" + std::to_string(i)));
+        }
+        for (size_t u = 0; u < userCount; ++u) {
+            users.push_back(Registry::internUser("risk-user-" + std::to_string(u)));
+            gate.setCash(users.back(), 1e12);
+            for (SymbolId symbol : symbols) {
+                gate.setPosition(users.back(), symbol, 0);
+            }
+        }
+
+        Random random(11);
+        Recorder recorder(ops);
+        for (size_t i = 0; i < ops; ++i) {
+            UserId user = users[random.below(userCount)];
+            SymbolId symbol = symbols[random.below(symbolCount)];
+            OrderSide side = sideFor(i);
+            double price = tickPrice(BID_TOP_TICK);
+            recorder.measure([&] { sizeSink = static_cast<size_t>(gate.checkOrder(user, symbol, side, ORDER_QUANTITY, price)); });
+            gate.releaseOpen(user, symbol, side, ORDER_QUANTITY, price);
+        }
+        recorder.report("RiskGate::checkOrder", 0, 0);
+    }
+
+    // Firm-wide revaluation of every account; ns/op is per account
+    void benchValuation(size_t ops, const std::string& filter) {
+        const size_t userCount = 50000;
+        const size_t symbolCount = 32;
+        const size_t rounds = std::min<size_t>(ops, 50);
+        std::vector<SymbolId> symbols;
+        for (size_t i = 0; i < symbolCount; ++i) {
+            symbols.push_back(Registry::internSymbol("VAL" + std::to_string(i)));
+        }
+        std::vector<double> prices(symbols.back() + 1, 0.0);
+        for (SymbolId symbol : symbols) {
+            prices[symbol] = 100.0;
+        }
+
+        Random random(42);
+        std::vector<Portfolio> portfolios;
+        portfolios.reserve(userCount);
+        ValuationEngine engine;
+        for (size_t u = 0; u < userCount; ++u) {
+            UserId user = Registry::internUser("val-user-" + std::to_string(u));
+            portfolios.emplace_back(user, 100000.0);
+            engine.setCash(user, 100000.0);
+            for (SymbolId symbol : symbols) {
+                Position held(symbol);
+                held.quantity = static_cast<int>(random.below(2001)) - 1000;
+                held.averageCost = 90.0 + static_cast<double>(random.below(2000)) * 0.01;
+                portfolios.back().restorePosition(held);
+                engine.setPosition(user, symbol, held.quantity, held.averageCost);
+            }
+        }
+        for (SymbolId symbol : symbols) {
+            engine.setPrice(symbol, prices[symbol]);
+        }
+        auto selected = [&](const char* name) {
+            return filter.empty() || std::string(name).find(filter) != std::string::npos;
+        };
+        int perRound = static_cast<int>(userCount);
+
+        if (selected("revalue/per-portfolio")) {
+            Recorder recorder(rounds);
+            double sink = 0.0;
+            for (size_t r = 0; r < rounds && !recorder.expired(); ++r) {
+                recorder.measure([&] {
+                    for (const Portfolio& portfolio : portfolios) {
+                        sink += portfolio.calculateUnrealizedPnL(prices) + portfolio.getTotalPortfolioValue(prices);
+                    }
+                }, perRound);
+            }
+            sizeSink = static_cast<size_t>(sink);
+            recorder.report("revalue/per-portfolio", 0, 0);
+        }
+        const size_t threadCounts[] = { 1, 4 };
+        for (size_t threads : threadCounts) {
+            std::string name = "revalue/soa-" + std::to_string(threads) + "thr";
+            if (!selected(name.c_str())) {
+                continue;
+            }
+            engine.setThreadCount(threads);
+            Recorder recorder(rounds);
+            for (size_t r = 0; r < rounds && !recorder.expired(); ++r) {
+                recorder.measure([&] { engine.revalue(); }, perRound);
+            }
+            recorder.report(name, 0, 0);
+        }
+        if (selected("revalue/one-price")) {
+            Recorder recorder(rounds);
+            for (size_t r = 0; r < rounds && !recorder.expired(); ++r) {
+                SymbolId symbol = symbols[r % symbolCount];
+                double price = 95.0 + static_cast<double>(r % 10);
+                recorder.measure([&] { engine.setPrice(symbol, price); }, perRound);
+            }
+            recorder.report("revalue/one-price", 0, 0);
+        }
+    }
+
+    // Call auction with every order in a 100-level overlap, so most of the book crosses
+    void benchAuction(size_t ops, const std::string& filter) {
+        const int64_t levels = 100;
+        const size_t orderCounts[] = { 1000, 10000 };
+        const size_t rounds = std::min<size_t>(ops, 200);
+        SymbolId symbol = Registry::internSymbol("AUCTION");
+        UserId user = Registry::internUser("bench-auction");
+        auto fill = [&](OrderBook& book, size_t orders) {
+            Random random(7);
+            book.setInCall(true);
+            for (size_t i = 0; i < orders; ++i) {
+                int64_t tick = BID_TOP_TICK - levels / 2 + static_cast<int64_t>(random.below(levels));
+                int quantity = 1 + static_cast<int>(random.below(500));
+                Order* order = book.createOrder(sideFor(i), quantity, tickPrice(tick), user);
+                MatchingEngine::matchOrder(book, order, fillSink);
+            }
+        };
+        auto selected = [&](const char* name) {
+            return filter.empty() || std::string(name).find(filter) != std::string::npos;
+        };
+
+        for (size_t orders : orderCounts) {
+            size_t perLevel = orders / static_cast<size_t>(levels);
+            if (selected("auction/indicative")) {
+                OrderBook book(symbol, 0.01, orders + 1024);
+                fill(book, orders);
+                AuctionIndicative indicative;
+                Recorder recorder(rounds);
+                for (size_t r = 0; r < rounds && !recorder.expired(); ++r) {
+                    recorder.measure([&] { MatchingEngine::findEquilibrium(book, indicative); });
+                }
+                sizeSink = static_cast<size_t>(indicative.volume);
+                recorder.report("auction/indicative", orders, perLevel);
+            }
+            if (selected("auction/uncross")) {
+                Recorder recorder(rounds);
+                for (size_t r = 0; r < rounds && !recorder.expired(); ++r) {
+                    OrderBook book(symbol, 0.01, orders + 1024);
+                    fill(book, orders);
+                    AuctionIndicative result;
+                    recorder.measure([&] { MatchingEngine::uncross(book, fillSink, result); });
+                }
+                recorder.report("auction/uncross", orders, perLevel);
+            }
+        }
+    }
+
+    typedef void (*BookBenchmark)(Fixture&, const Config&, Recorder&);
+
+    struct NamedBenchmark {
+        const char* name;
+        BookBenchmark run;
+    };
+
+    const NamedBenchmark BOOK_BENCHMARKS[] = {
+        { "addOrder", benchAddOrder },
+        { "cancelOrder", benchCancelOrder },
+        { "modifyOrder/size-down", benchModifySizeDown },
+        { "modifyOrder/reprice", benchModifyReprice },
+        { "bestBid+spread", benchBestAndSpread },
+        { "getTotalOrderCount", benchTotalOrderCount },
+        { "getDepth/top5", benchDepthTop5 },
+        { "matchOrder/passive", benchMatchPassive },
+        { "matchOrder/single-fill", benchMatchSingleFill },
+        { "matchOrder/sweep", benchMatchSweep },
+    };
+
+    void printUsage(const char* programName) {
+        std::cout << "Usage: " << programName << " [--ops N] [--max-depth N] [--filter TEXT]" << std::endl;
+        std::cout << "  --ops N          Timed operations per benchmark (default 100000)" << std::endl;
+        std::cout << "  --max-depth N    Largest resting book depth to run (default 1000000)" << std::endl;
+        std::cout << "  --filter TEXT    Only run benchmarks whose name contains TEXT" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t ops = 100000;
+    size_t maxDepth = 1000000;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc) {
+            ops = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--max-depth" && i + 1 < argc) {
+            maxDepth = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (ops == 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const size_t depths[] = { 10, 100, 1000, 10000, 100000, 1000000 };
+    const size_t perLevels[] = { 1, 10, 100 };
+    SymbolId symbol = Registry::internSymbol("BENCH");
+    UserId user = Registry::internUser("bench");
+
+    std::cout << "Latencies in ns per operation; depth = resting orders, per-lvl = orders per price level" << std::endl;
+    std::cout << std::left << std::setw(24) << "benchmark" << std::right
+              << std::setw(9) << "depth" << std::setw(8) << "per-lvl"
+              << std::setw(12) << "ns/op" << std::setw(11) << "allocs/op"
+              << std::setw(11) << "p50" << std::setw(11) << "p90" << std::setw(11) << "p99"
+              << std::setw(11) << "p99.9" << std::setw(11) << "max" << std::endl;
+
+    for (const auto& benchmark : BOOK_BENCHMARKS) {
+        if (!filter.empty() && std::string(benchmark.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        for (size_t depth : depths) {
+            if (depth > maxDepth) {
+                continue;
+            }
+            for (size_t perLevel : perLevels) {
+                if (perLevel * 2 > depth) {
+                    continue;
+                }
+                Config config = { depth, perLevel, ops };
+                Fixture fixture(symbol, user, depth, perLevel);
+                Recorder recorder(ops);
+                benchmark.run(fixture, config, recorder);
+                recorder.report(benchmark.name, depth, perLevel);
+            }
+        }
+    }
+
+    if (filter.empty() || std::string("Portfolio::addTrade").find(filter) != std::string::npos) {
+        benchPortfolioAddTrade(ops);
+    }
+    if (filter.empty() || std::string("RiskGate::checkOrder").find(filter) != std::string::npos) {
+        benchRiskCheck(ops);
+    }
+    benchValuation(ops, filter);
+    benchAuction(ops, filter);
+    return 0;
+}
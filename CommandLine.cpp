@@ -0,0 +1,217 @@
+#include "CommandLine.h"
+#include <cstdlib>
+#include <iostream>
+
+// Parse command line arguments
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--interactive") {
+            options.mode = RunMode::INTERACTIVE;
+        } else if (arg == "--batch") {
+            if (i + 1 >= argc) {
+                std::cerr << "--batch requires a file name (or - for stdin)" << std::endl;
+                return false;
+            }
+            options.mode = RunMode::BATCH;
+            options.inputPath = argv[++i];
+        } else if (arg == "--generate") {
+            if (i + 1 >= argc || !LoadGenerator::parseProfile(argv[i + 1], options.load)) {
+                std::cerr << "--generate requires a profile like count=N,seconds=X,rate=R,users=N,mix=P/A/C,"
+                          << "skew=X,walk=P,levels=N,qty=N,seed=N,sample=X" << std::endl;
+                return false;
+            }
+            options.mode = RunMode::GENERATE;
+            ++i;
+        } else if (arg == "--replay") {
+            if (i + 1 >= argc) {
+                std::cerr << "--replay requires an order log file" << std::endl;
+                return false;
+            }
+            options.mode = RunMode::REPLAY;
+            options.inputPath = argv[++i];
+        } else if (arg == "--timed") {
+            options.timed = true;
+        } else if (arg == "--convert-log") {
+            if (i + 2 >= argc) {
+                std::cerr << "--convert-log requires an input batch file and an output log file" << std::endl;
+                return false;
+            }
+            options.mode = RunMode::CONVERT_LOG;
+            options.inputPath = argv[++i];
+            options.outputPath = argv[++i];
+        } else if (arg == "--shards") {
+            if (i + 1 >= argc) {
+                std::cerr << "--shards requires a count" << std::endl;
+                return false;
+            }
+            options.shards = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--latency-report") {
+            if (i + 1 >= argc) {
+                std::cerr << "--latency-report requires a file name" << std::endl;
+                return false;
+            }
+            options.latencyReportPath = argv[++i];
+        } else if (arg == "--market-data") {
+            if (i + 1 >= argc) {
+                std::cerr << "--market-data requires a file name" << std::endl;
+                return false;
+            }
+            options.marketDataPath = argv[++i];
+        } else if (arg == "--snapshot-interval") {
+            if (i + 1 >= argc) {
+                std::cerr << "--snapshot-interval requires a count" << std::endl;
+                return false;
+            }
+            options.snapshotInterval = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--valuation") {
+            if (i + 1 >= argc || std::strtoul(argv[i + 1], nullptr, 10) == 0) {
+                std::cerr << "--valuation requires a thread count of at least 1" << std::endl;
+                return false;
+            }
+            options.valuationThreads = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--risk") {
+            if (i + 1 >= argc || !RiskGate::parseLimits(argv[i + 1], options.riskLimits)) {
+                std::cerr << "--risk requires limits like qty=N,notional=X,position=N,open=X,cash" << std::endl;
+                return false;
+            }
+            options.riskChecks = true;
+            ++i;
+        } else if (arg == "--settlement-thread") {
+            options.settlementThread = true;
+        } else if (arg == "--journal") {
+            if (i + 1 >= argc) {
+                std::cerr << "--journal requires a file name" << std::endl;
+                return false;
+            }
+            options.journalPath = argv[++i];
+        } else if (arg == "--journal-sync") {
+            if (i + 1 >= argc || !Journal::parseSync(argv[i + 1], options.journal.sync)) {
+                std::cerr << "--journal-sync requires one of none, batched, per-event" << std::endl;
+                return false;
+            }
+            ++i;
+        } else if (arg == "--group-commit-us") {
+            if (i + 1 >= argc) {
+                std::cerr << "--group-commit-us requires a number of microseconds" << std::endl;
+                return false;
+            }
+            options.journal.groupCommitMicros = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--snapshot") {
+            if (i + 1 >= argc) {
+                std::cerr << "--snapshot requires a file name" << std::endl;
+                return false;
+            }
+            options.snapshotPath = argv[++i];
+        } else if (arg == "--snapshot-every") {
+            if (i + 1 >= argc) {
+                std::cerr << "--snapshot-every requires a count" << std::endl;
+                return false;
+            }
+            options.snapshotEvery = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--log-level") {
+            if (i + 1 >= argc || !AsyncLogger::parseLevel(argv[i + 1], options.logging.level)) {
+                std::cerr << "--log-level requires one of debug, info, warn, error, off" << std::endl;
+                return false;
+            }
+            ++i;
+        } else if (arg == "--log-file") {
+            if (i + 1 >= argc) {
+                std::cerr << "--log-file requires a file name" << std::endl;
+                return false;
+            }
+            options.logging.path = argv[++i];
+        } else if (arg == "--log-overflow") {
+            std::string policy = (i + 1 < argc) ? argv[++i] : "";
+            if (policy == "drop") {
+                options.logging.overflow = LogOverflow::DROP;
+            } else if (policy == "block") {
+                options.logging.overflow = LogOverflow::BLOCK;
+            } else {
+                std::cerr << "--log-overflow requires drop or block" << std::endl;
+                return false;
+            }
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.mode == RunMode::GENERATE && options.shards > 0) {
+        std::cerr << "--generate needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (!options.marketDataPath.empty() && options.shards > 0) {
+        std::cerr << "--market-data needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (!options.journalPath.empty() && options.shards > 0) {
+        std::cerr << "--journal needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (!options.snapshotPath.empty() && options.shards > 0) {
+        std::cerr << "--snapshot needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (options.valuationThreads > 0 && options.shards > 0) {
+        std::cerr << "--valuation needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (options.riskChecks && options.shards > 0) {
+        std::cerr << "--risk needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (options.settlementThread && options.shards > 0) {
+        std::cerr << "--settlement-thread needs inline matching and cannot be combined with --shards" << std::endl;
+        return false;
+    }
+    if (options.snapshotEvery > 0 && options.snapshotPath.empty()) {
+        std::cerr << "--snapshot-every requires --snapshot" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Print usage help
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]" << std::endl;
+    std::cout << "  --interactive      Menu-driven session on stdin (default)" << std::endl;
+    std::cout << "  --batch FILE       Run order commands from FILE (- for stdin) and report throughput" << std::endl;
+    std::cout << "  --generate PROFILE Run seeded synthetic order flow and report throughput, latency, depth and RSS;" << std::endl;
+    std::cout << "                     any of count=N, seconds=X, rate=R (Poisson msgs/s, 0 = flat out), users=N," << std::endl;
+    std::cout << "                     mix=P/A/C (passive/aggressive/cancel), skew=X (Zipf), walk=P, levels=N," << std::endl;
+    std::cout << "                     qty=N, seed=N, sample=X (seconds between samples)" << std::endl;
+    std::cout << "  --shards N         Batch mode: match on N ShardedEngine threads instead of inline" << std::endl;
+    std::cout << "  --verbose          Batch and generate modes: keep the per-order console output" << std::endl;
+    std::cout << "  --latency-report FILE  Write per-stage order latency histograms to FILE on exit" << std::endl;
+    std::cout << "  --market-data FILE Write the binary L2 market data stream to FILE" << std::endl;
+    std::cout << "  --snapshot-interval N  Market data: full book snapshot every N updates per symbol (default "
+              << MarketDataPublisher::DEFAULT_SNAPSHOT_INTERVAL << ", 0 = never)" << std::endl;
+    std::cout << "  --valuation N      Mark every account to market continuously; full revaluations use N threads" << std::endl;
+    std::cout << "  --risk LIMITS      Pre-trade checks; any of qty=N (order size), notional=X (order value)," << std::endl;
+    std::cout << "                     position=N (per symbol, with resting orders), open=X (resting value), cash" << std::endl;
+    std::cout << "                     (buys need the cash for themselves and the resting buys)" << std::endl;
+    std::cout << "  --settlement-thread  Apply fills to portfolios and statistics on a pipeline thread" << std::endl;
+    std::cout << "  --journal FILE     Recover state from the write-ahead journal FILE, then append to it" << std::endl;
+    std::cout << "  --journal-sync P   Journal durability: none, batched (default, group commit) or per-event" << std::endl;
+    std::cout << "  --group-commit-us N  Journal: longest a batched record waits for its sync (default 1000)" << std::endl;
+    std::cout << "  --snapshot FILE    Load system state from FILE at startup (if present) and save it on exit" << std::endl;
+    std::cout << "  --snapshot-every N Batch and generate modes: also snapshot in the background every N commands" << std::endl;
+    std::cout << "  --log-level LEVEL  Minimum log level: debug, info (default), warn, error, off" << std::endl;
+    std::cout << "  --log-file FILE    Append timestamped log records to FILE instead of the console" << std::endl;
+    std::cout << "  --log-overflow P   When a thread's log ring is full: block (default) or drop" << std::endl;
+    std::cout << "  --replay FILE      Replay a binary order log as fast as possible and print its digest" << std::endl;
+    std::cout << "  --timed            Replay mode: keep the captured spacing between events" << std::endl;
+    std::cout << "  --convert-log IN OUT  Convert batch file IN to binary order log OUT" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Batch command format (one per line, # starts a comment):" << std::endl;
+    std::cout << "  N <ref> <user> <symbol> <B|S> <quantity> <price> [LIMIT|MARKET|IOC|FOK]   new order" << std::endl;
+    std::cout << "  C <ref>                                            cancel order" << std::endl;
+    std::cout << "  M <ref> <quantity> <price>                         modify order" << std::endl;
+    std::cout << "  A <symbol>                                         open a call auction" << std::endl;
+    std::cout << "  U <symbol>                                         uncross the call auction" << std::endl;
+}
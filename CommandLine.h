@@ -0,0 +1,47 @@
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include "AsyncLogger.h"
+#include "Journal.h"
+#include "LoadGenerator.h"
+#include "MarketDataPublisher.h"
+#include "RiskGate.h"
+#include <cstddef>
+#include <string>
+
+enum class RunMode { INTERACTIVE, BATCH, GENERATE, REPLAY, CONVERT_LOG };
+
+// Options for the trading_system binary
+struct CommandLineOptions {
+    RunMode mode;
+    std::string inputPath;  // batch input ("-" = stdin) or order log to replay
+    std::string outputPath; // order log written by --convert-log
+    std::string latencyReportPath; // per-stage latency dump written on exit
+    std::string marketDataPath;    // binary L2 stream written while orders run
+    size_t snapshotInterval;       // market data updates per book between snapshots (0 = never)
+    std::string journalPath;       // write-ahead journal, recovered at startup
+    JournalOptions journal;        // journal sync policy and group commit window
+    std::string snapshotPath;      // state loaded at startup and saved on exit
+    size_t snapshotEvery;          // batch commands between background snapshots (0 = exit only)
+    size_t valuationThreads;       // firm-wide mark-to-market threads (0 = off)
+    bool settlementThread;         // settle fills on a pipeline thread instead of inline
+    bool riskChecks;               // pre-trade risk gate in front of matching
+    RiskLimits riskLimits;         // its limits
+    LoadProfile load;              // synthetic flow run by --generate
+    size_t shards;          // 0 = match inline through TradeBookingSystem
+    bool verbose;           // per-order console output in batch mode
+    bool timed;             // replay at the captured event spacing
+    LoggerOptions logging;  // async logger level, overflow policy and sink
+
+    CommandLineOptions()
+        : mode(RunMode::INTERACTIVE), snapshotInterval(MarketDataPublisher::DEFAULT_SNAPSHOT_INTERVAL),
+          snapshotEvery(0), valuationThreads(0), settlementThread(false), riskChecks(false), shards(0), verbose(false), timed(false) {}
+};
+
+// Parse argv into options; returns false (after printing why) on bad input
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options);
+
+// Print usage help
+void printUsage(const char* programName);
+
+#endif // COMMANDLINE_H
@@ -0,0 +1,63 @@
+#include "EngineClock.h"
+
+#ifdef ENGINE_CLOCK_HAS_TSC
+#include <cpuid.h>
+#endif
+
+namespace {
+    // Only trust the TSC when it ticks at a constant rate across P-states
+    bool detectInvariantTsc() {
+#ifdef ENGINE_CLOCK_HAS_TSC
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) && eax >= 0x80000007) {
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            return (edx & (1u << 8)) != 0;
+        }
+#endif
+        return false;
+    }
+
+    // Measure TSC ticks against steady_clock over a short spin
+    double calibrateNanosPerTick(bool tsc) {
+#ifdef ENGINE_CLOCK_HAS_TSC
+        if (tsc) {
+            auto wallStart = std::chrono::steady_clock::now();
+            uint64_t tickStart = __rdtsc();
+            auto wallEnd = wallStart;
+            while (wallEnd - wallStart < std::chrono::milliseconds(2)) {
+                wallEnd = std::chrono::steady_clock::now();
+            }
+            uint64_t tickEnd = __rdtsc();
+            double nanos = std::chrono::duration<double, std::nano>(wallEnd - wallStart).count();
+            if (tickEnd > tickStart) {
+                return nanos / static_cast<double>(tickEnd - tickStart);
+            }
+        }
+#else
+        (void)tsc;
+#endif
+        return 1.0;
+    }
+
+    // Pair a tick reading with the wall clock; the tighter of a few tries
+    EngineClock::WallAnchor anchorWallClock() {
+        EngineClock::WallAnchor best = { 0, 0 };
+        uint64_t bestSpread = UINT64_MAX;
+        for (int attempt = 0; attempt < 5; ++attempt) {
+            uint64_t before = EngineClock::now();
+            auto wall = std::chrono::system_clock::now();
+            uint64_t after = EngineClock::now();
+            if (after - before < bestSpread) {
+                bestSpread = after - before;
+                best.ticks = before + (after - before) / 2;
+                best.wallNanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    wall.time_since_epoch()).count());
+            }
+        }
+        return best;
+    }
+}
+
+const bool EngineClock::useTsc = detectInvariantTsc();
+const double EngineClock::nanosPerTick = calibrateNanosPerTick(EngineClock::useTsc);
+const EngineClock::WallAnchor EngineClock::wallAnchor = anchorWallClock();
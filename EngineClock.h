@@ -0,0 +1,67 @@
+#ifndef ENGINECLOCK_H
+#define ENGINECLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ENGINE_CLOCK_HAS_TSC 1
+#endif
+
+// Cheap monotonic clock for latency measurement and event timestamps.
+// On x86 with an invariant TSC, now() is a single rdtsc; elsewhere it falls
+// back to steady_clock. Raw ticks are converted to nanoseconds with a ratio
+// calibrated once against steady_clock. Wall time is that plus one
+// system_clock reading taken at calibration, so it never steps backwards
+// but drifts from NTP over very long runs; use it for stamps, not ordering.
+class EngineClock {
+public:
+    // Raw tick count
+    static uint64_t now() {
+#ifdef ENGINE_CLOCK_HAS_TSC
+        if (useTsc) {
+            return __rdtsc();
+        }
+#endif
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Tick-to-nanosecond conversion
+    static uint64_t toNanos(uint64_t ticks) {
+        return static_cast<uint64_t>(static_cast<double>(ticks) * nanosPerTick);
+    }
+    static uint64_t elapsedNanos(uint64_t startTicks, uint64_t endTicks) {
+        return endTicks > startTicks ? toNanos(endTicks - startTicks) : 0;
+    }
+
+    // Wall clock from ticks: nanoseconds since the epoch
+    static uint64_t toWallNanos(uint64_t ticks) {
+        double sinceAnchor = static_cast<double>(static_cast<int64_t>(ticks - wallAnchor.ticks)) * nanosPerTick;
+        return wallAnchor.wallNanos + static_cast<int64_t>(sinceAnchor);
+    }
+    static uint64_t wallNanos() { return toWallNanos(now()); }
+    static std::chrono::system_clock::time_point toWallTime(uint64_t ticks) {
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds(toWallNanos(ticks))));
+    }
+    static std::chrono::system_clock::time_point wallTime() { return toWallTime(now()); }
+
+    // Clock description
+    static bool usesTsc() { return useTsc; }
+    static double getNanosPerTick() { return nanosPerTick; }
+
+    // A tick count and the system_clock reading taken next to it
+    struct WallAnchor {
+        uint64_t ticks;
+        uint64_t wallNanos;
+    };
+
+private:
+    static const bool useTsc;
+    static const double nanosPerTick;
+    static const WallAnchor wallAnchor;
+};
+
+#endif // ENGINECLOCK_H
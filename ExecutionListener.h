@@ -0,0 +1,33 @@
+#ifndef EXECUTIONLISTENER_H
+#define EXECUTIONLISTENER_H
+
+#include "Trade.h"
+#include <cstddef>
+#include <vector>
+
+// Receives every fill from MatchingEngine synchronously, in execution order,
+// while the books are mid-match. Implementations must not touch the order
+// book being matched. A sweep of an incoming order hands its fills over in
+// batches through onFills.
+class ExecutionListener {
+public:
+    virtual ~ExecutionListener() = default;
+    virtual void onFill(const Fill& fill) = 0;
+    virtual void onFills(const Fill* fills, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            onFill(fills[i]);
+        }
+    }
+};
+
+// Collects fills as Trade objects (backs the vector-returning MatchingEngine API)
+class TradeCollector : public ExecutionListener {
+public:
+    explicit TradeCollector(std::vector<Trade>& trades) : trades(trades) {}
+    void onFill(const Fill& fill) override { trades.push_back(Trade(fill)); }
+
+private:
+    std::vector<Trade>& trades;
+};
+
+#endif // EXECUTIONLISTENER_H
@@ -0,0 +1,798 @@
+#include "Journal.h"
+#include "AsyncLogger.h"
+#include "EngineClock.h"
+#include "TradeBookingSystem.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const size_t WRITE_BATCH = 1024;    // records per write() call
+
+    // Grow an id translation table on demand
+    template <typename Id>
+    void mapId(std::vector<Id>& table, uint32_t journaled, Id current) {
+        if (journaled >= table.size()) {
+            table.resize(static_cast<size_t>(journaled) + 1, Id(Registry::INVALID_ID));
+        }
+        table[journaled] = current;
+    }
+
+    // Records that may sit between an order and its fills
+    bool isNameRecord(uint8_t type) {
+        return type == JournalRecord::USER_NAME || type == JournalRecord::NAME_PART;
+    }
+
+    template <typename Id>
+    Id lookupId(const std::vector<Id>& table, uint32_t journaled) {
+        return journaled < table.size() ? table[journaled] : Id(Registry::INVALID_ID);
+    }
+}
+
+// NAME records: name bytes overlay price and the order id after it
+void JournalRecord::setName(const std::string& name, size_t offset) {
+    char bytes[JOURNAL_NAME_SIZE] = {};
+    if (offset < name.size()) {
+        std::memcpy(bytes, name.data() + offset, std::min(name.size() - offset, JOURNAL_NAME_SIZE));
+    }
+    quantity = static_cast<int32_t>(offset);
+    std::memcpy(reinterpret_cast<char*>(this) + offsetof(JournalRecord, price), bytes, sizeof(bytes));
+}
+
+std::string JournalRecord::getName() const {
+    const char* bytes = reinterpret_cast<const char*>(this) + offsetof(JournalRecord, price);
+    size_t length = 0;
+    while (length < JOURNAL_NAME_SIZE && bytes[length] != '\0') ++length;
+    return std::string(bytes, length);
+}
+
+// FNV-1a style hash over the 64-bit words before the checksum field, folded to 32 bits
+uint32_t JournalRecord::computeChecksum() const {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(this);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t offset = 0; offset < offsetof(JournalRecord, checksum); offset += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + offset, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+// ---- JournalReader ----
+
+JournalReader::JournalReader() : mapping(nullptr), mappingSize(0), records(nullptr), recordCount(0) {
+}
+
+JournalReader::~JournalReader() {
+    close();
+}
+
+// Map a journal and find where its valid records end
+bool JournalReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open journal: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(JournalFileHeader)) {
+        std::cerr << "Journal is truncated: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    mappingSize = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Cannot map journal: " << path << std::endl;
+        mapping = nullptr;
+        mappingSize = 0;
+        return false;
+    }
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    const char* base = static_cast<const char*>(mapping);
+    const JournalFileHeader* header = reinterpret_cast<const JournalFileHeader*>(base);
+    if (std::memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0
+            || header->version != JOURNAL_VERSION
+            || header->recordSize != sizeof(JournalRecord)) {
+        std::cerr << "Not a valid journal: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    // The valid prefix ends at the first partial, corrupt or out-of-sequence record
+    records = reinterpret_cast<const JournalRecord*>(base + sizeof(JournalFileHeader));
+    size_t available = (mappingSize - sizeof(JournalFileHeader)) / sizeof(JournalRecord);
+    while (recordCount < available) {
+        const JournalRecord& record = records[recordCount];
+        if (record.checksum != record.computeChecksum() || record.sequence != recordCount + 1) {
+            break;
+        }
+        ++recordCount;
+    }
+    return true;
+}
+
+void JournalReader::close() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    records = nullptr;
+    recordCount = 0;
+}
+
+// ---- Journal ----
+
+Journal::Journal()
+    : fd(-1), running(false), failed(false), sequence(0), recordCount(0), eventAlreadyJournaled(false),
+      durableSequence(0), syncCount(0) {
+}
+
+Journal::~Journal() {
+    close();
+}
+
+// Open for append after the last valid record
+bool Journal::open(const std::string& path, const JournalOptions& journalOptions) {
+    return openAt(path, journalOptions, std::numeric_limits<size_t>::max());
+}
+
+// Open for append after at most keepRecords valid records, cutting off the rest
+// (including any torn tail)
+bool Journal::openAt(const std::string& path, const JournalOptions& journalOptions, size_t keepRecords) {
+    close();
+
+    uint64_t lastSequence = 0;
+    size_t validBytes = 0;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && info.st_size > 0) {
+        JournalReader reader;
+        if (!reader.open(path)) {
+            return false;
+        }
+        size_t kept = std::min(keepRecords, reader.getRecordCount());
+        lastSequence = kept;
+        validBytes = sizeof(JournalFileHeader) + kept * sizeof(JournalRecord);
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Cannot open journal for writing: " << path << std::endl;
+        return false;
+    }
+    bool ready = ftruncate(fd, static_cast<off_t>(validBytes)) == 0
+                 && lseek(fd, 0, SEEK_END) == static_cast<off_t>(validBytes);
+    if (ready && validBytes == 0) {
+        JournalFileHeader header = {};
+        std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.recordSize = sizeof(JournalRecord);
+        ready = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+    }
+    if (!ready || fdatasync(fd) != 0) {
+        std::cerr << "Cannot prepare journal: " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    options = journalOptions;
+    ring.reset(new SpscRing<JournalRecord>(options.ringCapacity));
+    sequence = lastSequence;
+    recordCount = 0;
+    symbolNamed.clear();
+    userNamed.clear();
+    durableSequence.store(lastSequence, std::memory_order_relaxed);
+    syncCount.store(0, std::memory_order_relaxed);
+    failed.store(false, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+    writer = std::thread(&Journal::writerLoop, this);
+    return true;
+}
+
+// Stop the writer once it has drained and synced the ring
+void Journal::close() {
+    if (fd < 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.store(false, std::memory_order_release);
+    }
+    wake.notify_one();
+    writer.join();
+    ::close(fd);
+    fd = -1;
+    ring.reset();
+}
+
+// Event records
+void Journal::logAccount(UserId user) {
+    nameUser(user);
+    JournalRecord record = makeRecord(JournalRecord::ACCOUNT_OPENED);
+    record.userId = user;
+    append(record);
+}
+
+void Journal::logNewOrder(const Order& order) {
+    if (eventAlreadyJournaled) {
+        eventAlreadyJournaled = false;
+        return;
+    }
+    nameSymbol(order.symbolId);
+    nameUser(order.userId);
+    JournalRecord record = makeRecord(JournalRecord::NEW_ORDER);
+    record.orderId = order.orderId;
+    record.symbolId = order.symbolId;
+    record.userId = order.userId;
+    record.side = order.side == OrderSide::BUY ? 0 : 1;
+    record.orderType = getOrderTypeCode(order.type);
+    record.quantity = order.quantity;
+    record.price = order.price;
+    append(record);
+}
+
+void Journal::logCancel(SymbolId symbol, OrderId orderId) {
+    nameSymbol(symbol);
+    JournalRecord record = makeRecord(JournalRecord::CANCEL_ORDER);
+    record.orderId = orderId;
+    record.symbolId = symbol;
+    append(record);
+}
+
+void Journal::logModify(SymbolId symbol, OrderId orderId, int quantity, double price) {
+    if (eventAlreadyJournaled) {
+        eventAlreadyJournaled = false;
+        return;
+    }
+    nameSymbol(symbol);
+    JournalRecord record = makeRecord(JournalRecord::MODIFY_ORDER);
+    record.orderId = orderId;
+    record.symbolId = symbol;
+    record.quantity = quantity;
+    record.price = price;
+    append(record);
+}
+
+void Journal::logFill(const Fill& fill) {
+    // Users are named here too: a resting order may have been journaled by an earlier session
+    nameUser(fill.buyUserId);
+    nameUser(fill.sellUserId);
+    JournalRecord record = makeRecord(JournalRecord::FILL);
+    record.tradeId = fill.tradeId;
+    record.symbolId = fill.symbolId;
+    record.orderId = fill.buyOrderId;
+    record.otherOrderId = fill.sellOrderId;
+    record.userId = fill.buyUserId;
+    record.otherUserId = fill.sellUserId;
+    record.quantity = fill.quantity;
+    record.price = fill.price;
+    append(record);
+}
+
+void Journal::logBookCleared(SymbolId symbol) {
+    nameSymbol(symbol);
+    JournalRecord record = makeRecord(JournalRecord::BOOK_CLEARED);
+    record.symbolId = symbol;
+    append(record);
+}
+
+void Journal::logReset() {
+    JournalRecord record = makeRecord(JournalRecord::SYSTEM_RESET);
+    append(record);
+}
+
+void Journal::logCallOpened(SymbolId symbol) {
+    nameSymbol(symbol);
+    JournalRecord record = makeRecord(JournalRecord::CALL_OPENED);
+    record.symbolId = symbol;
+    append(record);
+}
+
+void Journal::logUncross(SymbolId symbol) {
+    if (eventAlreadyJournaled) {
+        eventAlreadyJournaled = false;
+        return;
+    }
+    nameSymbol(symbol);
+    JournalRecord record = makeRecord(JournalRecord::CALL_UNCROSSED);
+    record.symbolId = symbol;
+    append(record);
+}
+
+// Close one event group
+void Journal::commit() {
+    if (options.sync == JournalSync::PER_EVENT && fd >= 0) {
+        waitDurable(sequence);
+    }
+}
+
+void Journal::sync() {
+    if (fd >= 0) {
+        waitDurable(sequence);
+    }
+}
+
+JournalRecord Journal::makeRecord(JournalRecord::Type type) {
+    JournalRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.symbolId = Registry::INVALID_ID;
+    record.userId = Registry::INVALID_ID;
+    record.otherUserId = Registry::INVALID_ID;
+    return record;
+}
+
+// Number, stamp and hand a record to the writer; blocks rather than drop when the ring is full
+void Journal::append(JournalRecord& record) {
+    if (fd < 0) {
+        return;
+    }
+    record.sequence = ++sequence;
+    record.timestampNs = EngineClock::wallNanos();
+    record.checksum = record.computeChecksum();
+    while (!ring->tryPush(record)) {
+        wake.notify_one();
+        std::this_thread::yield();
+    }
+    ++recordCount;
+}
+
+// Ids are process-local, so each session names an id before its first use
+void Journal::nameSymbol(SymbolId symbol) {
+    if (symbol == Registry::INVALID_ID || (symbol < symbolNamed.size() && symbolNamed[symbol])) {
+        return;
+    }
+    if (symbol >= symbolNamed.size()) {
+        symbolNamed.resize(static_cast<size_t>(symbol) + 1, 0);
+    }
+    symbolNamed[symbol] = 1;
+    JournalRecord record = makeRecord(JournalRecord::SYMBOL_NAME);
+    record.symbolId = symbol;
+    appendName(record, Registry::symbolName(symbol));
+}
+
+void Journal::nameUser(UserId user) {
+    if (user == Registry::INVALID_ID || (user < userNamed.size() && userNamed[user])) {
+        return;
+    }
+    if (user >= userNamed.size()) {
+        userNamed.resize(static_cast<size_t>(user) + 1, 0);
+    }
+    userNamed[user] = 1;
+    JournalRecord record = makeRecord(JournalRecord::USER_NAME);
+    record.userId = user;
+    appendName(record, Registry::userName(user));
+}
+
+// Names longer than one record go out as NAME_PART pieces ahead of the name record
+void Journal::appendName(JournalRecord& record, const std::string& name) {
+    size_t last = name.empty() ? 0 : (name.size() - 1) / JOURNAL_NAME_SIZE * JOURNAL_NAME_SIZE;
+    for (size_t offset = 0; offset < last; offset += JOURNAL_NAME_SIZE) {
+        JournalRecord part = makeRecord(JournalRecord::NAME_PART);
+        part.setName(name, offset);
+        append(part);
+    }
+    record.setName(name, last);
+    append(record);
+}
+
+void Journal::waitDurable(uint64_t target) {
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.notify_one();
+    durable.wait(lock, [&] {
+        return durableSequence.load(std::memory_order_acquire) >= target || failed.load(std::memory_order_relaxed);
+    });
+}
+
+// Writer thread: drain the ring in batches, then one sync covers everything written
+void Journal::writerLoop() {
+    std::vector<JournalRecord> batch;
+    batch.reserve(WRITE_BATCH);
+    uint64_t written = durableSequence.load(std::memory_order_relaxed);
+    auto window = std::chrono::microseconds(std::max(1u, options.groupCommitMicros));
+    auto lastSync = std::chrono::steady_clock::now();
+
+    for (;;) {
+        bool stopping = !running.load(std::memory_order_acquire);
+        JournalRecord record;
+        while (batch.size() < WRITE_BATCH && ring->tryPop(record)) {
+            batch.push_back(record);
+        }
+        bool idle = batch.size() < WRITE_BATCH;
+        if (!batch.empty()) {
+            if (writeBatch(batch)) {
+                written = batch.back().sequence;
+            }
+            batch.clear();
+        }
+
+        // Sync when caught up, or at least once per window under sustained load
+        auto now = std::chrono::steady_clock::now();
+        if (written > durableSequence.load(std::memory_order_relaxed) && (idle || now - lastSync >= window)) {
+            if (options.sync != JournalSync::NONE && !failed.load(std::memory_order_relaxed)) {
+                if (fdatasync(fd) != 0) {
+                    std::cerr << "Journal sync failed: " << std::strerror(errno) << std::endl;
+                    failed.store(true, std::memory_order_relaxed);
+                }
+                syncCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            lastSync = now;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                durableSequence.store(written, std::memory_order_release);
+            }
+            durable.notify_all();
+        }
+        if (!idle) {
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        if (running.load(std::memory_order_acquire)) {
+            wake.wait_for(lock, window);
+        }
+    }
+    // Wake any waiter left behind by a failure
+    durable.notify_all();
+}
+
+// Write a batch fully; after a failure records are discarded and waiters released
+bool Journal::writeBatch(const std::vector<JournalRecord>& batch) {
+    if (failed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(batch.data());
+    size_t remaining = batch.size() * sizeof(JournalRecord);
+    while (remaining > 0) {
+        ssize_t count = ::write(fd, data, remaining);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Journal write failed: " << std::strerror(errno) << std::endl;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed.store(true, std::memory_order_relaxed);
+            }
+            durable.notify_all();
+            return false;
+        }
+        data += count;
+        remaining -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+// ---- Recovery ----
+
+namespace {
+    // Applies journal records to a system, translating journaled ids to this process's
+    class JournalReplay {
+    public:
+        JournalReplay(const JournalReader& journalReader, TradeBookingSystem& tradingSystem,
+                      JournalRecoveryResult& recoveryResult)
+            : reader(journalReader), system(tradingSystem), result(recoveryResult), maxOrderId(0), maxTradeId(0) {
+        }
+
+        // Index of a trailing order, modify or uncross whose fills may not all have
+        // reached the disk (the record count when the journal ends with any other event)
+        size_t findOpenOrder() const {
+            for (size_t i = reader.getRecordCount(); i > 0; --i) {
+                uint8_t type = reader.getRecord(i - 1).type;
+                if (type == JournalRecord::NEW_ORDER || type == JournalRecord::MODIFY_ORDER
+                    || type == JournalRecord::CALL_UNCROSSED) {
+                    return i - 1;
+                }
+                if (type != JournalRecord::FILL && !isNameRecord(type)) {
+                    break;
+                }
+            }
+            return reader.getRecordCount();
+        }
+
+        // The fills journaled after an order are the ones it produced
+        // (name records for resting orders' owners may sit between them)
+        size_t countFills(size_t index, int& firstTradeId) const {
+            size_t fills = 0;
+            for (size_t next = index + 1; next < reader.getRecordCount(); ++next) {
+                const JournalRecord& following = reader.getRecord(next);
+                if (following.type == JournalRecord::FILL) {
+                    if (fills++ == 0) {
+                        firstTradeId = following.tradeId;
+                    }
+                } else if (!isNameRecord(following.type)) {
+                    break;
+                }
+            }
+            return fills;
+        }
+
+        // Place a journaled order again under its original order and trade ids
+        // (firstTradeId 0 = it filled nothing); returns the number of fills it produced
+        size_t placeOrder(const JournalRecord& record, int firstTradeId) {
+            if (firstTradeId > 0) {
+                Trade::advanceNextTradeId(firstTradeId);
+            }
+            maxOrderId = std::max(maxOrderId, record.orderId);
+            UserId user = lookupId(users, record.userId);
+            SymbolId symbol = lookupId(symbols, record.symbolId);
+            if (user == Registry::INVALID_ID || symbol == Registry::INVALID_ID) {
+                return 0;
+            }
+            size_t tradesBefore = system.getTotalTradesExecuted();
+            system.placeOrderDirect(user, symbol, record.side == 0 ? OrderSide::BUY : OrderSide::SELL,
+                                    record.quantity, record.price, getOrderTypeFromCode(record.orderType), record.orderId);
+            return system.getTotalTradesExecuted() - tradesBefore;
+        }
+
+        // Uncross a journaled auction again under its original trade ids
+        size_t uncross(const JournalRecord& record, int firstTradeId) {
+            if (firstTradeId > 0) {
+                Trade::advanceNextTradeId(firstTradeId);
+            }
+            SymbolId symbol = lookupId(symbols, record.symbolId);
+            return symbol != Registry::INVALID_ID ? system.uncrossAuction(symbol) : 0;
+        }
+
+        // Modify a journaled order again under its original trade ids
+        size_t modifyOrder(const JournalRecord& record, int firstTradeId) {
+            if (firstTradeId > 0) {
+                Trade::advanceNextTradeId(firstTradeId);
+            }
+            SymbolId symbol = lookupId(symbols, record.symbolId);
+            if (symbol == Registry::INVALID_ID) {
+                return 0;
+            }
+            size_t tradesBefore = system.getTotalTradesExecuted();
+            system.modifyOrderDirect(symbol, record.orderId, record.quantity, record.price);
+            return system.getTotalTradesExecuted() - tradesBefore;
+        }
+
+        // Re-run an event that can fill: a new order, a modify or an uncross
+        size_t rematch(const JournalRecord& record, int firstTradeId) {
+            switch (record.type) {
+                case JournalRecord::CALL_UNCROSSED:
+                    return uncross(record, firstTradeId);
+                case JournalRecord::MODIFY_ORDER:
+                    return modifyOrder(record, firstTradeId);
+                default:
+                    return placeOrder(record, firstTradeId);
+            }
+        }
+
+        // Count a re-run event by kind
+        void countEvent(const JournalRecord& record) {
+            result.orders += record.type == JournalRecord::NEW_ORDER ? 1 : 0;
+            result.modifies += record.type == JournalRecord::MODIFY_ORDER ? 1 : 0;
+        }
+
+        void apply(size_t index) {
+            const JournalRecord& record = reader.getRecord(index);
+            switch (record.type) {
+                case JournalRecord::NAME_PART:
+                    if (record.quantity == 0) {
+                        pendingName.clear();
+                    }
+                    if (static_cast<size_t>(record.quantity) == pendingName.size()) {
+                        pendingName += record.getName();
+                    }
+                    break;
+                case JournalRecord::SYMBOL_NAME:
+                    mapId(symbols, record.symbolId, Registry::internSymbol(fullName(record)));
+                    break;
+                case JournalRecord::USER_NAME:
+                    mapId(users, record.userId, Registry::internUser(fullName(record)));
+                    break;
+                case JournalRecord::ACCOUNT_OPENED: {
+                    UserId user = lookupId(users, record.userId);
+                    if (user != Registry::INVALID_ID) {
+                        system.createUserIfNotExists(Registry::userName(user));
+                    }
+                    break;
+                }
+                case JournalRecord::NEW_ORDER:
+                case JournalRecord::MODIFY_ORDER:
+                case JournalRecord::CALL_UNCROSSED: {
+                    int firstTradeId = 0;
+                    size_t expectedFills = countFills(index, firstTradeId);
+                    size_t replayed = rematch(record, firstTradeId);
+                    result.replayedFills += replayed;
+                    if (replayed != expectedFills) {
+                        ++result.mismatchedOrders;
+                    }
+                    countEvent(record);
+                    break;
+                }
+                case JournalRecord::CANCEL_ORDER: {
+                    SymbolId symbol = lookupId(symbols, record.symbolId);
+                    if (symbol != Registry::INVALID_ID) {
+                        system.cancelOrderDirect(symbol, record.orderId);
+                    }
+                    ++result.cancels;
+                    break;
+                }
+                case JournalRecord::FILL:
+                    maxTradeId = std::max(maxTradeId, record.tradeId);
+                    ++result.fills;
+                    break;
+                case JournalRecord::BOOK_CLEARED: {
+                    SymbolId symbol = lookupId(symbols, record.symbolId);
+                    if (symbol != Registry::INVALID_ID) {
+                        system.clearOrdersForSymbol(Registry::symbolName(symbol));
+                    }
+                    break;
+                }
+                case JournalRecord::SYSTEM_RESET:
+                    system.resetSystem();
+                    break;
+                case JournalRecord::CALL_OPENED: {
+                    SymbolId symbol = lookupId(symbols, record.symbolId);
+                    if (symbol != Registry::INVALID_ID) {
+                        system.openCallAuction(symbol);
+                    }
+                    break;
+                }
+            }
+        }
+
+        OrderId getMaxOrderId() const { return maxOrderId; }
+        int getMaxTradeId() const { return maxTradeId; }
+
+    private:
+        const JournalReader& reader;
+        TradeBookingSystem& system;
+        JournalRecoveryResult& result;
+        std::vector<SymbolId> symbols;  // journaled id -> this process's id
+        std::vector<UserId> users;
+        OrderId maxOrderId;
+        int maxTradeId;
+        std::string pendingName;        // NAME_PART pieces of the next name record
+
+        // A name record's piece joined to the NAME_PART pieces before it
+        std::string fullName(const JournalRecord& record) {
+            std::string name = (record.quantity > 0 && static_cast<size_t>(record.quantity) == pendingName.size())
+                                   ? pendingName + record.getName() : record.getName();
+            pendingName.clear();
+            return name;
+        }
+    };
+}
+
+// Replay the journal through the system as if every event had just arrived.
+// A trailing order's (or uncross's) fills are cut from the file and the event
+// runs again once the journal is attached, so its fills are journaled in full
+// even if the crash lost some.
+bool Journal::recover(const std::string& path, const JournalOptions& journalOptions,
+                      TradeBookingSystem& system, JournalRecoveryResult& result, uint64_t snapshotSequence) {
+    result = JournalRecoveryResult();
+    uint64_t start = EngineClock::now();
+    bool verbose = system.isVerbose();
+    LogLevel logLevel = AsyncLogger::getLevel();
+    system.setVerbose(false);
+    AsyncLogger::setLevel(LogLevel::ERROR);     // rejected orders were already reported once
+
+    JournalReader reader;
+    struct stat info;
+    bool existing = stat(path.c_str(), &info) == 0 && info.st_size > 0;
+    bool ready = !existing || reader.open(path);
+    JournalReplay replay(reader, system, result);
+    size_t keep = 0;
+    bool hasOpenOrder = false;
+    JournalRecord pending = JournalRecord();
+    int pendingTradeId = 0;
+    size_t pendingFills = 0;
+    if (ready && reader.getRecordCount() < snapshotSequence) {
+        std::cerr << "Journal ends at sequence " << reader.getRecordCount() << ", before the snapshot's "
+                  << snapshotSequence << ": " << path << std::endl;
+        ready = false;
+    }
+    if (ready) {
+        // Records up to the snapshot are already applied; only their names are needed
+        size_t openOrder = replay.findOpenOrder();
+        if (openOrder < snapshotSequence) {
+            openOrder = reader.getRecordCount();
+        }
+        for (size_t i = 0; i < openOrder; ++i) {
+            uint8_t type = reader.getRecord(i).type;
+            if (i >= snapshotSequence || type == JournalRecord::SYMBOL_NAME || type == JournalRecord::USER_NAME
+                || type == JournalRecord::NAME_PART) {
+                replay.apply(i);
+            }
+        }
+        result.skipped = std::min<uint64_t>(snapshotSequence, openOrder);
+        keep = openOrder;
+        hasOpenOrder = openOrder < reader.getRecordCount();
+        if (hasOpenOrder) {
+            pending = reader.getRecord(openOrder);
+            pendingFills = replay.countFills(openOrder, pendingTradeId);
+            keep = openOrder + 1;
+        }
+        result.records = reader.getRecordCount();
+        result.lastSequence = reader.getLastSequence();
+        result.tornTail = reader.hasTornTail();
+        reader.close();     // unmap before the file is truncated
+        ready = openAt(path, journalOptions, keep);
+    }
+    if (ready) {
+        system.setJournal(this);
+        if (hasOpenOrder) {
+            // More fills than journaled just means the crash lost some of them
+            eventAlreadyJournaled = true;
+            size_t replayed = replay.rematch(pending, pendingTradeId);
+            eventAlreadyJournaled = false;
+            result.replayedFills += replayed;
+            result.fills += pendingFills;
+            result.mismatchedOrders += replayed < pendingFills ? 1 : 0;
+            replay.countEvent(pending);
+        }
+        Order::advanceNextOrderId(replay.getMaxOrderId() + 1);
+        Trade::advanceNextTradeId(replay.getMaxTradeId() + 1);
+    }
+
+    system.resetLatencyStatistics();
+    system.setVerbose(verbose);
+    AsyncLogger::setLevel(logLevel);
+    result.seconds = static_cast<double>(EngineClock::elapsedNanos(start, EngineClock::now())) / 1e9;
+    return ready;
+}
+
+void Journal::printRecovery(const JournalRecoveryResult& result) {
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Journal: recovered " << result.records << " records";
+    if (result.skipped > 0) {
+        std::cout << ", " << result.skipped << " already in the snapshot";
+    }
+    std::cout << " (" << result.orders << " orders, " << result.cancels << " cancels, "
+              << result.modifies << " modifies, " << result.fills << " fills) in "
+              << std::fixed << std::setprecision(3) << result.seconds << " s" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    if (result.tornTail) {
+        std::cout << "Journal: incomplete records after sequence " << result.lastSequence
+                  << " were discarded" << std::endl;
+    }
+    if (result.mismatchedOrders > 0) {
+        std::cout << "Journal: " << result.mismatchedOrders << " order(s) filled differently on replay ("
+                  << result.replayedFills << " fills vs " << result.fills << " journaled)" << std::endl;
+    }
+}
+
+bool Journal::parseSync(const std::string& text, JournalSync& sync) {
+    if (text == "none") {
+        sync = JournalSync::NONE;
+    } else if (text == "batched") {
+        sync = JournalSync::BATCHED;
+    } else if (text == "per-event") {
+        sync = JournalSync::PER_EVENT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Journal::getSyncName(JournalSync sync) {
+    switch (sync) {
+        case JournalSync::NONE: return "none";
+        case JournalSync::BATCHED: return "batched";
+        case JournalSync::PER_EVENT: return "per-event";
+    }
+    return "unknown";
+}
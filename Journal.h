@@ -0,0 +1,231 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "Order.h"
+#include "Trade.h"
+#include "Registry.h"
+#include "RingBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TradeBookingSystem;
+
+// Write-ahead order journal.
+//
+// Every inbound event (account, new order, cancel, modify, clear, auction) and
+// every fill it produced is appended as a fixed-width, checksummed
+// JournalRecord numbered by one gap-free sequence. The matching thread only
+// copies records into a ring; a writer thread drains it, writes whole batches
+// and fdatasyncs them (group commit), so one sync covers every event that
+// arrived meanwhile.
+// On startup recover() replays the journal through the matching engine to
+// rebuild books, portfolios and the id counters, stopping at the first torn
+// or corrupt record, and truncates the file there before appending.
+
+static const char JOURNAL_MAGIC[8] = { 'T', 'B', 'S', 'J', 'R', 'N', 'L', '1' };
+static const uint32_t JOURNAL_VERSION = 2;   // 2: 64-bit order ids
+static const size_t JOURNAL_NAME_SIZE = 16;
+
+struct JournalFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+struct JournalRecord {
+    enum Type : uint8_t {
+        SYMBOL_NAME = 1,    // symbolId, name (see setName), quantity = the piece's offset
+        USER_NAME,          // userId, name, quantity = the piece's offset
+        ACCOUNT_OPENED,     // userId
+        NEW_ORDER,          // orderId, symbolId, userId, side, orderType, quantity, price
+        CANCEL_ORDER,       // orderId, symbolId
+        FILL,               // tradeId, orderId = buy, otherOrderId = sell, userId = buyer, otherUserId = seller
+        BOOK_CLEARED,       // symbolId
+        SYSTEM_RESET,
+        NAME_PART,          // name, quantity = offset; a leading piece of the next SYMBOL_NAME/USER_NAME
+        CALL_OPENED,        // symbolId
+        CALL_UNCROSSED,     // symbolId; the auction's fills follow
+        MODIFY_ORDER        // orderId, symbolId, quantity, price; any fills follow
+    };
+
+    uint64_t sequence;      // 1, 2, 3, ... across sessions
+    uint64_t timestampNs;   // wall clock, nanoseconds since the epoch
+    double price;
+    uint64_t orderId;
+    uint64_t otherOrderId;
+    int32_t tradeId;
+    int32_t quantity;
+    SymbolId symbolId;
+    UserId userId;
+    UserId otherUserId;
+    uint8_t type;
+    uint8_t side;           // 0 = BUY, 1 = SELL
+    uint8_t orderType;      // NEW_ORDER: getOrderTypeCode (0 = LIMIT)
+    uint8_t reserved;
+    uint32_t checksum;      // hash of every byte before it
+    uint32_t padding;
+
+    // NAME records carry a NUL-padded name in the 16 bytes from price. A longer
+    // name is split into 16-byte pieces: NAME_PART records, then the name record
+    // with the last piece, each with its byte offset in quantity.
+    void setName(const std::string& name, size_t offset = 0);
+    std::string getName() const;
+
+    uint32_t computeChecksum() const;
+};
+
+static_assert(sizeof(JournalFileHeader) == 16, "JournalFileHeader must stay fixed width");
+static_assert(sizeof(JournalRecord) == 72, "JournalRecord must stay fixed width");
+
+// When appended records reach the disk
+enum class JournalSync {
+    NONE,       // write() only; the OS decides (survives a process crash, not a power loss)
+    BATCHED,    // fdatasync per group commit window
+    PER_EVENT   // commit() waits until the event's records are synced
+};
+
+// Journal configuration
+struct JournalOptions {
+    JournalSync sync;
+    unsigned groupCommitMicros; // longest a BATCHED record waits for its sync
+    size_t ringCapacity;        // records buffered between the matching and writer threads
+
+    JournalOptions() : sync(JournalSync::BATCHED), groupCommitMicros(1000), ringCapacity(65536) {}
+};
+
+// What recover() found and rebuilt
+struct JournalRecoveryResult {
+    uint64_t records;           // valid records found
+    uint64_t skipped;           // records already covered by a snapshot
+    uint64_t lastSequence;      // last valid record
+    size_t orders;
+    size_t cancels;
+    size_t modifies;
+    size_t fills;               // fills journaled
+    size_t replayedFills;       // fills the engine produced again
+    size_t mismatchedOrders;    // orders or uncrosses whose replay filled differently
+    bool tornTail;              // bytes after the last valid record (dropped)
+    double seconds;
+
+    JournalRecoveryResult()
+        : records(0), skipped(0), lastSequence(0), orders(0), cancels(0), modifies(0), fills(0), replayedFills(0),
+          mismatchedOrders(0), tornTail(false), seconds(0.0) {}
+};
+
+// Maps a journal read-only and exposes its valid prefix
+class JournalReader {
+public:
+    JournalReader();
+    ~JournalReader();
+
+    // Non-copyable: owns the mapping
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    // False if the file is missing or not a journal
+    bool open(const std::string& path);
+    void close();
+
+    size_t getRecordCount() const { return recordCount; }
+    const JournalRecord& getRecord(size_t index) const { return records[index]; }
+    uint64_t getLastSequence() const { return recordCount ? records[recordCount - 1].sequence : 0; }
+    size_t getValidBytes() const { return sizeof(JournalFileHeader) + recordCount * sizeof(JournalRecord); }
+    bool hasTornTail() const { return getValidBytes() < mappingSize; }
+
+private:
+    void* mapping;
+    size_t mappingSize;
+    const JournalRecord* records;
+    size_t recordCount;
+};
+
+// Appends records. All log and commit calls must come from one thread (the
+// matching thread); the writer thread is internal.
+class Journal {
+public:
+    Journal();
+    ~Journal();
+
+    // Non-copyable: owns the file and the writer thread
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Create the file, or truncate a torn tail and continue its sequence
+    bool open(const std::string& path, const JournalOptions& options = JournalOptions());
+    void close();   // writes and syncs everything first
+    bool isOpen() const { return fd >= 0; }
+
+    // Events
+    void logAccount(UserId user);
+    void logNewOrder(const Order& order);
+    void logCancel(SymbolId symbol, OrderId orderId);
+    void logModify(SymbolId symbol, OrderId orderId, int quantity, double price);
+    void logFill(const Fill& fill);
+    void logBookCleared(SymbolId symbol);
+    void logReset();
+    void logCallOpened(SymbolId symbol);
+    void logUncross(SymbolId symbol);
+
+    // End of one inbound event and its fills; waits for the disk under PER_EVENT
+    void commit();
+    // Wait until everything appended so far is written (and synced unless NONE)
+    void sync();
+
+    // Statistics
+    uint64_t getLastSequence() const { return sequence; }
+    uint64_t getDurableSequence() const { return durableSequence.load(std::memory_order_acquire); }
+    uint64_t getRecordCount() const { return recordCount; }
+    uint64_t getSyncCount() const { return syncCount.load(std::memory_order_relaxed); }
+    JournalSync getSyncPolicy() const { return options.sync; }
+
+    // Rebuild system state from the journal at path (missing = empty), then
+    // open it for append and attach it to the system. After a snapshot load,
+    // pass its journal sequence: only the records after it are replayed.
+    bool recover(const std::string& path, const JournalOptions& options,
+                 TradeBookingSystem& system, JournalRecoveryResult& result, uint64_t snapshotSequence = 0);
+    static void printRecovery(const JournalRecoveryResult& result);
+
+    static bool parseSync(const std::string& text, JournalSync& sync);
+    static const char* getSyncName(JournalSync sync);
+
+private:
+    int fd;
+    JournalOptions options;
+    std::unique_ptr<SpscRing<JournalRecord>> ring;
+    std::thread writer;
+    std::atomic<bool> running;
+    std::atomic<bool> failed;
+
+    // Matching thread only
+    uint64_t sequence;
+    uint64_t recordCount;
+    bool eventAlreadyJournaled;     // set by recover: skip the next record of an event that can fill
+    std::vector<char> symbolNamed;  // by SymbolId: a SYMBOL_NAME record was written this session
+    std::vector<char> userNamed;    // by UserId
+
+    // Writer thread -> waiters
+    std::atomic<uint64_t> durableSequence;
+    std::atomic<uint64_t> syncCount;
+    std::mutex mutex;
+    std::condition_variable wake;       // matching thread -> writer
+    std::condition_variable durable;    // writer -> matching thread
+
+    bool openAt(const std::string& path, const JournalOptions& options, size_t keepRecords);
+    JournalRecord makeRecord(JournalRecord::Type type);
+    void append(JournalRecord& record);
+    void nameSymbol(SymbolId symbol);
+    void nameUser(UserId user);
+    void appendName(JournalRecord& record, const std::string& name);
+    void waitDurable(uint64_t target);
+    void writerLoop();
+    bool writeBatch(const std::vector<JournalRecord>& batch);
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,103 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <iomanip>
+
+const int LatencyHistogram::SUB_BUCKET_BITS;
+const size_t LatencyHistogram::SUB_BUCKETS;
+const size_t LatencyHistogram::BUCKET_COUNT;
+
+// Constructor
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+// Clear all samples
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+// Largest value that maps to a bucket
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t sub = SUB_BUCKETS + (index - SUB_BUCKETS) % SUB_BUCKETS;
+    uint64_t lower = sub << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+double LatencyHistogram::getMean() const {
+    uint64_t samples = getCount();
+    return samples ? static_cast<double>(total.load(std::memory_order_relaxed)) / samples : 0.0;
+}
+
+// Smallest bucket bound covering the given share of samples (capped at the max seen)
+uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const {
+    uint64_t samples = getCount();
+    if (samples == 0) {
+        return 0;
+    }
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * samples + 0.5);
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min(bucketUpperBound(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+// Column headings for printSummary
+void LatencyHistogram::printHeader(std::ostream& out) {
+    out << std::left << std::setw(14) << "Stage" << std::right
+        << std::setw(10) << "Count" << std::setw(10) << "Mean"
+        << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+        << std::setw(10) << "p99.9" << std::setw(10) << "Max" << "  (ns)" << std::endl;
+}
+
+// One summary row
+void LatencyHistogram::printSummary(const std::string& name, std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::left << std::setw(14) << name << std::right
+        << std::setw(10) << getCount()
+        << std::fixed << std::setprecision(0) << std::setw(10) << getMean()
+        << std::setw(10) << getValueAtPercentile(50.0)
+        << std::setw(10) << getValueAtPercentile(90.0)
+        << std::setw(10) << getValueAtPercentile(99.0)
+        << std::setw(10) << getValueAtPercentile(99.9)
+        << std::setw(10) << getMax() << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Full distribution: one "upper-bound count cumulative-percent" line per non-empty bucket
+void LatencyHistogram::writeDistribution(const std::string& name, std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    uint64_t samples = getCount();
+    out << "# " << name << " count=" << samples << " mean=" << std::fixed << std::setprecision(1)
+        << getMean() << " max=" << getMax() << std::endl;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        uint64_t bucketCount = buckets[i].load(std::memory_order_relaxed);
+        if (bucketCount == 0) {
+            continue;
+        }
+        seen += bucketCount;
+        out << bucketUpperBound(i) << " " << bucketCount << " " << std::setprecision(4)
+            << (100.0 * seen / samples) << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
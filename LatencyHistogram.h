@@ -0,0 +1,71 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// HDR-style log-linear latency histogram (values in nanoseconds).
+// Values below SUB_BUCKETS are counted exactly; above that each power of two
+// is split into SUB_BUCKETS linear buckets, so any recorded value is reported
+// to within ~3%. record() is a handful of relaxed atomic adds with no locks
+// or allocation, cheap enough to leave on in production; readers may run
+// concurrently and see a slightly torn but consistent-enough snapshot.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static const size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    // Constructor
+    LatencyHistogram();
+
+    // Non-copyable (atomics)
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Recording (any thread)
+    void record(uint64_t nanos) {
+        buckets[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t previous = maximum.load(std::memory_order_relaxed);
+        while (nanos > previous
+               && !maximum.compare_exchange_weak(previous, nanos, std::memory_order_relaxed)) {
+        }
+    }
+    void reset();
+
+    // Statistics
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+    uint64_t getMax() const { return maximum.load(std::memory_order_relaxed); }
+    double getMean() const;
+    uint64_t getValueAtPercentile(double percentile) const;  // percentile in [0, 100]
+
+    // Reporting
+    static void printHeader(std::ostream& out);
+    void printSummary(const std::string& name, std::ostream& out) const;
+    void writeDistribution(const std::string& name, std::ostream& out) const;
+
+    // Bucket mapping
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SUB_BUCKET_BITS;
+        return SUB_BUCKETS + static_cast<size_t>(shift) * SUB_BUCKETS
+               + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    }
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> maximum;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,352 @@
+#include "LoadGenerator.h"
+#include "EngineClock.h"
+#include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+    const size_t LIVE_ORDER_CAP = size_t(1) << 20;  // passive orders tracked for cancels
+    const double DEFAULT_TICK = 0.01;
+
+    enum MessageKind : uint8_t { PASSIVE, AGGRESSIVE, CANCEL };
+
+    // Current resident set size from /proc (0 where unavailable)
+    size_t residentBytes() {
+        FILE* statm = std::fopen("/proc/self/statm", "r");
+        if (!statm) {
+            return 0;
+        }
+        unsigned long pages = 0, resident = 0;
+        int read = std::fscanf(statm, "%lu %lu", &pages, &resident);
+        std::fclose(statm);
+        return read == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+    }
+
+    // Largest resident set size so far
+    size_t peakResidentBytes() {
+        struct rusage usage;
+        return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) * 1024 : 0;
+    }
+
+    bool parseNumber(const std::string& value, double& number) {
+        char* end = nullptr;
+        number = std::strtod(value.c_str(), &end);
+        return !value.empty() && end && *end == '\0' && number >= 0;
+    }
+}
+
+// Constructor
+LoadGenerator::LoadGenerator(TradeBookingSystem& tradingSystem, const LoadProfile& loadProfile)
+    : system(tradingSystem), profile(loadProfile), snapshots(nullptr) {
+}
+
+// Resting orders across every book
+size_t LoadGenerator::countResting() const {
+    size_t resting = 0;
+    for (const auto& name : system.getAvailableSymbols()) {
+        const OrderBook* book = system.getOrderBook(Registry::findSymbol(name));
+        if (book) {
+            resting += book->getTotalOrderCount();
+        }
+    }
+    return resting;
+}
+
+// Generate and run the flow until the count or time limit
+LoadResult LoadGenerator::run() {
+    LoadResult result;
+    result.flowDigest = FNV_OFFSET;
+    service.reset();
+    arrival.reset();
+    interval.reset();
+
+    // Symbols by popularity rank (Zipf), each with a mid in ticks from its default price
+    std::vector<SymbolId> symbols;
+    std::vector<double> popularity;
+    std::vector<int64_t> mids;
+    std::vector<double> tickSizes;
+    double cumulative = 0.0;
+    for (const auto& name : system.getAvailableSymbols()) {
+        SymbolId symbol = Registry::findSymbol(name);
+        const OrderBook* book = system.getOrderBook(symbol);
+        double tick = book ? book->getTickSize() : DEFAULT_TICK;
+        double price = system.getMarketPrice(symbol) > 0 ? system.getMarketPrice(symbol) : 100.0;
+        cumulative += 1.0 / std::pow(static_cast<double>(symbols.size() + 1), profile.skew);
+        symbols.push_back(symbol);
+        popularity.push_back(cumulative);
+        mids.push_back(static_cast<int64_t>(std::llround(price / tick)));
+        tickSizes.push_back(tick);
+    }
+    if (symbols.empty()) {
+        return result;
+    }
+
+    // Accounts are opened before the clock starts
+    std::vector<UserId> users;
+    users.reserve(std::max<size_t>(profile.users, 1));
+    for (size_t i = 0; i < std::max<size_t>(profile.users, 1); ++i) {
+        users.push_back(system.createUserIfNotExists("load-user-" + std::to_string(i)));
+    }
+
+    double shares = profile.passiveShare + profile.aggressiveShare + profile.cancelShare;
+    double passiveCut = shares > 0 ? profile.passiveShare / shares : 1.0;
+    double aggressiveCut = shares > 0 ? (profile.passiveShare + profile.aggressiveShare) / shares : 1.0;
+    int levels = std::max(profile.levels, 1);
+    int maxQuantity = std::max(profile.maxQuantity, 1);
+    uint64_t limitNanos = static_cast<uint64_t>(profile.seconds * 1e9);
+    uint64_t sampleNanos = std::max<uint64_t>(static_cast<uint64_t>(profile.sampleSeconds * 1e9), 1000000);
+
+    // Arrival gaps come from their own stream so pacing does not change the messages
+    Random random(profile.seed);
+    Random arrivals(random.next());
+    std::vector<LiveOrder> live;
+    live.reserve(std::min<size_t>(LIVE_ORDER_CAP, 65536));
+    size_t tradesBefore = system.getTotalTradesExecuted();
+    double arrivalNanos = 0.0;
+    uint64_t nextSample = sampleNanos;
+    uint64_t sampledMessages = 0;
+    double sampledSeconds = 0.0;
+
+    auto takeSample = [&](uint64_t elapsedNanos) {
+        LoadSample sample;
+        sample.seconds = elapsedNanos / 1e9;
+        sample.messages = result.messages;
+        sample.trades = system.getTotalTradesExecuted() - tradesBefore;
+        sample.restingOrders = countResting();
+        sample.residentBytes = residentBytes();
+        double span = sample.seconds - sampledSeconds;
+        sample.messagesPerSecond = span > 0 ? (sample.messages - sampledMessages) / span : 0.0;
+        sample.p50Nanos = interval.getValueAtPercentile(50.0);
+        sample.p99Nanos = interval.getValueAtPercentile(99.0);
+        result.samples.push_back(sample);
+        interval.reset();
+        sampledMessages = sample.messages;
+        sampledSeconds = sample.seconds;
+    };
+
+    uint64_t start = EngineClock::now();
+    uint64_t elapsed = 0;
+    while (profile.messages == 0 || result.messages < profile.messages) {
+        // Draw the message
+        size_t rank = static_cast<size_t>(std::lower_bound(popularity.begin(), popularity.end(),
+                                                           random.uniform() * cumulative) - popularity.begin());
+        rank = std::min(rank, symbols.size() - 1);
+        SymbolId symbol = symbols[rank];
+        int64_t& mid = mids[rank];
+        double step = random.uniform();
+        if (step < profile.walk * 0.5) {
+            mid = std::max<int64_t>(mid - 1, levels + 1);
+        } else if (step < profile.walk) {
+            ++mid;
+        }
+        UserId user = users[random.below(users.size())];
+        OrderSide side = (random.next() & 1) ? OrderSide::BUY : OrderSide::SELL;
+        int quantity = 1 + static_cast<int>(random.below(static_cast<size_t>(maxQuantity)));
+        int64_t offset = 1 + static_cast<int64_t>(random.below(static_cast<size_t>(levels)));
+        double draw = random.uniform();
+        MessageKind kind = draw < passiveCut ? PASSIVE : draw < aggressiveCut ? AGGRESSIVE : CANCEL;
+        // Cancel one of our orders that still rests, dropping the ones that have filled since
+        size_t victim = 0;
+        while (kind == CANCEL && !live.empty()) {
+            victim = random.below(live.size());
+            if (system.findOrder(live[victim].orderId)) {
+                break;
+            }
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        if (kind == CANCEL && live.empty()) {
+            kind = PASSIVE;
+        }
+        bool buy = side == OrderSide::BUY;
+        int64_t tick = (kind == PASSIVE) == buy ? mid - offset : mid + offset;
+
+        // Poisson arrivals: exponential gaps at the mean rate
+        if (profile.rate > 0) {
+            arrivalNanos += -std::log(1.0 - arrivals.uniform()) / profile.rate * 1e9;
+            if (limitNanos > 0 && arrivalNanos >= static_cast<double>(limitNanos)) {
+                break;
+            }
+            waitUntil(start, static_cast<uint64_t>(arrivalNanos));
+        } else if (limitNanos > 0 && elapsed >= limitNanos) {
+            break;
+        }
+
+        fnvMixWord(result.flowDigest, static_cast<uint64_t>(kind) | static_cast<uint64_t>(buy) << 8
+                                           | static_cast<uint64_t>(quantity) << 16 | static_cast<uint64_t>(symbol) << 40);
+        fnvMixWord(result.flowDigest, kind == CANCEL ? victim : static_cast<uint64_t>(user) << 32 ^ static_cast<uint64_t>(tick));
+
+        uint64_t issued = EngineClock::now();
+        switch (kind) {
+            case PASSIVE: {
+                ++result.passive;
+                OrderId orderId = system.placeOrderDirect(user, symbol, side, quantity, tick * tickSizes[rank],
+                                                          OrderType::LIMIT);
+                if (orderId == 0) {
+                    ++result.rejected;
+                } else if (live.size() < LIVE_ORDER_CAP) {
+                    live.push_back(LiveOrder{ orderId, symbol });
+                } else {
+                    live[random.below(live.size())] = LiveOrder{ orderId, symbol };
+                }
+                break;
+            }
+            case AGGRESSIVE:
+                ++result.aggressive;
+                if (system.placeOrderDirect(user, symbol, side, quantity, tick * tickSizes[rank], OrderType::IOC) == 0) {
+                    ++result.rejected;
+                }
+                break;
+            case CANCEL: {
+                ++result.cancels;
+                LiveOrder target = live[victim];
+                live[victim] = live.back();
+                live.pop_back();
+                if (!system.cancelOrderDirect(target.symbol, target.orderId)) {
+                    ++result.cancelMisses;
+                }
+                break;
+            }
+        }
+        uint64_t done = EngineClock::now();
+        ++result.messages;
+        if (snapshots) {
+            snapshots->onEvent();
+        }
+
+        elapsed = EngineClock::elapsedNanos(start, done);
+        uint64_t nanos = EngineClock::elapsedNanos(issued, done);
+        service.record(nanos);
+        interval.record(nanos);
+        if (profile.rate > 0) {
+            arrival.record(elapsed - std::min<uint64_t>(elapsed, static_cast<uint64_t>(arrivalNanos)));
+        }
+        if (elapsed >= nextSample) {
+            takeSample(elapsed);
+            while (nextSample <= elapsed) {
+                nextSample += sampleNanos;
+            }
+        }
+    }
+
+    elapsed = EngineClock::elapsedNanos(start, EngineClock::now());
+    if (result.samples.empty() || result.samples.back().messages != result.messages) {
+        takeSample(elapsed);
+    }
+    result.seconds = elapsed / 1e9;
+    result.trades = result.samples.back().trades;
+    result.restingOrders = result.samples.back().restingOrders;
+    result.peakResidentBytes = peakResidentBytes();
+    return result;
+}
+
+// Parse a comma-separated profile; unnamed fields keep their defaults
+bool LoadGenerator::parseProfile(const std::string& text, LoadProfile& parsed) {
+    LoadProfile result;
+    std::stringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        size_t equals = item.find('=');
+        std::string key = item.substr(0, equals);
+        std::string value = (equals == std::string::npos) ? "" : item.substr(equals + 1);
+        double number = 0.0;
+        if (key == "mix") {
+            double shares[3];
+            std::stringstream parts(value);
+            std::string part;
+            size_t count = 0;
+            while (std::getline(parts, part, '/') && count < 3 && parseNumber(part, shares[count])) {
+                ++count;
+            }
+            if (count != 3 || !parts.eof() || shares[0] + shares[1] + shares[2] <= 0) {
+                return false;
+            }
+            result.passiveShare = shares[0];
+            result.aggressiveShare = shares[1];
+            result.cancelShare = shares[2];
+            continue;
+        }
+        if (!parseNumber(value, number)) {
+            return false;
+        }
+        if (key == "count") {
+            result.messages = static_cast<uint64_t>(number);
+        } else if (key == "seconds") {
+            result.seconds = number;
+        } else if (key == "rate") {
+            result.rate = number;
+        } else if (key == "users" && number >= 1) {
+            result.users = static_cast<size_t>(number);
+        } else if (key == "skew") {
+            result.skew = number;
+        } else if (key == "walk" && number <= 1) {
+            result.walk = number;
+        } else if (key == "levels" && number >= 1) {
+            result.levels = static_cast<int>(number);
+        } else if (key == "qty" && number >= 1) {
+            result.maxQuantity = static_cast<int>(number);
+        } else if (key == "seed") {
+            result.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "sample" && number > 0) {
+            result.sampleSeconds = number;
+        } else {
+            return false;
+        }
+    }
+    // A profile with neither limit still has to end
+    if (result.messages == 0 && result.seconds <= 0) {
+        result.messages = 1000000;
+    }
+    parsed = result;
+    return true;
+}
+
+// Print the run summary, the samples and the latency distribution
+void LoadGenerator::printReport(const LoadResult& result, const LatencyHistogram& service,
+                                const LatencyHistogram& arrival, std::ostream& out) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+    out << "\n=== Load Generator Report ===" << std::endl;
+    out << "Messages: " << result.messages << " (passive " << result.passive << ", aggressive " << result.aggressive
+        << ", cancel " << result.cancels << ", rejected " << result.rejected << ", cancel misses "
+        << result.cancelMisses << ")" << std::endl;
+    out << "Trades: " << result.trades << std::endl;
+    out << "Resting orders: " << result.restingOrders << std::endl;
+    out << std::hex << std::setfill('0') << "Flow digest: " << std::setw(16) << result.flowDigest
+        << std::dec << std::setfill(' ') << std::endl;
+    out << std::fixed << std::setprecision(3);
+    out << "Run time: " << result.seconds << " s" << std::endl;
+    out << std::setprecision(1) << "Peak RSS: " << result.peakResidentBytes / 1048576.0 << " MB" << std::endl;
+    out << std::setprecision(0);
+    out << "Messages/sec: " << result.messages / seconds << std::endl;
+    out << "Trades/sec: " << result.trades / seconds << std::endl;
+
+    out << "\n" << std::setw(9) << "Time (s)" << std::setw(12) << "Messages" << std::setw(12) << "Msgs/s"
+        << std::setw(12) << "Trades" << std::setw(10) << "Resting" << std::setw(10) << "RSS (MB)"
+        << std::setw(10) << "p50" << std::setw(10) << "p99" << "  (ns)" << std::endl;
+    for (const LoadSample& sample : result.samples) {
+        out << std::setprecision(2) << std::setw(9) << sample.seconds << std::setprecision(0)
+            << std::setw(12) << sample.messages << std::setw(12) << sample.messagesPerSecond
+            << std::setw(12) << sample.trades << std::setw(10) << sample.restingOrders
+            << std::setprecision(1) << std::setw(10) << sample.residentBytes / 1048576.0
+            << std::setw(10) << sample.p50Nanos << std::setw(10) << sample.p99Nanos << std::endl;
+    }
+    out << std::endl;
+    LatencyHistogram::printHeader(out);
+    service.printSummary("Service", out);
+    if (arrival.getCount() > 0) {
+        arrival.printSummary("From arrival", out);
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
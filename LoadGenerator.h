@@ -0,0 +1,114 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include "TradeBookingSystem.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Shape of the synthetic order flow
+struct LoadProfile {
+    uint64_t seed;
+    uint64_t messages;      // stop after this many (0 = no count limit)
+    double seconds;         // stop after this long (0 = no time limit)
+    double rate;            // mean messages per second, Poisson arrivals (0 = as fast as possible)
+    size_t users;
+    double passiveShare;    // message mix, normalized when generating
+    double aggressiveShare;
+    double cancelShare;
+    double skew;            // Zipf exponent of symbol popularity (0 = uniform)
+    double walk;            // chance that a message moves its symbol's mid by one tick
+    int levels;             // passive orders rest 1..levels ticks from the mid
+    int maxQuantity;        // order sizes are uniform in 1..maxQuantity
+    double sampleSeconds;   // time between progress samples
+
+    LoadProfile()
+        : seed(1), messages(0), seconds(0.0), rate(0.0), users(1000), passiveShare(60.0), aggressiveShare(30.0),
+          cancelShare(10.0), skew(1.0), walk(0.5), levels(10), maxQuantity(100), sampleSeconds(1.0) {}
+};
+
+// State of the run at one sample
+struct LoadSample {
+    double seconds;         // since the run started
+    uint64_t messages;
+    uint64_t trades;
+    size_t restingOrders;   // across every book
+    size_t residentBytes;   // process RSS
+    double messagesPerSecond;   // over the interval since the previous sample
+    uint64_t p50Nanos;      // service time over the interval
+    uint64_t p99Nanos;
+};
+
+// Results of a generator run
+struct LoadResult {
+    uint64_t messages;
+    uint64_t passive;
+    uint64_t aggressive;
+    uint64_t cancels;
+    uint64_t rejected;      // orders the system refused
+    uint64_t cancelMisses;  // cancels the system did not find
+    uint64_t trades;
+    size_t restingOrders;
+    size_t peakResidentBytes;
+    uint64_t flowDigest;    // FNV-style hash of every generated message
+    double seconds;
+    std::vector<LoadSample> samples;
+
+    LoadResult()
+        : messages(0), passive(0), aggressive(0), cancels(0), rejected(0), cancelMisses(0), trades(0),
+          restingOrders(0), peakResidentBytes(0), flowDigest(0), seconds(0.0) {}
+};
+
+// Synthetic order flow against a TradeBookingSystem.
+// Each default symbol gets a mid that random-walks one tick at a time from
+// its initializeDefaultPrices price. Messages pick a symbol by Zipf
+// popularity and a user at random. A passive message rests a limit order a
+// few ticks behind the mid, an aggressive one sends an IOC through it, and a
+// cancel pulls one of the generator's earlier passive orders that still
+// rests. The stream is drawn from one xorshift generator seeded by the
+// profile, so a seed and a starting state always give the same messages,
+// fills and books; the time limit and pacing only decide how much of that
+// stream is run.
+// Every message's service time is recorded. Paced runs also record latency
+// from its scheduled arrival, so a stall shows up in every message queued
+// behind it (along with any lateness of the generator's own wake-ups).
+class LoadGenerator {
+public:
+    LoadGenerator(TradeBookingSystem& tradingSystem, const LoadProfile& profile);
+
+    LoadResult run();
+
+    // The writer is told about every message (null = no periodic snapshots)
+    void setSnapshotWriter(SnapshotWriter* writer) { snapshots = writer; }
+
+    // Latency of every message in the last run
+    const LatencyHistogram& getServiceLatency() const { return service; }
+    const LatencyHistogram& getArrivalLatency() const { return arrival; }    // paced runs only
+
+    // "count=N,seconds=X,rate=R,users=N,mix=P/A/C,skew=X,walk=P,levels=N,qty=N,seed=N,sample=X"
+    static bool parseProfile(const std::string& text, LoadProfile& profile);
+
+    static void printReport(const LoadResult& result, const LatencyHistogram& service,
+                            const LatencyHistogram& arrival, std::ostream& out = std::cout);
+
+private:
+    // One of the generator's passive orders, possibly filled since (dropped when a cancel finds it gone)
+    struct LiveOrder {
+        OrderId orderId;
+        SymbolId symbol;
+    };
+
+    TradeBookingSystem& system;
+    LoadProfile profile;
+    SnapshotWriter* snapshots;
+    LatencyHistogram service;
+    LatencyHistogram arrival;
+    LatencyHistogram interval;      // service time since the last sample
+
+    size_t countResting() const;
+};
+
+#endif // LOADGENERATOR_H
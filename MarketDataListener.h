@@ -0,0 +1,46 @@
+#ifndef MARKETDATALISTENER_H
+#define MARKETDATALISTENER_H
+
+#include "Order.h"
+#include "Trade.h"
+#include <cstddef>
+#include <cstdint>
+
+class OrderBook;
+
+// One change to an aggregated price level, reported after the book has changed
+struct LevelUpdate {
+    enum Type : uint8_t { ADD, CHANGE, DELETE };
+
+    SymbolId symbolId;
+    OrderSide side;
+    Type type;
+    int64_t tick;
+    double price;
+    int64_t quantity;       // total resting quantity at the level (0 for DELETE)
+    size_t orderCount;      // orders at the level (0 for DELETE)
+};
+
+// Where a call auction would uncross if it ended now (see MatchingEngine::findEquilibrium)
+struct AuctionIndicative {
+    SymbolId symbolId;
+    int64_t tick;
+    double price;           // 0 when the book does not cross
+    int64_t volume;         // quantity that would execute at price
+    int64_t buySurplus;     // bid quantity at or above price left over
+    int64_t sellSurplus;    // ask quantity at or below price left over
+};
+
+// Observes the depth changes and trade prints of an OrderBook. Called
+// synchronously on the thread that changes the book, after each change, so
+// the book is consistent with everything reported so far.
+class MarketDataListener {
+public:
+    virtual ~MarketDataListener() = default;
+    virtual void onLevelUpdate(const LevelUpdate& update) = 0;
+    virtual void onTrade(const Fill& fill) = 0;
+    virtual void onIndicative(const AuctionIndicative& indicative) { (void)indicative; }
+    virtual void onBookClosed(const OrderBook& book) { (void)book; }
+};
+
+#endif // MARKETDATALISTENER_H
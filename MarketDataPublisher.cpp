@@ -0,0 +1,424 @@
+#include "MarketDataPublisher.h"
+#include "EngineClock.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+const size_t ConflatedDepth::MAX_LEVELS;
+const size_t MarketDataPublisher::DEFAULT_SNAPSHOT_INTERVAL;
+
+namespace {
+    uint64_t doubleBits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double bitsToDouble(uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    size_t sideIndex(OrderSide side) {
+        return side == OrderSide::BUY ? 0 : 1;
+    }
+
+    // Rank key of a level: lower is better on either side
+    int64_t rankKey(OrderSide side, int64_t tick) {
+        return side == OrderSide::BUY ? -tick : tick;
+    }
+}
+
+// SYMBOL messages: name bytes overlay price and quantity
+void MarketDataMessage::setName(const std::string& name, size_t offset) {
+    char bytes[MARKET_DATA_NAME_SIZE] = {};
+    if (offset < name.size()) {
+        std::memcpy(bytes, name.data() + offset, std::min(name.size() - offset, MARKET_DATA_NAME_SIZE));
+    }
+    count = static_cast<uint32_t>(offset);
+    std::memcpy(reinterpret_cast<char*>(this) + offsetof(MarketDataMessage, price), bytes, sizeof(bytes));
+}
+
+std::string MarketDataMessage::getName() const {
+    const char* bytes = reinterpret_cast<const char*>(this) + offsetof(MarketDataMessage, price);
+    size_t length = 0;
+    while (length < MARKET_DATA_NAME_SIZE && bytes[length] != '\0') ++length;
+    return std::string(bytes, length);
+}
+
+// ---- MarketDataFileWriter ----
+
+MarketDataFileWriter::MarketDataFileWriter() : file(nullptr), messageCount(0) {
+    buffer.reserve(BUFFER_MESSAGES);
+}
+
+MarketDataFileWriter::~MarketDataFileWriter() {
+    close();
+}
+
+// Create the file and write its header
+bool MarketDataFileWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Cannot create market data file: " << path << std::endl;
+        return false;
+    }
+    MarketDataFileHeader header = {};
+    std::memcpy(header.magic, MARKET_DATA_MAGIC, sizeof(header.magic));
+    header.version = MARKET_DATA_VERSION;
+    header.messageSize = sizeof(MarketDataMessage);
+    std::fwrite(&header, sizeof(header), 1, file);
+    return true;
+}
+
+void MarketDataFileWriter::close() {
+    if (file) {
+        flush();
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void MarketDataFileWriter::onMessage(const MarketDataMessage& message) {
+    if (!file) {
+        return;
+    }
+    buffer.push_back(message);
+    ++messageCount;
+    if (buffer.size() >= BUFFER_MESSAGES) {
+        flush();
+    }
+}
+
+void MarketDataFileWriter::flush() {
+    if (file && !buffer.empty()) {
+        std::fwrite(buffer.data(), sizeof(MarketDataMessage), buffer.size(), file);
+        std::fflush(file);
+    }
+    buffer.clear();
+}
+
+// ---- ConflatedDepth ----
+
+ConflatedDepth::ConflatedDepth(size_t levelCount, size_t symbolCount)
+    : levels(std::min(std::max<size_t>(levelCount, 1), MAX_LEVELS)), maxSymbols(symbolCount),
+      slots(new Slot[symbolCount]()) {
+    scratch.reserve(MAX_LEVELS);
+}
+
+// Copy the latest consistent version of a symbol's depth
+bool ConflatedDepth::read(SymbolId symbol, Snapshot& snapshot) const {
+    if (symbol >= maxSymbols) {
+        return false;
+    }
+    const Slot& slot = slots[symbol];
+    uint64_t words[WORDS];
+    for (;;) {
+        uint64_t before = slot.version.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;
+        }
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+
+    snapshot.sequence = words[0];
+    snapshot.lastTradePrice = bitsToDouble(words[1]);
+    snapshot.lastTradeQuantity = static_cast<int64_t>(words[2]);
+    snapshot.bidCount = static_cast<size_t>(words[3]);
+    snapshot.askCount = static_cast<size_t>(words[4]);
+    for (size_t side = 0; side < 2; ++side) {
+        DepthLevel* out = side == 0 ? snapshot.bids : snapshot.asks;
+        const uint64_t* in = words + HEADER_WORDS + side * MAX_LEVELS * 3;
+        size_t count = side == 0 ? snapshot.bidCount : snapshot.askCount;
+        for (size_t i = 0; i < count; ++i) {
+            out[i].price = bitsToDouble(in[i * 3]);
+            out[i].quantity = static_cast<int64_t>(in[i * 3 + 1]);
+            out[i].orderCount = static_cast<size_t>(in[i * 3 + 2]);
+        }
+    }
+    return true;
+}
+
+// Whether a level change can alter the published top levels
+bool ConflatedDepth::affects(const LevelUpdate& update) const {
+    if (update.symbolId >= maxSymbols) {
+        return false;
+    }
+    const Slot& slot = slots[update.symbolId];
+    size_t side = sideIndex(update.side);
+    return slot.publishedCount[side] < levels || rankKey(update.side, update.tick) <= slot.worstKey[side];
+}
+
+// Republish a book's top levels
+void ConflatedDepth::update(const OrderBook& book, uint64_t sequence) {
+    SymbolId symbol = book.getSymbolId();
+    if (symbol >= maxSymbols) {
+        return;
+    }
+    Slot& slot = slots[symbol];
+    beginWrite(slot);
+    slot.words[0].store(sequence, std::memory_order_relaxed);
+    for (size_t side = 0; side < 2; ++side) {
+        OrderSide orderSide = side == 0 ? OrderSide::BUY : OrderSide::SELL;
+        book.getDepth(orderSide, levels, scratch);
+        std::atomic<uint64_t>* out = slot.words + HEADER_WORDS + side * MAX_LEVELS * 3;
+        for (size_t i = 0; i < scratch.size(); ++i) {
+            out[i * 3].store(doubleBits(scratch[i].price), std::memory_order_relaxed);
+            out[i * 3 + 1].store(static_cast<uint64_t>(scratch[i].quantity), std::memory_order_relaxed);
+            out[i * 3 + 2].store(scratch[i].orderCount, std::memory_order_relaxed);
+        }
+        slot.words[3 + side].store(scratch.size(), std::memory_order_relaxed);
+        slot.publishedCount[side] = scratch.size();
+        slot.worstKey[side] = scratch.empty() ? 0
+                            : rankKey(orderSide, book.priceToTick(scratch.back().price));
+    }
+    endWrite(slot);
+}
+
+// Record the latest trade print
+void ConflatedDepth::recordTrade(const Fill& fill, uint64_t sequence) {
+    if (fill.symbolId >= maxSymbols) {
+        return;
+    }
+    Slot& slot = slots[fill.symbolId];
+    beginWrite(slot);
+    slot.words[0].store(sequence, std::memory_order_relaxed);
+    slot.words[1].store(doubleBits(fill.price), std::memory_order_relaxed);
+    slot.words[2].store(static_cast<uint64_t>(fill.quantity), std::memory_order_relaxed);
+    endWrite(slot);
+}
+
+// Empty a symbol's depth (its book went away)
+void ConflatedDepth::clear(SymbolId symbol, uint64_t sequence) {
+    if (symbol >= maxSymbols) {
+        return;
+    }
+    Slot& slot = slots[symbol];
+    beginWrite(slot);
+    slot.words[0].store(sequence, std::memory_order_relaxed);
+    slot.words[3].store(0, std::memory_order_relaxed);
+    slot.words[4].store(0, std::memory_order_relaxed);
+    slot.publishedCount[0] = slot.publishedCount[1] = 0;
+    endWrite(slot);
+}
+
+void ConflatedDepth::beginWrite(Slot& slot) {
+    uint64_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ConflatedDepth::endWrite(Slot& slot) {
+    uint64_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_release);
+}
+
+// ---- MarketDataPublisher ----
+
+MarketDataPublisher::MarketDataPublisher(size_t interval)
+    : conflated(nullptr), snapshotInterval(interval), sequence(0), snapshotCount(0),
+      startTicks(EngineClock::now()) {
+}
+
+// Detach from any books that are still alive
+MarketDataPublisher::~MarketDataPublisher() {
+    for (OrderBook* book : books) {
+        if (book) {
+            book->setMarketDataListener(nullptr);
+        }
+    }
+    flush();
+}
+
+void MarketDataPublisher::addSubscriber(MarketDataSubscriber* subscriber) {
+    subscribers.push_back(subscriber);
+}
+
+void MarketDataPublisher::setConflatedDepth(ConflatedDepth* depth) {
+    conflated = depth;
+    if (conflated) {
+        for (OrderBook* book : books) {
+            if (book) {
+                conflated->update(*book, sequence);
+            }
+        }
+    }
+}
+
+// Start publishing a book (replaces any earlier book for the same symbol)
+void MarketDataPublisher::attach(OrderBook& book) {
+    SymbolId symbol = book.getSymbolId();
+    if (symbol >= books.size()) {
+        books.resize(symbol + 1, nullptr);
+        updatesSinceSnapshot.resize(symbol + 1, 0);
+    }
+    if (books[symbol] && books[symbol] != &book) {
+        books[symbol]->setMarketDataListener(nullptr);
+    }
+    books[symbol] = &book;
+    book.setMarketDataListener(this);
+
+    // The name in 16-byte pieces, so long names are not cut
+    const std::string& name = book.getSymbol();
+    size_t offset = 0;
+    do {
+        MarketDataMessage message = makeMessage(MarketDataMessage::SYMBOL, symbol);
+        message.setName(name, offset);
+        emit(message);
+        offset += MARKET_DATA_NAME_SIZE;
+    } while (offset < name.size());
+    publishSnapshot(book);
+}
+
+void MarketDataPublisher::detach(OrderBook& book) {
+    SymbolId symbol = book.getSymbolId();
+    if (symbol < books.size() && books[symbol] == &book) {
+        books[symbol] = nullptr;
+    }
+    if (book.getMarketDataListener() == this) {
+        book.setMarketDataListener(nullptr);
+    }
+}
+
+// Full picture of one book: every level, bids then asks, best first
+void MarketDataPublisher::publishSnapshot(const OrderBook& book) {
+    SymbolId symbol = book.getSymbolId();
+    const PriceLadder& bids = book.getBuyOrders();
+    const PriceLadder& asks = book.getSellOrders();
+
+    MarketDataMessage message = makeMessage(MarketDataMessage::SNAPSHOT_BEGIN, symbol);
+    message.count = static_cast<uint32_t>(bids.getLevelCount() + asks.getLevelCount());
+    emit(message);
+    for (const PriceLadder* ladder : { &bids, &asks }) {
+        OrderSide side = (ladder == &bids) ? OrderSide::BUY : OrderSide::SELL;
+        for (const PriceLevel* level = ladder->best(); level; level = ladder->next(*level)) {
+            MarketDataMessage entry = makeMessage(MarketDataMessage::SNAPSHOT_LEVEL, symbol);
+            entry.side = static_cast<uint8_t>(side);
+            entry.price = level->price;
+            entry.quantity = level->totalQuantity;
+            entry.count = static_cast<uint32_t>(level->orderCount);
+            emit(entry);
+        }
+    }
+    emit(makeMessage(MarketDataMessage::SNAPSHOT_END, symbol));
+
+    if (symbol < updatesSinceSnapshot.size()) {
+        updatesSinceSnapshot[symbol] = 0;
+    }
+    ++snapshotCount;
+    if (conflated) {
+        conflated->update(book, sequence);
+    }
+}
+
+void MarketDataPublisher::publishSnapshots() {
+    for (OrderBook* book : books) {
+        if (book) {
+            publishSnapshot(*book);
+        }
+    }
+}
+
+void MarketDataPublisher::flush() {
+    for (MarketDataSubscriber* subscriber : subscribers) {
+        subscriber->flush();
+    }
+}
+
+// One level changed: publish it, refresh the conflated view if the top moved
+void MarketDataPublisher::onLevelUpdate(const LevelUpdate& update) {
+    static const MarketDataMessage::Type types[] = {
+        MarketDataMessage::LEVEL_ADD, MarketDataMessage::LEVEL_CHANGE, MarketDataMessage::LEVEL_DELETE
+    };
+    MarketDataMessage message = makeMessage(types[update.type], update.symbolId);
+    message.side = static_cast<uint8_t>(update.side);
+    message.price = update.price;
+    message.quantity = update.quantity;
+    message.count = static_cast<uint32_t>(update.orderCount);
+    emit(message);
+
+    if (conflated && update.symbolId < books.size() && books[update.symbolId]
+        && conflated->affects(update)) {
+        conflated->update(*books[update.symbolId], sequence);
+    }
+    countUpdate(update.symbolId);
+}
+
+void MarketDataPublisher::onTrade(const Fill& fill) {
+    MarketDataMessage message = makeMessage(MarketDataMessage::TRADE, fill.symbolId);
+    message.price = fill.price;
+    message.quantity = fill.quantity;
+    message.count = static_cast<uint32_t>(fill.tradeId);
+    emit(message);
+
+    if (conflated) {
+        conflated->recordTrade(fill, sequence);
+    }
+    countUpdate(fill.symbolId);
+}
+
+// Call auction equilibrium; not a book change, so it does not count towards snapshots
+void MarketDataPublisher::onIndicative(const AuctionIndicative& indicative) {
+    MarketDataMessage message = makeMessage(MarketDataMessage::AUCTION_INDICATIVE, indicative.symbolId);
+    int64_t surplus = std::max(indicative.buySurplus, indicative.sellSurplus);
+    message.price = indicative.price;
+    message.quantity = indicative.volume;
+    message.side = indicative.sellSurplus > indicative.buySurplus ? 1 : 0;
+    message.count = static_cast<uint32_t>(std::min<int64_t>(surplus, UINT32_MAX));
+    emit(message);
+}
+
+// A book is being destroyed: forget it and publish it as empty
+void MarketDataPublisher::onBookClosed(const OrderBook& book) {
+    SymbolId symbol = book.getSymbolId();
+    if (symbol >= books.size() || books[symbol] != &book) {
+        return;
+    }
+    books[symbol] = nullptr;
+    MarketDataMessage message = makeMessage(MarketDataMessage::SNAPSHOT_BEGIN, symbol);
+    emit(message);
+    emit(makeMessage(MarketDataMessage::SNAPSHOT_END, symbol));
+    ++snapshotCount;
+    if (conflated) {
+        conflated->clear(symbol, sequence);
+    }
+}
+
+MarketDataMessage MarketDataPublisher::makeMessage(MarketDataMessage::Type type, SymbolId symbol) {
+    MarketDataMessage message = {};
+    message.timestampNs = EngineClock::elapsedNanos(startTicks, EngineClock::now());
+    message.symbolId = symbol;
+    message.type = type;
+    return message;
+}
+
+// Number a message and hand it to every subscriber
+void MarketDataPublisher::emit(const MarketDataMessage& message) {
+    MarketDataMessage numbered = message;
+    numbered.sequence = ++sequence;
+    for (MarketDataSubscriber* subscriber : subscribers) {
+        subscriber->onMessage(numbered);
+    }
+}
+
+// Periodic snapshot once a book has seen enough updates
+void MarketDataPublisher::countUpdate(SymbolId symbol) {
+    if (snapshotInterval == 0 || symbol >= books.size() || !books[symbol]) {
+        return;
+    }
+    if (++updatesSinceSnapshot[symbol] >= snapshotInterval) {
+        publishSnapshot(*books[symbol]);
+    }
+}
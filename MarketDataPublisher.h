@@ -0,0 +1,212 @@
+#ifndef MARKETDATAPUBLISHER_H
+#define MARKETDATAPUBLISHER_H
+
+#include "MarketDataListener.h"
+#include "OrderBook.h"
+#include "Registry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary L2 market data.
+//
+// The stream is a sequence of fixed-width MarketDataMessages numbered by one
+// publisher-wide sequence (1, 2, 3, ... with no gaps), so a consumer that sees
+// a jump has lost messages and should wait for the next snapshot of each
+// symbol. A snapshot is SNAPSHOT_BEGIN, one SNAPSHOT_LEVEL per resting level
+// (bids best first, then asks best first) and SNAPSHOT_END; it replaces the
+// consumer's view of that symbol. Files start with a MarketDataFileHeader.
+
+static const char MARKET_DATA_MAGIC[8] = { 'T', 'B', 'S', 'M', 'D', 'A', 'T', '1' };
+static const uint32_t MARKET_DATA_VERSION = 1;
+static const size_t MARKET_DATA_NAME_SIZE = 16;
+
+struct MarketDataFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t messageSize;
+};
+
+struct MarketDataMessage {
+    enum Type : uint8_t {
+        SYMBOL = 1,         // symbol name in price/quantity bytes, count = byte offset (see setName)
+        LEVEL_ADD,          // side, price, quantity, count = orders
+        LEVEL_CHANGE,       // side, price, quantity, count = orders
+        LEVEL_DELETE,       // side, price
+        TRADE,              // price, quantity, count = trade id
+        SNAPSHOT_BEGIN,     // count = levels that follow
+        SNAPSHOT_LEVEL,     // side, price, quantity, count = orders
+        SNAPSHOT_END,
+        AUCTION_INDICATIVE  // price, quantity = volume, side = surplus side, count = surplus (0s = not crossed)
+    };
+
+    uint64_t sequence;
+    uint64_t timestampNs;   // EngineClock time since the publisher started
+    double price;
+    int64_t quantity;
+    uint32_t count;
+    SymbolId symbolId;
+    uint8_t type;
+    uint8_t side;           // 0 = BUY, 1 = SELL
+    uint8_t reserved[6];
+
+    // SYMBOL messages carry a NUL-padded name in the 16 bytes of price and quantity.
+    // Longer names take one SYMBOL message per 16-byte piece; count is the
+    // piece's offset in the name, so a piece with count 0 starts a new name.
+    void setName(const std::string& name, size_t offset = 0);
+    std::string getName() const;    // this message's piece
+};
+
+static_assert(sizeof(MarketDataFileHeader) == 16, "MarketDataFileHeader must stay fixed width");
+static_assert(sizeof(MarketDataMessage) == 48, "MarketDataMessage must stay fixed width");
+
+// Receives the full incremental stream, synchronously on the publishing thread
+class MarketDataSubscriber {
+public:
+    virtual ~MarketDataSubscriber() = default;
+    virtual void onMessage(const MarketDataMessage& message) = 0;
+    virtual void flush() {}
+};
+
+// Writes the stream to a file through a large buffer
+class MarketDataFileWriter : public MarketDataSubscriber {
+public:
+    MarketDataFileWriter();
+    ~MarketDataFileWriter();
+
+    // Non-copyable: owns the file
+    MarketDataFileWriter(const MarketDataFileWriter&) = delete;
+    MarketDataFileWriter& operator=(const MarketDataFileWriter&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    void onMessage(const MarketDataMessage& message) override;
+    void flush() override;
+
+    uint64_t getMessageCount() const { return messageCount; }
+
+private:
+    static const size_t BUFFER_MESSAGES = 1024;
+
+    std::FILE* file;
+    std::vector<MarketDataMessage> buffer;
+    uint64_t messageCount;
+};
+
+// Conflated top-N depth per symbol for consumers that poll at their own pace.
+// The publisher overwrites a symbol's slot whenever its top levels change; a
+// reader copies the latest version under a sequence lock, so a slow reader
+// skips intermediate states instead of holding up the matching thread.
+class ConflatedDepth {
+public:
+    static const size_t MAX_LEVELS = 10;
+
+    struct Snapshot {
+        uint64_t sequence;          // last message reflected
+        double lastTradePrice;      // 0 until the first trade
+        int64_t lastTradeQuantity;
+        size_t bidCount;
+        size_t askCount;
+        DepthLevel bids[MAX_LEVELS];
+        DepthLevel asks[MAX_LEVELS];
+    };
+
+    // levels is capped at MAX_LEVELS; symbols at or above maxSymbols are not tracked
+    explicit ConflatedDepth(size_t levels = 5, size_t maxSymbols = 1024);
+
+    // Non-copyable (atomics)
+    ConflatedDepth(const ConflatedDepth&) = delete;
+    ConflatedDepth& operator=(const ConflatedDepth&) = delete;
+
+    // Reader side (any thread); false until the symbol has been published
+    bool read(SymbolId symbol, Snapshot& snapshot) const;
+
+    size_t getLevels() const { return levels; }
+    size_t getMaxSymbols() const { return maxSymbols; }
+
+private:
+    friend class MarketDataPublisher;
+
+    static const size_t HEADER_WORDS = 5;   // sequence, trade price, trade quantity, bid count, ask count
+    static const size_t WORDS = HEADER_WORDS + 2 * MAX_LEVELS * 3;
+
+    struct Slot {
+        std::atomic<uint64_t> version;      // odd while a write is in progress, 0 = never written
+        std::atomic<uint64_t> words[WORDS];
+        // Writer-only: how far down each side the published levels reach
+        size_t publishedCount[2];
+        int64_t worstKey[2];                // rank key (tick for asks, -tick for bids)
+    };
+
+    size_t levels;
+    size_t maxSymbols;
+    std::unique_ptr<Slot[]> slots;
+    std::vector<DepthLevel> scratch;
+
+    // Writer side (publishing thread only)
+    bool affects(const LevelUpdate& update) const;
+    void update(const OrderBook& book, uint64_t sequence);
+    void recordTrade(const Fill& fill, uint64_t sequence);
+    void clear(SymbolId symbol, uint64_t sequence);
+    void beginWrite(Slot& slot);
+    void endWrite(Slot& slot);
+};
+
+// Turns OrderBook level changes and trades into the binary L2 stream.
+// Single writer: every attached book must be changed from one thread, the
+// same one that calls the publisher's methods.
+class MarketDataPublisher : public MarketDataListener {
+public:
+    static const size_t DEFAULT_SNAPSHOT_INTERVAL = 10000;
+
+    // A book gets a fresh snapshot after every snapshotInterval of its updates (0 = never)
+    explicit MarketDataPublisher(size_t snapshotInterval = DEFAULT_SNAPSHOT_INTERVAL);
+    ~MarketDataPublisher();
+
+    // Non-copyable: books point back at the publisher
+    MarketDataPublisher(const MarketDataPublisher&) = delete;
+    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+    // Consumers
+    void addSubscriber(MarketDataSubscriber* subscriber);
+    void setConflatedDepth(ConflatedDepth* depth);
+
+    // Books (attach publishes the symbol name and an initial snapshot)
+    void attach(OrderBook& book);
+    void detach(OrderBook& book);
+    void publishSnapshot(const OrderBook& book);
+    void publishSnapshots();
+    void flush();
+
+    // Statistics
+    uint64_t getSequence() const { return sequence; }
+    uint64_t getSnapshotCount() const { return snapshotCount; }
+
+    // MarketDataListener
+    void onLevelUpdate(const LevelUpdate& update) override;
+    void onTrade(const Fill& fill) override;
+    void onIndicative(const AuctionIndicative& indicative) override;
+    void onBookClosed(const OrderBook& book) override;
+
+private:
+    std::vector<MarketDataSubscriber*> subscribers;
+    ConflatedDepth* conflated;
+    std::vector<OrderBook*> books;              // attached books by SymbolId
+    std::vector<size_t> updatesSinceSnapshot;   // by SymbolId
+    size_t snapshotInterval;
+    uint64_t sequence;
+    uint64_t snapshotCount;
+    uint64_t startTicks;
+
+    MarketDataMessage makeMessage(MarketDataMessage::Type type, SymbolId symbol);
+    void emit(const MarketDataMessage& message);
+    void countUpdate(SymbolId symbol);
+};
+
+#endif // MARKETDATAPUBLISHER_H
@@ -1,53 +1,61 @@
 #include "MatchingEngine.h"
-#include <iostream>
+#include "AsyncLogger.h"
 #include <algorithm>
+#include <cstdlib>
 
 // Main matching function using Price-Time Priority (FIFO within price levels)
 std::vector<Trade> MatchingEngine::matchOrders(OrderBook& orderBook) {
     return matchWithPriceTimePriority(orderBook);
 }
 
-// Match orders using Price-Time Priority
+size_t MatchingEngine::matchOrders(OrderBook& orderBook, ExecutionListener& listener) {
+    return matchWithPriceTimePriority(orderBook, listener);
+}
+
+// Match orders using Price-Time Priority, collecting the trades
 std::vector<Trade> MatchingEngine::matchWithPriceTimePriority(OrderBook& orderBook) {
     std::vector<Trade> trades;
+    TradeCollector collector(trades);
+    matchWithPriceTimePriority(orderBook, collector);
+    return trades;
+}
+
+// Match orders using Price-Time Priority
+size_t MatchingEngine::matchWithPriceTimePriority(OrderBook& orderBook, ExecutionListener& listener) {
+    size_t fills = 0;
     
     auto& buyOrders = orderBook.getBuyOrders();
     auto& sellOrders = orderBook.getSellOrders();
     
     while (!buyOrders.empty() && !sellOrders.empty()) {
         // Get best bid (highest price) and best ask (lowest price)
-        auto bestBuyPriceIt = buyOrders.begin();
-        auto bestSellPriceIt = sellOrders.begin();
-        
-        double bestBidPrice = bestBuyPriceIt->first;
-        double bestAskPrice = bestSellPriceIt->first;
+        PriceLevel* bestBuyLevel = buyOrders.best();
+        PriceLevel* bestSellLevel = sellOrders.best();
         
         // Check if prices can cross (match condition)
-        if (!canMatch(bestBidPrice, bestAskPrice)) {
+        if (!canMatch(bestBuyLevel->tick, bestSellLevel->tick)) {
             break; // No more matches possible
         }
         
         // Get the first orders at these price levels (FIFO within price level)
-        auto& buyOrdersAtPrice = bestBuyPriceIt->second;
-        auto& sellOrdersAtPrice = bestSellPriceIt->second;
-        
-        if (buyOrdersAtPrice.empty() || sellOrdersAtPrice.empty()) {
+        if (bestBuyLevel->empty() || bestSellLevel->empty()) {
             // Clean up empty price levels
-            if (buyOrdersAtPrice.empty()) {
-                buyOrders.erase(bestBuyPriceIt);
+            if (bestBuyLevel->empty()) {
+                buyOrders.removeLevel(*bestBuyLevel);
             }
-            if (sellOrdersAtPrice.empty()) {
-                sellOrders.erase(bestSellPriceIt);
+            if (bestSellLevel->empty()) {
+                sellOrders.removeLevel(*bestSellLevel);
             }
             continue;
         }
         
-        auto buyOrder = *buyOrdersAtPrice.begin();
-        auto sellOrder = *sellOrdersAtPrice.begin();
+        Order* buyOrder = bestBuyLevel->front();
+        Order* sellOrder = bestSellLevel->front();
         
         // Validate orders before matching
         if (!validateOrdersForMatching(buyOrder, sellOrder)) {
-            std::cerr << "Invalid orders for matching" << std::endl;
+            AsyncLogger::logEvent(LogLevel::ERROR, LogRecord::INVALID_ORDER_PAIR, orderBook.getSymbolId(),
+                                  buyOrder ? buyOrder->orderId : 0, 0, sellOrder ? sellOrder->orderId : 0);
             break;
         }
         
@@ -55,137 +63,329 @@ std::vector<Trade> MatchingEngine::matchWithPriceTimePriority(OrderBook& orderBo
         int tradeQuantity = std::min(buyOrder->quantity, sellOrder->quantity);
         double tradePrice = determineTradePrice(buyOrder, sellOrder);
         
-        // Create and record the trade
-        Trade trade = createTrade(buyOrder, sellOrder, tradeQuantity, tradePrice);
-        trades.push_back(trade);
-        
-        std::cout << "TRADE EXECUTED: " << trade.toString() << std::endl;
+        // Report the fill
+        Fill fill = createFill(buyOrder, sellOrder, tradeQuantity, tradePrice);
+        listener.onFill(fill);
+        orderBook.publishTrade(fill);
+        ++fills;
         
-        // Update order quantities
-        updateOrderQuantity(buyOrder, tradeQuantity);
-        updateOrderQuantity(sellOrder, tradeQuantity);
+        AsyncLogger::logFill(LogLevel::INFO, LogRecord::TRADE_EXECUTED, fill);
         
-        // Remove fully filled orders
-        if (buyOrder->quantity == 0) {
+        // Update order quantities (both are resting, so through their ladders);
+        // fully filled orders leave the book
+        if (buyOrders.reduceOrder(buyOrder, tradeQuantity)) {
             removeFilledOrder(orderBook, buyOrder);
-            buyOrdersAtPrice.erase(buyOrder);
-            if (buyOrdersAtPrice.empty()) {
-                buyOrders.erase(bestBuyPriceIt);
-            }
         }
-        
-        if (sellOrder->quantity == 0) {
+        if (sellOrders.reduceOrder(sellOrder, tradeQuantity)) {
             removeFilledOrder(orderBook, sellOrder);
-            sellOrdersAtPrice.erase(sellOrder);
-            if (sellOrdersAtPrice.empty()) {
-                sellOrders.erase(bestSellPriceIt);
-            }
         }
     }
     
+    return fills;
+}
+
+// Match a specific new order against existing orders in the book, collecting the trades
+std::vector<Trade> MatchingEngine::matchOrder(OrderBook& orderBook, Order* newOrder) {
+    std::vector<Trade> trades;
+    TradeCollector collector(trades);
+    matchOrder(orderBook, newOrder, collector);
     return trades;
 }
 
 // Match a specific new order against existing orders in the book
-std::vector<Trade> MatchingEngine::matchOrder(OrderBook& orderBook, std::shared_ptr<Order> newOrder) {
-    std::vector<Trade> trades;
-    
+size_t MatchingEngine::matchOrder(OrderBook& orderBook, Order* newOrder, ExecutionListener& listener) {
     if (!newOrder || !newOrder->isValid()) {
-        std::cerr << "Invalid order cannot be matched" << std::endl;
-        return trades;
+        AsyncLogger::logEvent(LogLevel::ERROR, LogRecord::INVALID_ORDER_MATCH, orderBook.getSymbolId(),
+                              newOrder ? newOrder->orderId : 0);
+        orderBook.releaseOrder(newOrder);
+        return 0;
     }
     
-    auto& buyOrders = orderBook.getBuyOrders();
-    auto& sellOrders = orderBook.getSellOrders();
+    // Time priority comes from arrival order in this book, never from a clock
+    newOrder->sequence = orderBook.nextSequence();
     
-    if (newOrder->side == OrderSide::BUY) {
-        // New buy order - match against sell orders
-        while (!sellOrders.empty() && newOrder->quantity > 0) {
-            auto bestSellPriceIt = sellOrders.begin();
-            double bestAskPrice = bestSellPriceIt->first;
-            
-            if (!canMatch(newOrder->price, bestAskPrice)) {
-                break; // No match possible
-            }
-            
-            auto& sellOrdersAtPrice = bestSellPriceIt->second;
-            if (sellOrdersAtPrice.empty()) {
-                sellOrders.erase(bestSellPriceIt);
-                continue;
+    // A call auction only collects limit orders until it uncrosses
+    if (orderBook.isInCall()) {
+        if (newOrder->restsInBook()) {
+            orderBook.addOrder(newOrder);
+            publishIndicative(orderBook);
+        } else {
+            orderBook.releaseOrder(newOrder);
+        }
+        return 0;
+    }
+    
+    bool unlimited = newOrder->type == OrderType::MARKET;
+    int64_t limitTick = unlimited ? 0 : orderBook.priceToTick(newOrder->price);
+    const PriceLadder& resting = (newOrder->side == OrderSide::BUY) ? orderBook.getSellOrders()
+                                                                    : orderBook.getBuyOrders();
+    
+    // Fill-or-kill is decided from the level totals before anything executes
+    size_t fills = 0;
+    if (newOrder->type != OrderType::FOK
+        || canFillCompletely(resting, newOrder->side, limitTick, unlimited, newOrder->quantity)) {
+        fills = sweep(orderBook, newOrder, limitTick, unlimited, listener);
+    }
+    
+    // Only limit orders rest; whatever else is left is cancelled
+    if (newOrder->quantity > 0 && newOrder->restsInBook()) {
+        orderBook.addOrder(newOrder);
+    } else {
+        orderBook.releaseOrder(newOrder);
+    }
+    return fills;
+}
+
+// Modify in place when priority can be kept, otherwise re-enter the order
+bool MatchingEngine::modifyOrder(OrderBook& orderBook, OrderId orderId, int quantity, double price,
+                                 ExecutionListener& listener, size_t& fills) {
+    fills = 0;
+    Order* order = orderBook.getOrder(orderId);
+    if (!order || quantity <= 0 || price <= 0) {
+        return false;
+    }
+    
+    if (quantity <= order->quantity && orderBook.priceToTick(price) == order->level->tick) {
+        PriceLadder& ladder = (order->side == OrderSide::BUY) ? orderBook.getBuyOrders() : orderBook.getSellOrders();
+        ladder.reduceOrder(order, order->quantity - quantity);
+        if (orderBook.isInCall()) {
+            publishIndicative(orderBook);
+        }
+        return true;
+    }
+    
+    orderBook.detachOrder(order);
+    order->quantity = quantity;
+    order->price = price;
+    fills = matchOrder(orderBook, order, listener);
+    return true;
+}
+
+// Sum level totals from the best price until quantity is covered or the limit is passed
+bool MatchingEngine::canFillCompletely(const PriceLadder& resting, OrderSide takerSide,
+                                       int64_t limitTick, bool unlimited, int quantity) {
+    int64_t available = 0;
+    for (const PriceLevel* level = resting.best(); level && available < quantity; level = resting.next(*level)) {
+        bool crosses = (takerSide == OrderSide::BUY) ? canMatch(limitTick, level->tick)
+                                                     : canMatch(level->tick, limitTick);
+        if (!unlimited && !crosses) {
+            break;
+        }
+        available += level->totalQuantity;
+    }
+    return available >= quantity;
+}
+
+namespace {
+    // Fills of one sweep, handed to the listener a batch at a time
+    class FillBatch {
+    public:
+        explicit FillBatch(ExecutionListener& target) : listener(target), count(0) {}
+        ~FillBatch() { flush(); }
+        
+        void add(const Fill& fill) {
+            fills[count++] = fill;
+            if (count == CAPACITY) {
+                flush();
             }
-            
-            auto sellOrder = *sellOrdersAtPrice.begin();
-            
-            int tradeQuantity = std::min(newOrder->quantity, sellOrder->quantity);
-            double tradePrice = sellOrder->price; // Use existing order's price
-            
-            Trade trade = createTrade(newOrder, sellOrder, tradeQuantity, tradePrice);
-            trades.push_back(trade);
-            
-            // Update quantities
-            updateOrderQuantity(newOrder, tradeQuantity);
-            updateOrderQuantity(sellOrder, tradeQuantity);
-            
-            // Remove filled sell order
-            if (sellOrder->quantity == 0) {
-                removeFilledOrder(orderBook, sellOrder);
-                sellOrdersAtPrice.erase(sellOrder);
-                if (sellOrdersAtPrice.empty()) {
-                    sellOrders.erase(bestSellPriceIt);
-                }
+        }
+        void flush() {
+            if (count > 0) {
+                listener.onFills(fills, count);
+                count = 0;
             }
         }
         
-        // Add remaining quantity to buy side if not fully filled
-        if (newOrder->quantity > 0) {
-            orderBook.addOrder(newOrder);
+    private:
+        static const size_t CAPACITY = 32;
+        ExecutionListener& listener;
+        Fill fills[CAPACITY];
+        size_t count;
+    };
+}
+
+// Consume levels best first. The next level is found before a level that is
+// about to empty is removed, so the walk never restarts from the top.
+size_t MatchingEngine::sweep(OrderBook& orderBook, Order* newOrder, int64_t limitTick, bool unlimited,
+                             ExecutionListener& listener) {
+    bool buying = newOrder->side == OrderSide::BUY;
+    PriceLadder& resting = buying ? orderBook.getSellOrders() : orderBook.getBuyOrders();
+    FillBatch batch(listener);
+    size_t fills = 0;
+    
+    PriceLevel* level = resting.best();
+    while (level && newOrder->quantity > 0) {
+        bool crosses = buying ? canMatch(limitTick, level->tick) : canMatch(level->tick, limitTick);
+        if (!unlimited && !crosses) {
+            break; // No match possible
         }
+        PriceLevel* following = (newOrder->quantity >= level->totalQuantity) ? resting.next(*level) : nullptr;
         
-    } else { // OrderSide::SELL
-        // New sell order - match against buy orders
-        while (!buyOrders.empty() && newOrder->quantity > 0) {
-            auto bestBuyPriceIt = buyOrders.begin();
-            double bestBidPrice = bestBuyPriceIt->first;
-            
-            if (!canMatch(bestBidPrice, newOrder->price)) {
-                break; // No match possible
-            }
-            
-            auto& buyOrdersAtPrice = bestBuyPriceIt->second;
-            if (buyOrdersAtPrice.empty()) {
-                buyOrders.erase(bestBuyPriceIt);
-                continue;
-            }
+        // FIFO within the level; a filled resting order leaves the book (and
+        // the last one takes the level with it, so the level is not read again)
+        Order* restingOrder = level->front();
+        while (restingOrder && newOrder->quantity > 0) {
+            Order* nextOrder = restingOrder->nextInLevel;
+            int tradeQuantity = std::min(newOrder->quantity, restingOrder->quantity);
             
-            auto buyOrder = *buyOrdersAtPrice.begin();
+            // Use existing order's price
+            Fill fill = buying ? createFill(newOrder, restingOrder, tradeQuantity, restingOrder->price)
+                               : createFill(restingOrder, newOrder, tradeQuantity, restingOrder->price);
+            batch.add(fill);
+            orderBook.publishTrade(fill);
+            ++fills;
             
-            int tradeQuantity = std::min(newOrder->quantity, buyOrder->quantity);
-            double tradePrice = buyOrder->price; // Use existing order's price
-            
-            Trade trade = createTrade(buyOrder, newOrder, tradeQuantity, tradePrice);
-            trades.push_back(trade);
-            
-            // Update quantities
             updateOrderQuantity(newOrder, tradeQuantity);
-            updateOrderQuantity(buyOrder, tradeQuantity);
-            
-            // Remove filled buy order
-            if (buyOrder->quantity == 0) {
-                removeFilledOrder(orderBook, buyOrder);
-                buyOrdersAtPrice.erase(buyOrder);
-                if (buyOrdersAtPrice.empty()) {
-                    buyOrders.erase(bestBuyPriceIt);
-                }
+            if (resting.reduceOrder(restingOrder, tradeQuantity)) {
+                removeFilledOrder(orderBook, restingOrder);
             }
+            restingOrder = nextOrder;
         }
+        level = following;
+    }
+    return fills;
+}
+
+namespace {
+    // Crossed part of a book for one equilibrium search (reused per thread)
+    struct CrossedDepth {
+        std::vector<const PriceLevel*> bids;    // bid levels at or above the best ask, best first
+        std::vector<int64_t> ticks;             // every crossed level price, ascending
+        std::vector<double> prices;
+        std::vector<int64_t> demand;            // bid quantity at or above the tick
+        std::vector<int64_t> supply;            // ask quantity at or below the tick
         
-        // Add remaining quantity to sell side if not fully filled
-        if (newOrder->quantity > 0) {
-            orderBook.addOrder(newOrder);
+        void clear() {
+            bids.clear();
+            ticks.clear();
+            prices.clear();
+            demand.clear();
+            supply.clear();
         }
+    };
+}
+
+// Build cumulative demand and supply at each crossed level price, then pick
+// the equilibrium. Only levels between the best ask and the best bid are read.
+bool MatchingEngine::findEquilibrium(const OrderBook& orderBook, AuctionIndicative& result) {
+    result = AuctionIndicative();
+    result.symbolId = orderBook.getSymbolId();
+    const PriceLadder& bids = orderBook.getBuyOrders();
+    const PriceLadder& asks = orderBook.getSellOrders();
+    const PriceLevel* bestBid = bids.best();
+    const PriceLevel* bestAsk = asks.best();
+    if (!bestBid || !bestAsk || !canMatch(bestBid->tick, bestAsk->tick)) {
+        return false;
     }
     
-    return trades;
+    static thread_local CrossedDepth depth;
+    depth.clear();
+    int64_t bidTotal = 0;
+    for (const PriceLevel* level = bestBid; level && level->tick >= bestAsk->tick; level = bids.next(*level)) {
+        depth.bids.push_back(level);
+        bidTotal += level->totalQuantity;
+    }
+    
+    // Merge both sides in ascending price: supply grows as asks are passed,
+    // demand shrinks as bids fall below the price
+    const PriceLevel* ask = bestAsk;
+    size_t bidsLeft = depth.bids.size();
+    int64_t supply = 0;
+    int64_t bidsBelow = 0;
+    while (bidsLeft > 0 || (ask && ask->tick <= bestBid->tick)) {
+        const PriceLevel* bid = bidsLeft > 0 ? depth.bids[bidsLeft - 1] : nullptr;
+        bool atAsk = ask && ask->tick <= bestBid->tick && (!bid || ask->tick <= bid->tick);
+        bool atBid = bid && (!atAsk || bid->tick == ask->tick);
+        const PriceLevel* level = atAsk ? ask : bid;
+        depth.ticks.push_back(level->tick);
+        depth.prices.push_back(level->price);
+        if (atAsk) {
+            supply += ask->totalQuantity;
+            ask = asks.next(*ask);
+        }
+        depth.demand.push_back(bidTotal - bidsBelow);
+        depth.supply.push_back(supply);
+        if (atBid) {
+            bidsBelow += bid->totalQuantity;
+            --bidsLeft;
+        }
+    }
+    
+    // Volume rises then falls with price, so the best candidates are adjacent
+    size_t first = 0;
+    size_t last = 0;
+    int64_t bestVolume = -1;
+    int64_t bestSurplus = 0;
+    for (size_t i = 0; i < depth.ticks.size(); ++i) {
+        int64_t volume = std::min(depth.demand[i], depth.supply[i]);
+        int64_t surplus = std::abs(depth.demand[i] - depth.supply[i]);
+        if (volume > bestVolume || (volume == bestVolume && surplus < bestSurplus)) {
+            first = last = i;
+            bestVolume = volume;
+            bestSurplus = surplus;
+        } else if (volume == bestVolume && surplus == bestSurplus) {
+            last = i;
+        }
+    }
+    // Leftover buyers push the price up, leftover sellers down
+    size_t chosen = first + (last - first) / 2;
+    if (depth.demand[last] > depth.supply[last]) {
+        chosen = last;
+    } else if (depth.supply[first] > depth.demand[first]) {
+        chosen = first;
+    }
+    
+    result.tick = depth.ticks[chosen];
+    result.price = depth.prices[chosen];
+    result.volume = bestVolume;
+    result.buySurplus = depth.demand[chosen] - bestVolume;
+    result.sellSurplus = depth.supply[chosen] - bestVolume;
+    return true;
+}
+
+// Pair the best bid and ask orders until the equilibrium volume is done.
+// Every order priced through the equilibrium on the smaller side fills, so
+// the book is left uncrossed.
+size_t MatchingEngine::uncross(OrderBook& orderBook, ExecutionListener& listener, AuctionIndicative& result) {
+    orderBook.setInCall(false);
+    if (!findEquilibrium(orderBook, result)) {
+        return 0;
+    }
+    
+    PriceLadder& bids = orderBook.getBuyOrders();
+    PriceLadder& asks = orderBook.getSellOrders();
+    FillBatch batch(listener);
+    size_t fills = 0;
+    int64_t remaining = result.volume;
+    while (remaining > 0 && !bids.empty() && !asks.empty()) {
+        Order* buyOrder = bids.best()->front();
+        Order* sellOrder = asks.best()->front();
+        int tradeQuantity = static_cast<int>(std::min<int64_t>(std::min(buyOrder->quantity, sellOrder->quantity),
+                                                               remaining));
+        
+        // Everything prints at the equilibrium price
+        Fill fill = createFill(buyOrder, sellOrder, tradeQuantity, result.price);
+        batch.add(fill);
+        orderBook.publishTrade(fill);
+        ++fills;
+        remaining -= tradeQuantity;
+        
+        if (bids.reduceOrder(buyOrder, tradeQuantity)) {
+            removeFilledOrder(orderBook, buyOrder);
+        }
+        if (asks.reduceOrder(sellOrder, tradeQuantity)) {
+            removeFilledOrder(orderBook, sellOrder);
+        }
+    }
+    return fills;
+}
+
+void MatchingEngine::publishIndicative(OrderBook& orderBook) {
+    if (orderBook.getMarketDataListener()) {
+        AuctionIndicative indicative;
+        findEquilibrium(orderBook, indicative);
+        orderBook.publishIndicative(indicative);
+    }
 }
 
 // FIFO matching (same as Price-Time Priority for this implementation)
@@ -193,16 +393,24 @@ std::vector<Trade> MatchingEngine::matchWithFIFO(OrderBook& orderBook) {
     return matchWithPriceTimePriority(orderBook);
 }
 
-// Create a trade between two orders
-Trade MatchingEngine::createTrade(const std::shared_ptr<Order>& buyOrder, 
-                                const std::shared_ptr<Order>& sellOrder,
+// Describe a fill between two orders
+Fill MatchingEngine::createFill(const Order* buyOrder, 
+                                const Order* sellOrder,
                                 int quantity, double price) {
-    return Trade(buyOrder->symbol, buyOrder->orderId, sellOrder->orderId,
-                buyOrder->userId, sellOrder->userId, quantity, price);
+    Fill fill;
+    fill.tradeId = Trade::allocateTradeId();
+    fill.symbolId = buyOrder->symbolId;
+    fill.buyOrderId = buyOrder->orderId;
+    fill.sellOrderId = sellOrder->orderId;
+    fill.buyUserId = buyOrder->userId;
+    fill.sellUserId = sellOrder->userId;
+    fill.quantity = quantity;
+    fill.price = price;
+    return fill;
 }
 
 // Update order quantity after partial execution
-void MatchingEngine::updateOrderQuantity(std::shared_ptr<Order> order, int executedQuantity) {
+void MatchingEngine::updateOrderQuantity(Order* order, int executedQuantity) {
     if (order && executedQuantity > 0) {
         order->quantity -= executedQuantity;
         if (order->quantity < 0) {
@@ -211,17 +419,17 @@ void MatchingEngine::updateOrderQuantity(std::shared_ptr<Order> order, int execu
     }
 }
 
-// Remove completely filled order from lookup table
-void MatchingEngine::removeFilledOrder(OrderBook& orderBook, std::shared_ptr<Order> order) {
+// Remove completely filled order from the directory and free it
+void MatchingEngine::removeFilledOrder(OrderBook& orderBook, Order* order) {
     if (order) {
-        auto& orderLookup = orderBook.getOrderLookup();
-        orderLookup.erase(order->orderId);
+        orderBook.getOrderDirectory().erase(order->orderId);
+        orderBook.releaseOrder(order);
     }
 }
 
 // Validate that orders can be matched
-bool MatchingEngine::validateOrdersForMatching(const std::shared_ptr<Order>& buyOrder,
-                                             const std::shared_ptr<Order>& sellOrder) {
+bool MatchingEngine::validateOrdersForMatching(const Order* buyOrder,
+                                             const Order* sellOrder) {
     if (!buyOrder || !sellOrder) {
         return false;
     }
@@ -230,7 +438,7 @@ bool MatchingEngine::validateOrdersForMatching(const std::shared_ptr<Order>& buy
         return false;
     }
     
-    if (buyOrder->symbol != sellOrder->symbol) {
+    if (buyOrder->symbolId != sellOrder->symbolId) {
         return false;
     }
     
@@ -3,51 +3,91 @@
 
 #include "OrderBook.h"
 #include "Trade.h"
+#include "ExecutionListener.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <memory>
 
 class MatchingEngine {
 public:
     // Main matching function - processes all possible matches in an order book
     static std::vector<Trade> matchOrders(OrderBook& orderBook);
     
-    // Match a specific order against the order book
-    static std::vector<Trade> matchOrder(OrderBook& orderBook, std::shared_ptr<Order> newOrder);
+    // Match a specific order against the order book. The book takes ownership
+    // of newOrder: a limit order's remainder rests; anything else is returned
+    // to the pool (see OrderType for market, IOC and FOK). During a call
+    // auction nothing matches: limit orders rest, others are cancelled.
+    static std::vector<Trade> matchOrder(OrderBook& orderBook, Order* newOrder);
     
     // Helper functions for different matching strategies
     static std::vector<Trade> matchWithFIFO(OrderBook& orderBook);
     static std::vector<Trade> matchWithPriceTimePriority(OrderBook& orderBook);
     
+    // Streaming variants: fills go to the listener in execution order and
+    // nothing is collected or allocated. Return the number of fills.
+    static size_t matchOrders(OrderBook& orderBook, ExecutionListener& listener);
+    static size_t matchOrder(OrderBook& orderBook, Order* newOrder, ExecutionListener& listener);
+    static size_t matchWithPriceTimePriority(OrderBook& orderBook, ExecutionListener& listener);
+    
+    // Cancel/replace of a resting order. A smaller quantity at the same price
+    // is taken off in place and keeps its queue position. Any other change
+    // re-enters the same Order (same id, no allocation) as if it were new: it
+    // matches if the new price crosses, then rests at the back of its level.
+    // During a call nothing matches and the indicative is republished.
+    // False if the order is not resting in this book or the new values are invalid.
+    static bool modifyOrder(OrderBook& orderBook, OrderId orderId, int quantity, double price,
+                            ExecutionListener& listener, size_t& fills);
+    
+    // Whether resting liquidity up to limitTick (any price when unlimited) covers
+    // quantity; reads the per-level totals only, never individual orders
+    static bool canFillCompletely(const PriceLadder& resting, OrderSide takerSide,
+                                  int64_t limitTick, bool unlimited, int quantity);
+    
+    // Call auctions. The equilibrium is the crossed level price executing the
+    // most volume, then leaving the least surplus, then leaning towards the
+    // surplus side (the middle candidate when balanced). Found from cumulative
+    // bid/ask depth in one pass over the crossed levels; false if nothing crosses.
+    static bool findEquilibrium(const OrderBook& orderBook, AuctionIndicative& result);
+    // Execute the equilibrium volume at its single price in price-time
+    // priority and return the book to continuous matching
+    static size_t uncross(OrderBook& orderBook, ExecutionListener& listener, AuctionIndicative& result);
+    // Send the current equilibrium to the book's market data listener, if any
+    static void publishIndicative(OrderBook& orderBook);
+    
 private:
+    // Walk the opposite side best level first, in one pass, filling newOrder
+    static size_t sweep(OrderBook& orderBook, Order* newOrder, int64_t limitTick, bool unlimited,
+                        ExecutionListener& listener);
+    
     // Internal helper functions
-    static Trade createTrade(const std::shared_ptr<Order>& buyOrder, 
-                           const std::shared_ptr<Order>& sellOrder,
+    static Fill createFill(const Order* buyOrder, 
+                           const Order* sellOrder,
                            int quantity, double price);
     
-    static void updateOrderQuantity(std::shared_ptr<Order> order, int executedQuantity);
+    static void updateOrderQuantity(Order* order, int executedQuantity);
     
-    static bool canMatch(double bidPrice, double askPrice);
+    static bool canMatch(int64_t bidTick, int64_t askTick);
     
-    static double determineTradePrice(const std::shared_ptr<Order>& buyOrder,
-                                    const std::shared_ptr<Order>& sellOrder);
+    static double determineTradePrice(const Order* buyOrder,
+                                    const Order* sellOrder);
     
-    static void removeFilledOrder(OrderBook& orderBook, std::shared_ptr<Order> order);
+    static void removeFilledOrder(OrderBook& orderBook, Order* order);
     
     // Validation functions
-    static bool validateOrdersForMatching(const std::shared_ptr<Order>& buyOrder,
-                                        const std::shared_ptr<Order>& sellOrder);
+    static bool validateOrdersForMatching(const Order* buyOrder,
+                                        const Order* sellOrder);
 };
 
 // Inline helper functions for performance
-inline bool MatchingEngine::canMatch(double bidPrice, double askPrice) {
-    return bidPrice >= askPrice;
+inline bool MatchingEngine::canMatch(int64_t bidTick, int64_t askTick) {
+    return bidTick >= askTick;
 }
 
-inline double MatchingEngine::determineTradePrice(const std::shared_ptr<Order>& buyOrder,
-                                                const std::shared_ptr<Order>& sellOrder) {
+inline double MatchingEngine::determineTradePrice(const Order* buyOrder,
+                                                const Order* sellOrder) {
     // Use the price of the order that was placed first (already in the book)
     // This is a common convention in many exchanges
-    return (buyOrder->timestamp < sellOrder->timestamp) ? buyOrder->price : sellOrder->price;
+    return (buyOrder->sequence < sellOrder->sequence) ? buyOrder->price : sellOrder->price;
 }
 
 #endif // MATCHINGENGINE_H
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// On-disk name tables, shared by the order log and snapshots.
+//
+// A name entry is a uint32 byte length, the name itself, then NUL padding to a
+// multiple of 8 bytes, so names of any length survive and whatever follows a
+// table stays 8-byte aligned. A table is its entries back to back; the count
+// is kept in the file's header.
+
+// Entry size: length prefix and name, padded to 8 bytes
+inline size_t nameEntryBytes(size_t length) {
+    return (sizeof(uint32_t) + length + 7) & ~size_t(7);
+}
+
+inline void appendName(std::vector<char>& table, const std::string& name) {
+    size_t at = table.size();
+    uint32_t length = static_cast<uint32_t>(name.size());
+    table.resize(at + nameEntryBytes(name.size()), '\0');
+    std::memcpy(&table[at], &length, sizeof(length));
+    std::memcpy(&table[at + sizeof(length)], name.data(), name.size());
+}
+
+// Read count entries starting at offset and advance it past them; false if
+// the table runs past size
+inline bool readNames(const char* base, size_t size, size_t& offset, uint32_t count,
+                      std::vector<std::string>& names) {
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t length = 0;
+        if (offset > size || size - offset < sizeof(length)) {
+            return false;
+        }
+        std::memcpy(&length, base + offset, sizeof(length));
+        if (size - offset < nameEntryBytes(length)) {
+            return false;
+        }
+        names.emplace_back(base + offset + sizeof(length), length);
+        offset += nameEntryBytes(length);
+    }
+    return true;
+}
+
+#endif // NAMETABLE_H
@@ -1,47 +1,80 @@
 #include "Order.h"
 
 // Initialize static member
-int Order::nextOrderId = 1;
+std::atomic<OrderId> Order::nextOrderId(1);
+
+bool parseOrderType(const std::string& text, OrderType& type) {
+    if (text == "LIMIT" || text == "limit") {
+        type = OrderType::LIMIT;
+    } else if (text == "MARKET" || text == "market") {
+        type = OrderType::MARKET;
+    } else if (text == "IOC" || text == "ioc") {
+        type = OrderType::IOC;
+    } else if (text == "FOK" || text == "fok") {
+        type = OrderType::FOK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* getOrderTypeName(OrderType type) {
+    switch (type) {
+        case OrderType::MARKET: return "MARKET";
+        case OrderType::IOC: return "IOC";
+        case OrderType::FOK: return "FOK";
+        default: return "LIMIT";
+    }
+}
 
 // Constructor
-Order::Order(const std::string& sym, OrderSide s, int qty, double p, 
-             const std::string& user, OrderType t)
-    : orderId(nextOrderId++), symbol(sym), side(s), quantity(qty), 
-      price(p), userId(user), type(t), 
-      timestamp(std::chrono::system_clock::now()) {
+Order::Order(SymbolId sym, OrderSide s, int qty, double p, 
+             UserId user, OrderType t)
+    : Order(allocateOrderId(), sym, s, qty, p, user, t) {
+}
+
+// Constructor with a pre-allocated order ID
+Order::Order(OrderId id, SymbolId sym, OrderSide s, int qty, double p, 
+             UserId user, OrderType t)
+    : orderId(id), symbolId(sym), side(s), quantity(qty), 
+      price(p), sequence(0), type(t), userId(user),
+      prevInLevel(nullptr), nextInLevel(nullptr), level(nullptr) {
 }
 
 // Copy constructor
 Order::Order(const Order& other)
-    : orderId(other.orderId), symbol(other.symbol), side(other.side),
-      quantity(other.quantity), price(other.price), timestamp(other.timestamp),
-      type(other.type), userId(other.userId) {
+    : orderId(other.orderId), symbolId(other.symbolId), side(other.side),
+      quantity(other.quantity), price(other.price), sequence(other.sequence),
+      type(other.type), userId(other.userId),
+      prevInLevel(nullptr), nextInLevel(nullptr), level(nullptr) {
 }
 
 // Assignment operator
 Order& Order::operator=(const Order& other) {
     if (this != &other) {
         orderId = other.orderId;
-        symbol = other.symbol;
+        symbolId = other.symbolId;
         side = other.side;
         quantity = other.quantity;
         price = other.price;
-        timestamp = other.timestamp;
+        sequence = other.sequence;
         type = other.type;
         userId = other.userId;
+        // Queue links are not copied; the copy is not resting anywhere
     }
     return *this;
 }
 
 // Validation
 bool Order::isValid() const {
-    return quantity > 0 && price > 0 && !symbol.empty() && !userId.empty();
+    return quantity > 0 && (price > 0 || type == OrderType::MARKET) &&
+           symbolId != Registry::INVALID_ID && userId != Registry::INVALID_ID;
 }
 
 // String representation
 std::string Order::toString() const {
-    return "Order[" + std::to_string(orderId) + "]: " + symbol + 
+    return "Order[" + std::to_string(orderId) + "]: " + Registry::symbolName(symbolId) + 
            " " + (side == OrderSide::BUY ? "BUY" : "SELL") + 
            " " + std::to_string(quantity) + "@" + std::to_string(price) +
-           " User: " + userId;
+           " User: " + Registry::userName(userId);
 }
\ No newline at end of file
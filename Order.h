@@ -1,30 +1,67 @@
 #ifndef ORDER_H
 #define ORDER_H
 
+#include "Registry.h"
+#include <atomic>
+#include <cstdint>
 #include <string>
-#include <chrono>
 #include <iostream>
 
 enum class OrderSide { BUY, SELL };
-enum class OrderType { MARKET, LIMIT };
+// LIMIT rests whatever does not fill. The others never rest: MARKET takes any
+// price, IOC (immediate-or-cancel) fills what it can up to its limit, FOK
+// (fill-or-kill) fills completely up to its limit or not at all.
+enum class OrderType { MARKET, LIMIT, IOC, FOK };
+
+// Stable one-byte codes for files (0 = LIMIT, so older files read as limit orders)
+inline uint8_t getOrderTypeCode(OrderType type) {
+    switch (type) {
+        case OrderType::MARKET: return 1;
+        case OrderType::IOC: return 2;
+        case OrderType::FOK: return 3;
+        default: return 0;
+    }
+}
+inline OrderType getOrderTypeFromCode(uint8_t code) {
+    static const OrderType types[] = { OrderType::LIMIT, OrderType::MARKET, OrderType::IOC, OrderType::FOK };
+    return code < 4 ? types[code] : OrderType::LIMIT;
+}
+inline bool isOrderTypeCode(uint8_t code) {
+    return code < 4;
+}
+
+// Names used on the command line and in batch files
+bool parseOrderType(const std::string& text, OrderType& type);
+const char* getOrderTypeName(OrderType type);
+
+struct PriceLevel;
 
 class Order {
 private:
-    static int nextOrderId;
+    static std::atomic<OrderId> nextOrderId;
     
 public:
-    int orderId;
-    std::string symbol;
+    OrderId orderId;
+    SymbolId symbolId;
     OrderSide side;
     int quantity;
     double price;
-    std::chrono::system_clock::time_point timestamp;
+    uint64_t sequence;      // time priority within the book, stamped on arrival (0 = not yet)
     OrderType type;
-    std::string userId;
+    UserId userId;
+    
+    // Intrusive links into the resting price level (owned by the order book)
+    Order* prevInLevel;
+    Order* nextInLevel;
+    PriceLevel* level;
     
     // Constructor
-    Order(const std::string& sym, OrderSide s, int qty, double p, 
-          const std::string& user, OrderType t = OrderType::LIMIT);
+    Order(SymbolId sym, OrderSide s, int qty, double p, 
+          UserId user, OrderType t = OrderType::LIMIT);
+    
+    // Constructor with a pre-allocated order ID (see allocateOrderId)
+    Order(OrderId id, SymbolId sym, OrderSide s, int qty, double p, 
+          UserId user, OrderType t = OrderType::LIMIT);
     
     // Copy constructor
     Order(const Order& other);
@@ -35,19 +72,22 @@ public:
     // Destructor
     ~Order() = default;
     
-    // Validation
+    // Validation (market orders carry no price)
     bool isValid() const;
+    bool restsInBook() const { return type == OrderType::LIMIT; }
     
     // String representation
     std::string toString() const;
     
     // Getters
-    int getOrderId() const { return orderId; }
-    const std::string& getSymbol() const { return symbol; }
+    OrderId getOrderId() const { return orderId; }
+    SymbolId getSymbolId() const { return symbolId; }
+    const std::string& getSymbol() const { return Registry::symbolName(symbolId); }
     OrderSide getSide() const { return side; }
     int getQuantity() const { return quantity; }
     double getPrice() const { return price; }
-    const std::string& getUserId() const { return userId; }
+    UserId getUserId() const { return userId; }
+    const std::string& getUserName() const { return Registry::userName(userId); }
     OrderType getType() const { return type; }
     
     // Setters
@@ -55,7 +95,17 @@ public:
     void setPrice(double p) { price = p; }
     
     // Static method to get next order ID
-    static int getNextOrderId() { return nextOrderId; }
+    static OrderId getNextOrderId() { return nextOrderId.load(std::memory_order_relaxed); }
+    
+    // Reserve an order ID ahead of construction (safe from any thread)
+    static OrderId allocateOrderId() { return nextOrderId.fetch_add(1, std::memory_order_relaxed); }
+    
+    // Make later IDs start at next or above (used when restoring saved state)
+    static void advanceNextOrderId(OrderId next) {
+        OrderId current = nextOrderId.load(std::memory_order_relaxed);
+        while (current < next && !nextOrderId.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+        }
+    }
 };
 
 #endif // ORDER_H
\ No newline at end of file
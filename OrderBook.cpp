@@ -1,111 +1,131 @@
 #include "OrderBook.h"
+#include "AsyncLogger.h"
 #include <iomanip>
 #include <limits>
+#include <cmath>
 
-// OrderComparator implementation
-bool OrderComparator::operator()(const std::shared_ptr<Order>& a, const std::shared_ptr<Order>& b) const {
-    if (a->timestamp != b->timestamp) {
-        return a->timestamp < b->timestamp; // FIFO: earlier orders first
+// Constructor
+OrderBook::OrderBook(SymbolId sym, double tick, size_t initialOrderCapacity) 
+    : symbolId(sym), tickSize(tick), buyOrders(true), sellOrders(false),
+      ownDirectory(new OrderDirectory()), directory(ownDirectory.get()),
+      orderPool(initialOrderCapacity), marketDataListener(nullptr), inCall(false), lastSequence(0) {
+}
+
+// Constructor with a shared directory
+OrderBook::OrderBook(SymbolId sym, OrderDirectory& sharedDirectory, double tick, size_t initialOrderCapacity)
+    : symbolId(sym), tickSize(tick), buyOrders(true), sellOrders(false),
+      directory(&sharedDirectory), orderPool(initialOrderCapacity), marketDataListener(nullptr), inCall(false),
+      lastSequence(0) {
+}
+
+// Destructor - take every resting order out of the directory and return it to the pool
+OrderBook::~OrderBook() {
+    if (marketDataListener) {
+        marketDataListener->onBookClosed(*this);
+    }
+    for (const PriceLadder* ladder : { &buyOrders, &sellOrders }) {
+        for (const PriceLevel* level = ladder->best(); level; level = ladder->next(*level)) {
+            Order* order = level->head;
+            while (order) {
+                Order* next = order->nextInLevel;
+                directory->erase(order->orderId);
+                orderPool.release(order);
+                order = next;
+            }
+        }
     }
-    return a->orderId < b->orderId; // Fallback to order ID for deterministic ordering
 }
 
-// Constructor
-OrderBook::OrderBook(const std::string& sym) : symbol(sym) {
+// Construct a new order in the book's pool
+Order* OrderBook::createOrder(OrderSide side, int quantity, double price,
+                              UserId user, OrderType type) {
+    return orderPool.acquire(symbolId, side, quantity, price, user, type);
 }
 
-// Copy constructor
-OrderBook::OrderBook(const OrderBook& other) 
-    : symbol(other.symbol), buyOrders(other.buyOrders), 
-      sellOrders(other.sellOrders), orderLookup(other.orderLookup) {
+// Construct a new order with a pre-allocated ID
+Order* OrderBook::createOrder(OrderId orderId, OrderSide side, int quantity, double price,
+                              UserId user, OrderType type) {
+    return orderPool.acquire(orderId, symbolId, side, quantity, price, user, type);
 }
 
-// Assignment operator
-OrderBook& OrderBook::operator=(const OrderBook& other) {
-    if (this != &other) {
-        symbol = other.symbol;
-        buyOrders = other.buyOrders;
-        sellOrders = other.sellOrders;
-        orderLookup = other.orderLookup;
-    }
-    return *this;
+// Return an order that is not resting in the book to the pool
+void OrderBook::releaseOrder(Order* order) {
+    orderPool.release(order);
 }
 
 // Add order to the book
-void OrderBook::addOrder(std::shared_ptr<Order> order) {
+void OrderBook::addOrder(Order* order) {
     if (!order || !order->isValid()) {
-        std::cerr << "Invalid order cannot be added to order book" << std::endl;
+        if (order) {
+            AsyncLogger::logOrder(LogLevel::ERROR, LogRecord::INVALID_ORDER_ADD, *order);
+        }
+        releaseOrder(order);
         return;
     }
     
-    // Add to lookup map for fast access
-    orderLookup[order->orderId] = order;
+    // Snap the price onto the tick grid so equal prices share a level
+    int64_t tick = priceToTick(order->price);
+    order->price = tickToPrice(tick);
     
-    // Add to appropriate side of the book
-    if (order->side == OrderSide::BUY) {
-        buyOrders[order->price].insert(order);
-    } else {
-        sellOrders[order->price].insert(order);
+    // Orders added without matching (restores) queue in the order they are added
+    if (order->sequence == 0) {
+        order->sequence = nextSequence();
     }
+    
+    // Index by ID for cancels and lookups
+    directory->insert(order);
+    
+    // Add to appropriate side of the book
+    PriceLadder& ladder = (order->side == OrderSide::BUY) ? buyOrders : sellOrders;
+    ladder.insertOrder(ladder.getOrCreate(tick, order->price), order);
 }
 
 // Cancel order from the book
-bool OrderBook::cancelOrder(int orderId) {
-    auto it = orderLookup.find(orderId);
-    if (it == orderLookup.end()) {
+bool OrderBook::cancelOrder(OrderId orderId) {
+    Order* order = getOrder(orderId);
+    if (!order) {
         return false; // Order not found
     }
     
-    auto order = it->second;
-    
-    // Remove from appropriate side
-    if (order->side == OrderSide::BUY) {
-        auto priceIt = buyOrders.find(order->price);
-        if (priceIt != buyOrders.end()) {
-            auto& priceLevel = priceIt->second;
-            priceLevel.erase(order);
-            if (priceLevel.empty()) {
-                buyOrders.erase(priceIt);
-            }
-        }
-    } else {
-        auto priceIt = sellOrders.find(order->price);
-        if (priceIt != sellOrders.end()) {
-            auto& priceLevel = priceIt->second;
-            priceLevel.erase(order);
-            if (priceLevel.empty()) {
-                sellOrders.erase(priceIt);
-            }
-        }
-    }
+    // Unlink from its price level in O(1)
+    PriceLadder& ladder = (order->side == OrderSide::BUY) ? buyOrders : sellOrders;
+    ladder.removeOrder(order);
     
-    // Remove from lookup
-    orderLookup.erase(orderId);
+    // Remove from the directory and free the record
+    directory->erase(orderId);
+    orderPool.release(order);
     return true;
 }
 
-// Get order by ID
-std::shared_ptr<Order> OrderBook::getOrder(int orderId) const {
-    auto it = orderLookup.find(orderId);
-    return (it != orderLookup.end()) ? it->second : nullptr;
+// Take a resting order out of its level and the directory
+void OrderBook::detachOrder(Order* order) {
+    PriceLadder& ladder = (order->side == OrderSide::BUY) ? buyOrders : sellOrders;
+    ladder.removeOrder(order);
+    directory->erase(order->orderId);
+}
+
+// Get order by ID (a shared directory also holds other books' orders)
+Order* OrderBook::getOrder(OrderId orderId) const {
+    Order* order = directory->find(orderId);
+    return (order && order->symbolId == symbolId) ? order : nullptr;
 }
 
 // Display order book summary
 void OrderBook::displayOrderBook() const {
-    std::cout << "\n=== Order Book for " << symbol << " ===" << std::endl;
+    std::cout << "\n=== Order Book for " << getSymbol() << " ===" << std::endl;
     
     // Display sell orders (asks) in descending price order
     std::cout << "SELL ORDERS (ASKS):" << std::endl;
     if (sellOrders.empty()) {
         std::cout << "  No sell orders" << std::endl;
     } else {
-        for (auto it = sellOrders.rbegin(); it != sellOrders.rend(); ++it) {
-            int totalQty = 0;
-            for (const auto& order : it->second) {
-                totalQty += order->quantity;
-            }
-            std::cout << "  $" << std::fixed << std::setprecision(2) << it->first 
-                     << " x " << totalQty << " (" << it->second.size() << " orders)" << std::endl;
+        std::vector<const PriceLevel*> askLevels;
+        for (const PriceLevel* level = sellOrders.best(); level; level = sellOrders.next(*level)) {
+            askLevels.push_back(level);
+        }
+        for (auto it = askLevels.rbegin(); it != askLevels.rend(); ++it) {
+            std::cout << "  $" << std::fixed << std::setprecision(2) << (*it)->price 
+                     << " x " << (*it)->totalQuantity << " (" << (*it)->orderCount << " orders)" << std::endl;
         }
     }
     
@@ -118,15 +138,10 @@ void OrderBook::displayOrderBook() const {
     if (buyOrders.empty()) {
         std::cout << "  No buy orders" << std::endl;
     } else {
-        for (const auto& entry : buyOrders) {
-            const auto& price = entry.first;
-            const auto& orders = entry.second;
-            int totalQty = 0;
-            for (const auto& order : orders) {
-                totalQty += order->quantity;
-            }
+        for (const PriceLevel* level = buyOrders.best(); level; level = buyOrders.next(*level)) {
+            const auto& price = level->price;
             std::cout << "  $" << std::fixed << std::setprecision(2) << price 
-                      << " x " << totalQty << " (" << orders.size() << " orders)" << std::endl;
+                      << " x " << level->totalQuantity << " (" << level->orderCount << " orders)" << std::endl;
         }
     }
     
@@ -135,57 +150,54 @@ void OrderBook::displayOrderBook() const {
 
 // Display detailed order book
 void OrderBook::displayOrderBookDetailed() const {
-    std::cout << "\n=== Detailed Order Book for " << symbol << " ===" << std::endl;
+    std::cout << "\n=== Detailed Order Book for " << getSymbol() << " ===" << std::endl;
     
     std::cout << "SELL ORDERS:" << std::endl;
-    for (auto it = sellOrders.rbegin(); it != sellOrders.rend(); ++it) {
-        std::cout << "  Price $" << std::fixed << std::setprecision(2) << it->first << ":" << std::endl;
-        for (const auto& order : it->second) {
+    std::vector<const PriceLevel*> askLevels;
+    for (const PriceLevel* level = sellOrders.best(); level; level = sellOrders.next(*level)) {
+        askLevels.push_back(level);
+    }
+    for (auto it = askLevels.rbegin(); it != askLevels.rend(); ++it) {
+        std::cout << "  Price $" << std::fixed << std::setprecision(2) << (*it)->price << ":" << std::endl;
+        for (const Order* order = (*it)->head; order; order = order->nextInLevel) {
             std::cout << "    " << order->toString() << std::endl;
         }
     }
     
     std::cout << "BUY ORDERS:" << std::endl;
-    for (auto it = buyOrders.begin(); it != buyOrders.end(); ++it) {
-        const double& price = it->first;
-        const auto& orders = it->second;
+    for (const PriceLevel* level = buyOrders.best(); level; level = buyOrders.next(*level)) {
+        const double& price = level->price;
         std::cout << "  Price $" << std::fixed << std::setprecision(2) << price << ":" << std::endl;
-        for (const auto& order : orders) {
+        for (const Order* order = level->head; order; order = order->nextInLevel) {
             std::cout << "    " << order->toString() << std::endl;
         }
     }
 }
 
 // Getters for matching engine (non-const)
-std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>, std::greater<double>>& 
-OrderBook::getBuyOrders() {
+PriceLadder& OrderBook::getBuyOrders() {
     return buyOrders;
 }
 
-std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>>& 
-OrderBook::getSellOrders() {
+PriceLadder& OrderBook::getSellOrders() {
     return sellOrders;
 }
 
-std::unordered_map<int, std::shared_ptr<Order>>& 
-OrderBook::getOrderLookup() {
-    return orderLookup;
+OrderDirectory& OrderBook::getOrderDirectory() {
+    return *directory;
 }
 
 // Const versions
-const std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>, std::greater<double>>& 
-OrderBook::getBuyOrders() const {
+const PriceLadder& OrderBook::getBuyOrders() const {
     return buyOrders;
 }
 
-const std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>>& 
-OrderBook::getSellOrders() const {
+const PriceLadder& OrderBook::getSellOrders() const {
     return sellOrders;
 }
 
-const std::unordered_map<int, std::shared_ptr<Order>>& 
-OrderBook::getOrderLookup() const {
-    return orderLookup;
+const OrderDirectory& OrderBook::getOrderDirectory() const {
+    return *directory;
 }
 
 // Utility functions
@@ -193,36 +205,33 @@ bool OrderBook::isEmpty() const {
     return buyOrders.empty() && sellOrders.empty();
 }
 
-size_t OrderBook::getBuyOrderCount() const {
-    size_t count = 0;
-    for (const auto& pair : buyOrders) {
-        const auto& price = pair.first;
-        const auto& orders = pair.second;
-        count += orders.size();
-    }
-    return count;
-}
-
-size_t OrderBook::getSellOrderCount() const {
-    size_t count = 0;
-    for (const auto& elem : sellOrders) {
-        const auto& price = elem.first;
-        const auto& orders = elem.second;
-        count += orders.size();
+// Attach (or with nullptr detach) a market data listener to both sides
+void OrderBook::setMarketDataListener(MarketDataListener* listener) {
+    marketDataListener = listener;
+    buyOrders.setListener(listener, symbolId);
+    sellOrders.setListener(listener, symbolId);
+}
+
+// Top levels of one side with their aggregated quantity and order count
+void OrderBook::getDepth(OrderSide side, size_t maxLevels, std::vector<DepthLevel>& levels) const {
+    levels.clear();
+    const PriceLadder& ladder = (side == OrderSide::BUY) ? buyOrders : sellOrders;
+    for (const PriceLevel* level = ladder.best(); level && levels.size() < maxLevels;
+         level = ladder.next(*level)) {
+        DepthLevel depth;
+        depth.price = level->price;
+        depth.quantity = level->totalQuantity;
+        depth.orderCount = level->orderCount;
+        levels.push_back(depth);
     }
-    return count;
-}
-
-size_t OrderBook::getTotalOrderCount() const {
-    return getBuyOrderCount() + getSellOrderCount();
 }
 
 double OrderBook::getBestBidPrice() const {
-    return buyOrders.empty() ? 0.0 : buyOrders.begin()->first;
+    return buyOrders.empty() ? 0.0 : buyOrders.best()->price;
 }
 
 double OrderBook::getBestAskPrice() const {
-    return sellOrders.empty() ? std::numeric_limits<double>::max() : sellOrders.begin()->first;
+    return sellOrders.empty() ? std::numeric_limits<double>::max() : sellOrders.best()->price;
 }
 
 double OrderBook::getSpread() const {
@@ -230,4 +239,9 @@ double OrderBook::getSpread() const {
         return std::numeric_limits<double>::max();
     }
     return getBestAskPrice() - getBestBidPrice();
+}
+
+// Convert a price to the nearest whole tick
+int64_t OrderBook::priceToTick(double price) const {
+    return static_cast<int64_t>(std::llround(price / tickSize));
 }
\ No newline at end of file
@@ -2,66 +2,128 @@
 #define ORDERBOOK_H
 
 #include "Order.h"
-#include <map>
-#include <set>
-#include <unordered_map>
+#include "PriceLadder.h"
+#include "OrderPool.h"
+#include "OrderDirectory.h"
+#include "MarketDataListener.h"
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <iostream>
 
-// Comparator for time-based ordering within price levels (FIFO)
-struct OrderComparator {
-    bool operator()(const std::shared_ptr<Order>& a, const std::shared_ptr<Order>& b) const;
+// One aggregated price level, as reported by OrderBook::getDepth
+struct DepthLevel {
+    double price;
+    int64_t quantity;
+    size_t orderCount;
 };
 
 class OrderBook {
 private:
-    std::string symbol;
+    SymbolId symbolId;
+    double tickSize;
     // Buy orders: higher price first, then FIFO
-    std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>, std::greater<double>> buyOrders;
+    PriceLadder buyOrders;
     // Sell orders: lower price first, then FIFO
-    std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>> sellOrders;
-    // Fast order lookup by ID
-    std::unordered_map<int, std::shared_ptr<Order>> orderLookup;
+    PriceLadder sellOrders;
+    // Resting orders by ID (the book owns every order it holds): the owner's
+    // directory shared by all its books, or this book's own
+    std::unique_ptr<OrderDirectory> ownDirectory;
+    OrderDirectory* directory;
+    // Storage for this book's orders
+    OrderPool orderPool;
+    // Depth and trade observer (null = none)
+    MarketDataListener* marketDataListener;
+    // Call auction phase: orders accumulate without matching
+    bool inCall;
+    // Last arrival sequence handed out (time priority)
+    uint64_t lastSequence;
     
 public:
     // Constructor
-    explicit OrderBook(const std::string& sym);
+    explicit OrderBook(SymbolId sym, double tick = 0.01,
+                       size_t initialOrderCapacity = OrderPool::DEFAULT_CAPACITY);
+    
+    // Constructor indexing orders in a directory shared with other books (which must outlive this one)
+    OrderBook(SymbolId sym, OrderDirectory& sharedDirectory, double tick = 0.01,
+              size_t initialOrderCapacity = OrderPool::DEFAULT_CAPACITY);
     
     // Destructor
-    ~OrderBook() = default;
+    ~OrderBook();
     
-    // Copy constructor
-    OrderBook(const OrderBook& other);
+    // Non-copyable: resting orders are linked into this book's levels
+    OrderBook(const OrderBook& other) = delete;
+    OrderBook& operator=(const OrderBook& other) = delete;
     
-    // Assignment operator
-    OrderBook& operator=(const OrderBook& other);
+    // Order allocation from the book's pool
+    Order* createOrder(OrderSide side, int quantity, double price,
+                       UserId user, OrderType type = OrderType::LIMIT);
+    Order* createOrder(OrderId orderId, OrderSide side, int quantity, double price,
+                       UserId user, OrderType type = OrderType::LIMIT);
+    void releaseOrder(Order* order);
+    // Next arrival sequence: a lower sequence arrived first
+    uint64_t nextSequence() { return ++lastSequence; }
+    const OrderPool& getOrderPool() const { return orderPool; }
     
-    // Order management
-    void addOrder(std::shared_ptr<Order> order);
-    bool cancelOrder(int orderId);
-    std::shared_ptr<Order> getOrder(int orderId) const;
+    // Order management (the book takes ownership of added orders)
+    void addOrder(Order* order);
+    bool cancelOrder(OrderId orderId);
+    void detachOrder(Order* order);     // unlink a resting order without freeing it; the caller owns it
+    Order* getOrder(OrderId orderId) const;     // resting in this book only
     
     // Display functions
     void displayOrderBook() const;
     void displayOrderBookDetailed() const;
     
     // Getters for matching engine
-    std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>, std::greater<double>>& getBuyOrders();
-    std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>>& getSellOrders();
-    std::unordered_map<int, std::shared_ptr<Order>>& getOrderLookup();
+    PriceLadder& getBuyOrders();
+    PriceLadder& getSellOrders();
+    OrderDirectory& getOrderDirectory();
     
     // Const versions for read-only access
-    const std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>, std::greater<double>>& getBuyOrders() const;
-    const std::map<double, std::set<std::shared_ptr<Order>, OrderComparator>>& getSellOrders() const;
-    const std::unordered_map<int, std::shared_ptr<Order>>& getOrderLookup() const;
+    const PriceLadder& getBuyOrders() const;
+    const PriceLadder& getSellOrders() const;
+    const OrderDirectory& getOrderDirectory() const;
+    
+    // Price <-> tick conversion
+    double getTickSize() const { return tickSize; }
+    int64_t priceToTick(double price) const;
+    double tickToPrice(int64_t tick) const { return tick * tickSize; }
     
     // Utility functions
-    const std::string& getSymbol() const { return symbol; }
+    SymbolId getSymbolId() const { return symbolId; }
+    const std::string& getSymbol() const { return Registry::symbolName(symbolId); }
     bool isEmpty() const;
-    size_t getBuyOrderCount() const;
-    size_t getSellOrderCount() const;
-    size_t getTotalOrderCount() const;
+    
+    // Aggregates (O(1), maintained as orders change)
+    size_t getBuyOrderCount() const { return buyOrders.getOrderCount(); }
+    size_t getSellOrderCount() const { return sellOrders.getOrderCount(); }
+    size_t getTotalOrderCount() const { return getBuyOrderCount() + getSellOrderCount(); }
+    int64_t getBuyQuantity() const { return buyOrders.getTotalQuantity(); }
+    int64_t getSellQuantity() const { return sellOrders.getTotalQuantity(); }
+    size_t getBuyLevelCount() const { return buyOrders.getLevelCount(); }
+    size_t getSellLevelCount() const { return sellOrders.getLevelCount(); }
+    
+    // Market data: the listener sees every level change and trade print
+    void setMarketDataListener(MarketDataListener* listener);
+    MarketDataListener* getMarketDataListener() const { return marketDataListener; }
+    void publishTrade(const Fill& fill) {
+        if (marketDataListener) {
+            marketDataListener->onTrade(fill);
+        }
+    }
+    void publishIndicative(const AuctionIndicative& indicative) {
+        if (marketDataListener) {
+            marketDataListener->onIndicative(indicative);
+        }
+    }
+    
+    // Call auction phase (see MatchingEngine::uncross)
+    bool isInCall() const { return inCall; }
+    void setInCall(bool enabled) { inCall = enabled; }
+    
+    // Best maxLevels levels of one side, best first (O(maxLevels); reuses the vector's storage)
+    void getDepth(OrderSide side, size_t maxLevels, std::vector<DepthLevel>& levels) const;
     
     // Best price getters
     double getBestBidPrice() const;
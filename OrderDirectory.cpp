@@ -0,0 +1,78 @@
+#include "OrderDirectory.h"
+#include <algorithm>
+
+OrderDirectory::OrderDirectory() : firstPage(0), count(0) {
+}
+
+// Page for a page number, creating it (and widening the window) if needed
+OrderDirectory::Page* OrderDirectory::ensurePage(OrderId page) {
+    if (pages.empty()) {
+        firstPage = page;
+    } else {
+        while (page < firstPage) {
+            pages.emplace_front();
+            --firstPage;
+        }
+    }
+    size_t index = static_cast<size_t>(page - firstPage);
+    if (index >= pages.size()) {
+        pages.resize(index + 1);
+    }
+    std::unique_ptr<Page>& entry = pages[index];
+    if (!entry) {
+        if (spare) {
+            entry = std::move(spare);   // freed pages are already all null
+        } else {
+            entry.reset(new Page);
+            std::fill(entry->orders, entry->orders + PAGE_SIZE, nullptr);
+            entry->live = 0;
+        }
+    }
+    return entry.get();
+}
+
+void OrderDirectory::insert(Order* order) {
+    Page* page = ensurePage(order->orderId >> PAGE_BITS);
+    Order*& slot = page->orders[order->orderId & (PAGE_SIZE - 1)];
+    if (!slot) {
+        ++page->live;
+        ++count;
+    }
+    slot = order;
+}
+
+void OrderDirectory::erase(OrderId orderId) {
+    OrderId page = orderId >> PAGE_BITS;
+    if (page < firstPage || page - firstPage >= pages.size()) {
+        return;
+    }
+    size_t index = static_cast<size_t>(page - firstPage);
+    Page* entries = pages[index].get();
+    if (!entries || !entries->orders[orderId & (PAGE_SIZE - 1)]) {
+        return;
+    }
+    entries->orders[orderId & (PAGE_SIZE - 1)] = nullptr;
+    --entries->live;
+    --count;
+    // The newest page stays: new ids land there, so freeing it would churn
+    if (entries->live == 0 && index + 1 < pages.size()) {
+        freePage(index);
+    }
+}
+
+// Release an empty page and drop the empty pages at the front of the window
+void OrderDirectory::freePage(size_t index) {
+    spare = std::move(pages[index]);
+    while (!pages.empty() && !pages.front()) {
+        pages.pop_front();
+        ++firstPage;
+    }
+}
+
+size_t OrderDirectory::getPageCount() const {
+    size_t allocated = 0;
+    for (const auto& page : pages) {
+        allocated += page ? 1 : 0;
+    }
+    return allocated;
+}
@@ -0,0 +1,61 @@
+#ifndef ORDERDIRECTORY_H
+#define ORDERDIRECTORY_H
+
+#include "Order.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+// Resting orders by id, shared by every book of one matching thread.
+// Order ids are dense and increasing, so the directory is a paged array
+// indexed by the id itself: a lookup is a shift, a mask and two loads, with
+// no hashing. The Order found carries its symbol (the book) and its level
+// links (its slot in the queue), so a cancel by id alone is O(1).
+// Pages cover PAGE_SIZE consecutive ids and are dropped from the front as
+// their orders go, so memory follows the live id range, not the session's.
+// Not thread-safe: one matching thread owns a directory.
+class OrderDirectory {
+public:
+    static const size_t PAGE_BITS = 12;
+    static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+    OrderDirectory();
+
+    // Non-copyable: pages are owned
+    OrderDirectory(const OrderDirectory&) = delete;
+    OrderDirectory& operator=(const OrderDirectory&) = delete;
+
+    // Null when no resting order has the id
+    Order* find(OrderId orderId) const {
+        OrderId page = orderId >> PAGE_BITS;
+        if (page < firstPage || page - firstPage >= pages.size()) {
+            return nullptr;
+        }
+        const Page* entries = pages[page - firstPage].get();
+        return entries ? entries->orders[orderId & (PAGE_SIZE - 1)] : nullptr;
+    }
+
+    void insert(Order* order);      // replaces any order already under the id
+    void erase(OrderId orderId);
+
+    // Statistics
+    size_t size() const { return count; }
+    size_t getPageCount() const;
+
+private:
+    struct Page {
+        Order* orders[PAGE_SIZE];
+        size_t live;
+    };
+
+    std::deque<std::unique_ptr<Page>> pages;   // pages[i] covers page number firstPage + i
+    OrderId firstPage;
+    size_t count;
+    std::unique_ptr<Page> spare;                // last freed page, reused before allocating
+
+    Page* ensurePage(OrderId page);
+    void freePage(size_t index);
+};
+
+#endif // ORDERDIRECTORY_H
@@ -0,0 +1,364 @@
+#include "OrderLog.h"
+#include "MatchingEngine.h"
+#include "NameTable.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // Order ids relative to the replay's first, hashed as 32 bits so digests
+    // stay comparable with builds that had 32-bit order ids
+    uint32_t relativeId(OrderId orderId, OrderId baseOrderId) {
+        return static_cast<uint32_t>(orderId - baseOrderId);
+    }
+
+    // Folds each fill into the trade digest as the engine produces it
+    struct FillDigest : public ExecutionListener {
+        const OrderBook& book;
+        OrderId baseOrderId;
+        uint64_t& digest;
+
+        FillDigest(const OrderBook& book, OrderId baseOrderId, uint64_t& digest)
+            : book(book), baseOrderId(baseOrderId), digest(digest) {}
+
+        void onFill(const Fill& fill) override {
+            fnvMix(digest, fill.symbolId);
+            fnvMix(digest, relativeId(fill.buyOrderId, baseOrderId));
+            fnvMix(digest, relativeId(fill.sellOrderId, baseOrderId));
+            fnvMix(digest, fill.quantity);
+            fnvMix(digest, book.priceToTick(fill.price));
+        }
+    };
+}
+
+// Intern a name into a writer table
+uint32_t OrderLogWriter::indexOf(const std::string& name, std::vector<std::string>& names,
+                                 std::unordered_map<std::string, uint32_t>& index) {
+    auto it = index.find(name);
+    if (it != index.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    index.emplace(name, id);
+    return id;
+}
+
+// Append a new-order event
+void OrderLogWriter::addNewOrder(uint64_t timestampNs, uint64_t ref, const std::string& user,
+                                 const std::string& symbol, OrderSide side, int quantity, double price,
+                                 OrderType type) {
+    OrderLogEvent event = {};
+    event.timestampNs = timestampNs;
+    event.ref = ref;
+    event.price = price;
+    event.quantity = static_cast<uint32_t>(quantity);
+    event.userIndex = indexOf(user, users, userIndex);
+    event.symbolIndex = static_cast<uint16_t>(indexOf(symbol, symbols, symbolIndex));
+    event.type = OrderLogEvent::NEW_ORDER;
+    event.side = (side == OrderSide::BUY) ? 0 : 1;
+    event.orderType = getOrderTypeCode(type);
+    events.push_back(event);
+}
+
+// Append a cancel event
+void OrderLogWriter::addCancel(uint64_t timestampNs, uint64_t ref) {
+    OrderLogEvent event = {};
+    event.timestampNs = timestampNs;
+    event.ref = ref;
+    event.type = OrderLogEvent::CANCEL_ORDER;
+    events.push_back(event);
+}
+
+// Append a modify event
+void OrderLogWriter::addModify(uint64_t timestampNs, uint64_t ref, int quantity, double price) {
+    OrderLogEvent event = {};
+    event.timestampNs = timestampNs;
+    event.ref = ref;
+    event.price = price;
+    event.quantity = static_cast<uint32_t>(quantity);
+    event.type = OrderLogEvent::MODIFY_ORDER;
+    events.push_back(event);
+}
+
+// Append a call auction open or uncross event
+void OrderLogWriter::addAuction(uint64_t timestampNs, const std::string& symbol, OrderLogEvent::Type type) {
+    OrderLogEvent event = {};
+    event.timestampNs = timestampNs;
+    event.symbolIndex = static_cast<uint16_t>(indexOf(symbol, symbols, symbolIndex));
+    event.type = type;
+    events.push_back(event);
+}
+
+// Write header, name tables and events
+bool OrderLogWriter::write(const std::string& path) const {
+    if (symbols.size() > 0xFFFF) {
+        std::cerr << "Order log supports at most 65535 symbols" << std::endl;
+        return false;
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Cannot create order log: " << path << std::endl;
+        return false;
+    }
+
+    OrderLogHeader header = {};
+    std::memcpy(header.magic, ORDER_LOG_MAGIC, sizeof(header.magic));
+    header.version = ORDER_LOG_VERSION;
+    header.symbolCount = static_cast<uint32_t>(symbols.size());
+    header.userCount = static_cast<uint32_t>(users.size());
+    header.eventCount = events.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<char> names;
+    for (const auto* table : { &symbols, &users }) {
+        for (const auto& name : *table) {
+            appendName(names, name);
+        }
+    }
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+    file.write(reinterpret_cast<const char*>(events.data()),
+               static_cast<std::streamsize>(events.size() * sizeof(OrderLogEvent)));
+    return static_cast<bool>(file);
+}
+
+// Constructor
+OrderLogReplayer::OrderLogReplayer()
+    : mapping(nullptr), mappingSize(0), header(nullptr), events(nullptr), baseOrderId(0) {
+}
+
+// Destructor
+OrderLogReplayer::~OrderLogReplayer() {
+    close();
+}
+
+// Map a log file and resolve its name tables
+bool OrderLogReplayer::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open order log: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(OrderLogHeader)) {
+        std::cerr << "Order log is truncated: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    mappingSize = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Cannot map order log: " << path << std::endl;
+        mapping = nullptr;
+        mappingSize = 0;
+        return false;
+    }
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    const char* base = static_cast<const char*>(mapping);
+    const OrderLogHeader* candidate = reinterpret_cast<const OrderLogHeader*>(base);
+    std::vector<std::string> symbolNames;
+    std::vector<std::string> userNames;
+    size_t eventOffset = sizeof(OrderLogHeader);
+    if (std::memcmp(candidate->magic, ORDER_LOG_MAGIC, sizeof(candidate->magic)) != 0
+            || candidate->version != ORDER_LOG_VERSION
+            || !readNames(base, mappingSize, eventOffset, candidate->symbolCount, symbolNames)
+            || !readNames(base, mappingSize, eventOffset, candidate->userCount, userNames)
+            || (mappingSize - eventOffset) / sizeof(OrderLogEvent) < candidate->eventCount) {
+        std::cerr << "Not a valid order log: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    header = candidate;
+    events = reinterpret_cast<const OrderLogEvent*>(base + eventOffset);
+
+    symbolIds.resize(header->symbolCount);
+    for (uint32_t i = 0; i < header->symbolCount; ++i) {
+        symbolIds[i] = Registry::internSymbol(symbolNames[i]);
+    }
+    userIds.resize(header->userCount);
+    for (uint32_t i = 0; i < header->userCount; ++i) {
+        userIds[i] = Registry::internUser(userNames[i]);
+    }
+    return true;
+}
+
+// Release the mapping and any books from a previous replay
+void OrderLogReplayer::close() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    events = nullptr;
+    symbolIds.clear();
+    userIds.clear();
+    books.clear();
+}
+
+// Book for a symbol, created on first use
+OrderBook& OrderLogReplayer::bookFor(SymbolId symbol) {
+    if (symbol >= books.size()) {
+        books.resize(symbol + 1);
+    }
+    if (!books[symbol]) {
+        books[symbol].reset(new OrderBook(symbol, directory));
+    }
+    return *books[symbol];
+}
+
+// Match one new order and fold its fills into the trade digest
+OrderId OrderLogReplayer::submit(SymbolId symbol, UserId userId, OrderSide side, int quantity, double price,
+                                 OrderType type, ReplayResult& result) {
+    OrderBook& book = bookFor(symbol);
+    Order* order = book.createOrder(side, quantity, price, userId, type);
+    OrderId orderId = order->getOrderId();
+    FillDigest digest(book, baseOrderId, result.tradeDigest);
+    result.trades += MatchingEngine::matchOrder(book, order, digest);
+    return orderId;
+}
+
+// Hash every resting order, book by book, in priority order
+uint64_t OrderLogReplayer::digestBooks(size_t& restingOrders) const {
+    uint64_t hash = FNV_OFFSET;
+    restingOrders = 0;
+    for (const auto& book : books) {
+        if (!book) {
+            continue;
+        }
+        fnvMix(hash, book->getSymbolId());
+        for (const PriceLadder* ladder : { &book->getBuyOrders(), &book->getSellOrders() }) {
+            for (const PriceLevel* level = ladder->best(); level; level = ladder->next(*level)) {
+                fnvMix(hash, level->tick);
+                for (const Order* order = level->head; order; order = order->nextInLevel) {
+                    fnvMix(hash, relativeId(order->getOrderId(), baseOrderId));
+                    fnvMix(hash, order->getQuantity());
+                    ++restingOrders;
+                }
+            }
+            fnvMix(hash, static_cast<int64_t>(-1)); // side separator
+        }
+    }
+    return hash;
+}
+
+// Replay every event in the mapped log
+ReplayResult OrderLogReplayer::replay(Pacing pacing) {
+    ReplayResult result;
+    if (!header) {
+        return result;
+    }
+
+    books.clear();
+    std::unordered_map<uint64_t, OrderRef> refs;
+    refs.reserve(static_cast<size_t>(header->eventCount));
+    result.tradeDigest = FNV_OFFSET;
+    baseOrderId = Order::getNextOrderId();
+
+    const OrderLogEvent* end = events + header->eventCount;
+    uint64_t firstTimestamp = (events != end) ? events->timestampNs : 0;
+    uint64_t start = EngineClock::now();
+
+    for (const OrderLogEvent* event = events; event != end; ++event) {
+        if (pacing == Pacing::ORIGINAL_TIMING) {
+            waitUntil(start, event->timestampNs - firstTimestamp);
+        }
+        ++result.events;
+
+        switch (event->type) {
+            case OrderLogEvent::NEW_ORDER: {
+                if (event->symbolIndex >= symbolIds.size() || event->userIndex >= userIds.size()) {
+                    ++result.rejected;
+                    break;
+                }
+                OrderRef entry = { symbolIds[event->symbolIndex], userIds[event->userIndex],
+                                   event->side == 0 ? OrderSide::BUY : OrderSide::SELL, 0 };
+                entry.orderId = submit(entry.symbol, entry.userId, entry.side, static_cast<int>(event->quantity),
+                                       event->price, getOrderTypeFromCode(event->orderType), result);
+                refs[event->ref] = entry;
+                break;
+            }
+            case OrderLogEvent::CANCEL_ORDER: {
+                auto it = refs.find(event->ref);
+                if (it == refs.end() || !bookFor(it->second.symbol).cancelOrder(it->second.orderId)) {
+                    ++result.rejected;
+                }
+                if (it != refs.end()) {
+                    refs.erase(it);
+                }
+                break;
+            }
+            case OrderLogEvent::MODIFY_ORDER: {
+                auto it = refs.find(event->ref);
+                if (it == refs.end()) {
+                    ++result.rejected;
+                    break;
+                }
+                OrderBook& book = bookFor(it->second.symbol);
+                FillDigest digest(book, baseOrderId, result.tradeDigest);
+                size_t fills = 0;
+                if (!MatchingEngine::modifyOrder(book, it->second.orderId, static_cast<int>(event->quantity),
+                                                 event->price, digest, fills)) {
+                    ++result.rejected;
+                }
+                result.trades += fills;
+                break;
+            }
+            case OrderLogEvent::OPEN_CALL:
+            case OrderLogEvent::UNCROSS: {
+                if (event->symbolIndex >= symbolIds.size()) {
+                    ++result.rejected;
+                    break;
+                }
+                OrderBook& book = bookFor(symbolIds[event->symbolIndex]);
+                if (event->type == OrderLogEvent::OPEN_CALL) {
+                    book.setInCall(true);
+                } else if (book.isInCall()) {
+                    AuctionIndicative indicative;
+                    FillDigest digest(book, baseOrderId, result.tradeDigest);
+                    result.trades += MatchingEngine::uncross(book, digest, indicative);
+                } else {
+                    ++result.rejected;
+                }
+                break;
+            }
+            default:
+                ++result.rejected;
+                break;
+        }
+    }
+
+    result.seconds = static_cast<double>(EngineClock::elapsedNanos(start, EngineClock::now())) / 1e9;
+    result.bookDigest = digestBooks(result.restingOrders);
+    return result;
+}
+
+// Print a replay report
+void OrderLogReplayer::printReport(const ReplayResult& result) {
+    double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+    std::cout << "\n=== Replay Report ===" << std::endl;
+    std::cout << "Events: " << result.events << " (rejected " << result.rejected << ")" << std::endl;
+    std::cout << "Trades: " << result.trades << std::endl;
+    std::cout << "Resting orders: " << result.restingOrders << std::endl;
+    std::cout << std::hex << std::setfill('0');
+    std::cout << "Trade digest: " << std::setw(16) << result.tradeDigest << std::endl;
+    std::cout << "Book digest: " << std::setw(16) << result.bookDigest << std::endl;
+    std::cout << std::dec << std::setfill(' ') << std::fixed << std::setprecision(3);
+    std::cout << "Run time: " << result.seconds << " s" << std::endl;
+    std::cout << std::setprecision(0);
+    std::cout << "Events/sec: " << result.events / seconds << std::endl;
+}
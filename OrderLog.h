@@ -0,0 +1,149 @@
+#ifndef ORDERLOG_H
+#define ORDERLOG_H
+
+#include "Order.h"
+#include "OrderBook.h"
+#include "Registry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Binary order-event log.
+//
+// File layout (native little-endian, no padding between sections):
+//   OrderLogHeader
+//   symbolCount x name entry                  symbol names (see below)
+//   userCount   x name entry                  user names
+//   eventCount  x OrderLogEvent
+//
+// Name entries are encoded as in NameTable.h, so the mapped events stay
+// aligned. Events refer to symbols and users by their index in the name
+// tables, and to orders by a client reference, so a log is independent of the
+// ids a particular process assigns.
+
+static const char ORDER_LOG_MAGIC[8] = { 'T', 'B', 'S', 'O', 'L', 'O', 'G', '1' };
+static const uint32_t ORDER_LOG_VERSION = 1;
+
+struct OrderLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t symbolCount;
+    uint32_t userCount;
+    uint32_t reserved;
+    uint64_t eventCount;
+};
+
+struct OrderLogEvent {
+    enum Type : uint8_t { NEW_ORDER = 1, CANCEL_ORDER = 2, MODIFY_ORDER = 3, OPEN_CALL = 4, UNCROSS = 5 };
+
+    uint64_t timestampNs;   // capture time, used by timed replay
+    uint64_t ref;           // client order reference
+    double price;           // NEW / MODIFY
+    uint32_t quantity;      // NEW / MODIFY
+    uint32_t userIndex;     // NEW
+    uint16_t symbolIndex;   // NEW / OPEN_CALL / UNCROSS
+    uint8_t type;
+    uint8_t side;           // 0 = BUY, 1 = SELL
+    uint8_t orderType;      // NEW: getOrderTypeCode (0 = LIMIT)
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(OrderLogHeader) == 32, "OrderLogHeader must stay fixed width");
+static_assert(sizeof(OrderLogEvent) == 40, "OrderLogEvent must stay fixed width");
+
+// Builds an order log in memory and writes it out
+class OrderLogWriter {
+public:
+    // Event construction
+    void addNewOrder(uint64_t timestampNs, uint64_t ref, const std::string& user, const std::string& symbol,
+                     OrderSide side, int quantity, double price, OrderType type = OrderType::LIMIT);
+    void addCancel(uint64_t timestampNs, uint64_t ref);
+    void addModify(uint64_t timestampNs, uint64_t ref, int quantity, double price);
+    void addAuction(uint64_t timestampNs, const std::string& symbol, OrderLogEvent::Type type);
+
+    // Output
+    bool write(const std::string& path) const;
+    size_t getEventCount() const { return events.size(); }
+
+private:
+    std::vector<std::string> symbols;
+    std::vector<std::string> users;
+    std::unordered_map<std::string, uint32_t> symbolIndex;
+    std::unordered_map<std::string, uint32_t> userIndex;
+    std::vector<OrderLogEvent> events;
+
+    static uint32_t indexOf(const std::string& name, std::vector<std::string>& names,
+                            std::unordered_map<std::string, uint32_t>& index);
+};
+
+// Results of a replay
+struct ReplayResult {
+    uint64_t events;
+    uint64_t trades;
+    uint64_t rejected;
+    size_t restingOrders;
+    uint64_t tradeDigest;   // FNV-1a over every fill in execution order
+    uint64_t bookDigest;    // FNV-1a over the final books in priority order
+    double seconds;
+
+    ReplayResult()
+        : events(0), trades(0), rejected(0), restingOrders(0),
+          tradeDigest(0), bookDigest(0), seconds(0.0) {}
+};
+
+// Memory-maps an order log and replays it straight into MatchingEngine.
+// Events are read in place from the mapping (no parsing or copying); the
+// replayer owns its own books so two builds can be compared on matching
+// output and wall time alone.
+class OrderLogReplayer {
+public:
+    enum class Pacing { MAX_SPEED, ORIGINAL_TIMING };
+
+    // Constructor / Destructor
+    OrderLogReplayer();
+    ~OrderLogReplayer();
+
+    // Non-copyable: owns the mapping
+    OrderLogReplayer(const OrderLogReplayer&) = delete;
+    OrderLogReplayer& operator=(const OrderLogReplayer&) = delete;
+
+    // Input
+    bool open(const std::string& path);
+    void close();
+    uint64_t getEventCount() const { return header ? header->eventCount : 0; }
+
+    // Execution
+    ReplayResult replay(Pacing pacing = Pacing::MAX_SPEED);
+
+    // Reporting
+    static void printReport(const ReplayResult& result);
+
+private:
+    // Engine-side identity of a live client reference
+    struct OrderRef {
+        SymbolId symbol;
+        UserId userId;
+        OrderSide side;
+        OrderId orderId;
+    };
+
+    void* mapping;
+    size_t mappingSize;
+    const OrderLogHeader* header;
+    const OrderLogEvent* events;
+    std::vector<SymbolId> symbolIds; // file index -> SymbolId
+    std::vector<UserId> userIds;     // file index -> UserId
+    OrderDirectory directory;       // resting orders of every book (declared before the books)
+    std::vector<std::unique_ptr<OrderBook>> books;
+    OrderId baseOrderId; // first order id of the current replay, so digests ignore earlier orders
+
+    OrderBook& bookFor(SymbolId symbol);
+    OrderId submit(SymbolId symbol, UserId userId, OrderSide side, int quantity, double price, OrderType type,
+                   ReplayResult& result);
+    uint64_t digestBooks(size_t& restingOrders) const;
+};
+
+#endif // ORDERLOG_H
@@ -0,0 +1,19 @@
+#include "OrderPool.h"
+
+// Constructor
+OrderPool::OrderPool(size_t initialCapacity)
+    : freeList(nullptr), slabSize(initialCapacity > 0 ? initialCapacity : 1),
+      capacity(0), inUse(0) {
+    grow(slabSize);
+}
+
+// Add a slab of count slots to the free list
+void OrderPool::grow(size_t count) {
+    std::unique_ptr<Slot[]> slab(new Slot[count]);
+    for (size_t i = count; i > 0; --i) {
+        slab[i - 1].next = freeList;
+        freeList = &slab[i - 1];
+    }
+    slabs.push_back(std::move(slab));
+    capacity += count;
+}
@@ -0,0 +1,73 @@
+#ifndef ORDERPOOL_H
+#define ORDERPOOL_H
+
+#include "Order.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Slab allocator for Order records.
+// Orders are constructed in place inside pre-allocated slabs and freed slots
+// are threaded onto an intrusive free list, so acquire/release never touch
+// the heap once the pool is warm. The pool only grows (by whole slabs) when
+// every slot is in use.
+class OrderPool {
+public:
+    static const size_t DEFAULT_CAPACITY = 4096;
+
+    // Constructor
+    explicit OrderPool(size_t initialCapacity = DEFAULT_CAPACITY);
+
+    // Destructor
+    ~OrderPool() = default;
+
+    // Non-copyable: handed-out pointers refer into this pool's slabs
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    // Construct an order in a free slot
+    template <typename... Args>
+    Order* acquire(Args&&... args) {
+        if (!freeList) {
+            grow(slabSize);
+        }
+        Slot* slot = freeList;
+        freeList = slot->next;
+        ++inUse;
+        return new (&slot->storage) Order(std::forward<Args>(args)...);
+    }
+
+    // Destroy an order and return its slot to the free list
+    void release(Order* order) {
+        if (!order) return;
+        order->~Order();
+        Slot* slot = reinterpret_cast<Slot*>(order);
+        slot->next = freeList;
+        freeList = slot;
+        --inUse;
+    }
+
+    // Statistics
+    size_t getCapacity() const { return capacity; }
+    size_t getInUse() const { return inUse; }
+    size_t getSlabCount() const { return slabs.size(); }
+
+private:
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(Order), alignof(Order)>::type storage;
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    Slot* freeList;
+    size_t slabSize;
+    size_t capacity;
+    size_t inUse;
+
+    void grow(size_t count);
+};
+
+#endif // ORDERPOOL_H
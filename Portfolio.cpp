@@ -3,15 +3,14 @@
 #include <algorithm>
 
 // Constructor
-Portfolio::Portfolio(const std::string& user, double initialCash) 
+Portfolio::Portfolio(UserId user, double initialCash) 
     : userId(user), cashBalance(initialCash) {
 }
 
 // Copy constructor
 Portfolio::Portfolio(const Portfolio& other) 
-    : userId(other.userId), positions(other.positions), 
-      tradeHistory(other.tradeHistory), averageCosts(other.averageCosts),
-      cashBalance(other.cashBalance) {
+    : userId(other.userId), positions(other.positions), positionSlots(other.positionSlots),
+      tradeHistory(other.tradeHistory), cashBalance(other.cashBalance) {
 }
 
 // Assignment operator
@@ -19,13 +18,25 @@ Portfolio& Portfolio::operator=(const Portfolio& other) {
     if (this != &other) {
         userId = other.userId;
         positions = other.positions;
+        positionSlots = other.positionSlots;
         tradeHistory = other.tradeHistory;
-        averageCosts = other.averageCosts;
         cashBalance = other.cashBalance;
     }
     return *this;
 }
 
+// Position record for a symbol, created on first use
+Position& Portfolio::positionFor(SymbolId symbol) {
+    if (symbol >= positionSlots.size()) {
+        positionSlots.resize(symbol + 1, 0);
+    }
+    if (positionSlots[symbol] == 0) {
+        positions.push_back(Position(symbol));
+        positionSlots[symbol] = static_cast<uint32_t>(positions.size());
+    }
+    return positions[positionSlots[symbol] - 1];
+}
+
 // Add trade with buyer/seller indication
 void Portfolio::addTrade(const Trade& trade, bool isBuyerSide) {
     tradeHistory.push_back(trade);
@@ -39,7 +50,6 @@ void Portfolio::addTrade(const Trade& trade, bool isBuyerSide) {
 
 // Process buy trade
 void Portfolio::addBuyTrade(const Trade& trade) {
-    const std::string& symbol = trade.symbol;
     int quantity = trade.quantity;
     double price = trade.price;
     double totalCost = quantity * price;
@@ -47,33 +57,27 @@ void Portfolio::addBuyTrade(const Trade& trade) {
     // Update cash balance
     cashBalance -= totalCost;
     
-    // Update position and average cost
-    int currentPosition = positions[symbol];
-    double currentAvgCost = averageCosts[symbol];
-    
-    if (currentPosition >= 0) {
+    // Update position, average cost and realized P&L
+    Position& held = positionFor(trade.symbolId);
+    if (held.quantity >= 0) {
         // Adding to long position or creating new long position
-        double totalValue = (currentPosition * currentAvgCost) + totalCost;
-        positions[symbol] = currentPosition + quantity;
-        averageCosts[symbol] = totalValue / positions[symbol];
+        double totalValue = (held.quantity * held.averageCost) + totalCost;
+        held.quantity += quantity;
+        held.averageCost = totalValue / held.quantity;
     } else {
-        // We have a short position, reducing it
-        if (quantity <= -currentPosition) {
-            // Partially or fully covering short position
-            positions[symbol] = currentPosition + quantity;
-            // Keep the same average cost for remaining short position
-        } else {
-            // Covering entire short position and going long
-            int excessQuantity = quantity + currentPosition; // currentPosition is negative
-            positions[symbol] = excessQuantity;
-            averageCosts[symbol] = price; // New average cost for the long position
+        // Covering a short position realizes the difference on the covered shares
+        int covered = std::min(quantity, -held.quantity);
+        held.realizedPnL += covered * (held.averageCost - price);
+        held.quantity += quantity;
+        if (held.quantity > 0) {
+            held.averageCost = price; // New average cost for the long position
         }
+        // Otherwise keep the same average cost for remaining short position
     }
 }
 
 // Process sell trade
 void Portfolio::addSellTrade(const Trade& trade) {
-    const std::string& symbol = trade.symbol;
     int quantity = trade.quantity;
     double price = trade.price;
     double totalRevenue = quantity * price;
@@ -81,45 +85,46 @@ void Portfolio::addSellTrade(const Trade& trade) {
     // Update cash balance
     cashBalance += totalRevenue;
     
-    // Update position and average cost
-    int currentPosition = positions[symbol];
-    double currentAvgCost = averageCosts[symbol];
-    
-    if (currentPosition <= 0) {
+    // Update position, average cost and realized P&L
+    Position& held = positionFor(trade.symbolId);
+    if (held.quantity <= 0) {
         // Adding to short position or creating new short position
-        double totalValue = (-currentPosition * currentAvgCost) + totalRevenue;
-        positions[symbol] = currentPosition - quantity;
-        averageCosts[symbol] = totalValue / (-positions[symbol]);
+        double totalValue = (-held.quantity * held.averageCost) + totalRevenue;
+        held.quantity -= quantity;
+        held.averageCost = totalValue / (-held.quantity);
     } else {
-        // We have a long position, reducing it
-        if (quantity <= currentPosition) {
-            // Partially or fully selling long position
-            positions[symbol] = currentPosition - quantity;
-            // Keep the same average cost for remaining long position
-        } else {
-            // Selling entire long position and going short
-            int excessQuantity = quantity - currentPosition;
-            positions[symbol] = -excessQuantity;
-            averageCosts[symbol] = price; // New average cost for the short position
+        // Selling a long position realizes the difference on the sold shares
+        int sold = std::min(quantity, held.quantity);
+        held.realizedPnL += sold * (price - held.averageCost);
+        held.quantity -= quantity;
+        if (held.quantity < 0) {
+            held.averageCost = price; // New average cost for the short position
         }
+        // Otherwise keep the same average cost for remaining long position
     }
 }
 
 // Get position for a symbol
-int Portfolio::getPosition(const std::string& symbol) const {
-    auto it = positions.find(symbol);
-    return (it != positions.end()) ? it->second : 0;
+int Portfolio::getPosition(SymbolId symbol) const {
+    const Position* held = findPosition(symbol);
+    return held ? held->quantity : 0;
 }
 
 // Get average cost for a symbol
-double Portfolio::getAverageCost(const std::string& symbol) const {
-    auto it = averageCosts.find(symbol);
-    return (it != averageCosts.end()) ? it->second : 0.0;
+double Portfolio::getAverageCost(SymbolId symbol) const {
+    const Position* held = findPosition(symbol);
+    return held ? held->averageCost : 0.0;
+}
+
+// Get realized P&L for a symbol
+double Portfolio::getRealizedPnL(SymbolId symbol) const {
+    const Position* held = findPosition(symbol);
+    return held ? held->realizedPnL : 0.0;
 }
 
 // Display complete portfolio
 void Portfolio::displayPortfolio() const {
-    std::cout << "\n=== Portfolio for " << userId << " ===" << std::endl;
+    std::cout << "\n=== Portfolio for " << getUserName() << " ===" << std::endl;
     std::cout << "Cash Balance: $" << std::fixed << std::setprecision(2) << cashBalance << std::endl;
     
     displayPositions();
@@ -138,13 +143,12 @@ void Portfolio::displayPositions() const {
               << std::setw(12) << "Avg Cost" << std::setw(12) << "Market Val" << std::endl;
     std::cout << std::string(42, '-') << std::endl;
     
-    for (const auto& p : positions) {
-        const std::string& symbol = p.first;
-        int position = p.second;
+    for (const Position& held : positions) {
+        int position = held.quantity;
         if (position != 0) {
-            double avgCost = getAverageCost(symbol);
+            double avgCost = held.averageCost;
             double marketValue = position * avgCost;
-            std::cout << std::setw(8) << symbol
+            std::cout << std::setw(8) << Registry::symbolName(held.symbol)
                       << std::setw(10) << position
                       << std::setw(12) << std::fixed << std::setprecision(2) << avgCost
                       << std::setw(12) << std::fixed << std::setprecision(2) << marketValue;
@@ -188,35 +192,28 @@ void Portfolio::displayPnLSummary() const {
     std::cout << "Note: Unrealized P&L requires current market prices" << std::endl;
 }
 
-// Calculate realized P&L from completed trades
+// Calculate realized P&L across all symbols (accumulated per fill)
 double Portfolio::calculateRealizedPnL() const {
-    // This is a simplified calculation
-    // In practice, you'd need more sophisticated P&L tracking
-    double totalCashFlow = 0.0;
+    double realizedPnL = 0.0;
     
-    for (const auto& trade : tradeHistory) {
-        if (trade.buyUserId == userId) {
-            totalCashFlow -= trade.quantity * trade.price; // Cash out for buying
-        } else if (trade.sellUserId == userId) {
-            totalCashFlow += trade.quantity * trade.price; // Cash in for selling
-        }
+    for (const Position& held : positions) {
+        realizedPnL += held.realizedPnL;
     }
     
-    return totalCashFlow;
+    return realizedPnL;
 }
 
 // Calculate unrealized P&L
-double Portfolio::calculateUnrealizedPnL(const std::unordered_map<std::string, double>& currentPrices) const {
+double Portfolio::calculateUnrealizedPnL(const std::vector<double>& currentPrices) const {
     double unrealizedPnL = 0.0;
     
-    for (const auto& kv : positions) {
-        const std::string& symbol = kv.first;
-        int position = kv.second;
+    for (const Position& held : positions) {
+        SymbolId symbol = held.symbol;
+        int position = held.quantity;
         if (position != 0) {
-            auto priceIt = currentPrices.find(symbol);
-            if (priceIt != currentPrices.end()) {
-                double currentPrice = priceIt->second;
-                double avgCost = getAverageCost(symbol);
+            if (symbol < currentPrices.size() && currentPrices[symbol] > 0) {
+                double currentPrice = currentPrices[symbol];
+                double avgCost = held.averageCost;
                 if (position > 0) {
                     unrealizedPnL += position * (currentPrice - avgCost);
                 } else {
@@ -230,16 +227,15 @@ double Portfolio::calculateUnrealizedPnL(const std::unordered_map<std::string, d
 }
 
 // Calculate total portfolio value
-double Portfolio::getTotalPortfolioValue(const std::unordered_map<std::string, double>& currentPrices) const {
+double Portfolio::getTotalPortfolioValue(const std::vector<double>& currentPrices) const {
     double totalValue = cashBalance;
     
-    for (const auto& entry : positions) {
-        const std::string& symbol = entry.first;
-        int position = entry.second;
+    for (const Position& held : positions) {
+        SymbolId symbol = held.symbol;
+        int position = held.quantity;
         if (position != 0) {
-            auto priceIt = currentPrices.find(symbol);
-            if (priceIt != currentPrices.end()) {
-                double currentPrice = priceIt->second;
+            if (symbol < currentPrices.size() && currentPrices[symbol] > 0) {
+                double currentPrice = currentPrices[symbol];
                 totalValue += position * currentPrice;
             }
         }
@@ -249,13 +245,18 @@ double Portfolio::getTotalPortfolioValue(const std::unordered_map<std::string, d
 }
 
 // Check if has position in symbol
-bool Portfolio::hasPosition(const std::string& symbol) const {
-    auto it = positions.find(symbol);
-    return (it != positions.end()) && (it->second != 0);
+bool Portfolio::hasPosition(SymbolId symbol) const {
+    return getPosition(symbol) != 0;
+}
+
+// Clear position for a symbol (realized P&L is kept)
+void Portfolio::clearPosition(SymbolId symbol) {
+    Position& held = positionFor(symbol);
+    held.quantity = 0;
+    held.averageCost = 0.0;
 }
 
-// Clear position for a symbol
-void Portfolio::clearPosition(const std::string& symbol) {
-    positions[symbol] = 0;
-    averageCosts[symbol] = 0.0;
+// Set a position record directly (snapshot restore)
+void Portfolio::restorePosition(const Position& position) {
+    positionFor(position.symbol) = position;
 }
\ No newline at end of file
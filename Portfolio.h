@@ -3,21 +3,33 @@
 
 #include "Trade.h"
 #include <vector>
-#include <unordered_map>
 #include <iostream>
 #include <string>
 
+// Holding in one symbol, updated in place on every fill
+struct Position {
+    SymbolId symbol;
+    int quantity;           // net position (positive = long, negative = short)
+    double averageCost;     // per share of the open position
+    double realizedPnL;     // accumulated as the position is reduced
+    
+    explicit Position(SymbolId id = Registry::INVALID_ID)
+        : symbol(id), quantity(0), averageCost(0.0), realizedPnL(0.0) {}
+};
+
 class Portfolio {
 private:
-    std::string userId;
-    std::unordered_map<std::string, int> positions; // symbol -> net position (positive = long, negative = short)
+    UserId userId;
+    std::vector<Position> positions;        // one per symbol traded, in first-trade order
+    std::vector<uint32_t> positionSlots;    // by SymbolId: index into positions + 1 (0 = none)
     std::vector<Trade> tradeHistory;
-    std::unordered_map<std::string, double> averageCosts; // symbol -> average cost per share
     double cashBalance;
     
+    Position& positionFor(SymbolId symbol);
+    
 public:
     // Constructor
-    explicit Portfolio(const std::string& user, double initialCash = 100000.0);
+    explicit Portfolio(UserId user, double initialCash = 100000.0);
     
     // Destructor
     ~Portfolio() = default;
@@ -34,11 +46,14 @@ public:
     void addSellTrade(const Trade& trade);
     
     // Portfolio queries
-    int getPosition(const std::string& symbol) const;
-    double getAverageCost(const std::string& symbol) const;
+    int getPosition(SymbolId symbol) const;
+    double getAverageCost(SymbolId symbol) const;
     double getCashBalance() const { return cashBalance; }
     const std::vector<Trade>& getTradeHistory() const { return tradeHistory; }
-    const std::unordered_map<std::string, int>& getAllPositions() const { return positions; }
+    const std::vector<Position>& getPositions() const { return positions; }
+    const Position* findPosition(SymbolId symbol) const {
+        return symbol < positionSlots.size() && positionSlots[symbol] ? &positions[positionSlots[symbol] - 1] : nullptr;
+    }
     
     // Display functions
     void displayPortfolio() const;
@@ -46,18 +61,25 @@ public:
     void displayTradeHistory(int maxTrades = 10) const;
     void displayPnLSummary() const;
     
-    // Portfolio calculations
-    double calculateUnrealizedPnL(const std::unordered_map<std::string, double>& currentPrices) const;
-    double calculateRealizedPnL() const;
-    double getTotalPortfolioValue(const std::unordered_map<std::string, double>& currentPrices) const;
+    // Portfolio calculations (currentPrices is indexed by SymbolId)
+    double calculateUnrealizedPnL(const std::vector<double>& currentPrices) const;
+    double calculateRealizedPnL() const;    // O(symbols traded), not O(trade history)
+    double getRealizedPnL(SymbolId symbol) const;
+    double getTotalPortfolioValue(const std::vector<double>& currentPrices) const;
     
     // Utility functions
-    const std::string& getUserId() const { return userId; }
-    bool hasPosition(const std::string& symbol) const;
+    UserId getUserId() const { return userId; }
+    const std::string& getUserName() const { return Registry::userName(userId); }
+    bool hasPosition(SymbolId symbol) const;
     size_t getTradeCount() const { return tradeHistory.size(); }
     
     // Position management
-    void clearPosition(const std::string& symbol);
+    void clearPosition(SymbolId symbol);
+    
+    // Restoring saved state (no cash or position side effects)
+    void restorePosition(const Position& position);
+    void restoreTrade(const Trade& trade) { tradeHistory.push_back(trade); }
+    void reserveTradeHistory(size_t count) { tradeHistory.reserve(count); }
     void setCashBalance(double balance) { cashBalance = balance; }
     void adjustCashBalance(double amount) { cashBalance += amount; }
 };
@@ -0,0 +1,295 @@
+#include "PriceLadder.h"
+#include <algorithm>
+#include <limits>
+
+// Constructor
+PriceLadder::PriceLadder(bool desc)
+    : descending(desc), anchored(false), baseKey(0), levelCount(0), windowLevelCount(0),
+      orderCount(0), totalQuantity(0), window(WINDOW_SIZE), summary(0), occupancy(WINDOW_SIZE / 64, 0),
+      listener(nullptr), listenerSymbol(Registry::INVALID_ID) {
+}
+
+// Best (highest bid / lowest ask) level, or nullptr when the side is empty
+PriceLevel* PriceLadder::best() {
+    return firstAtOrAfter(std::numeric_limits<int64_t>::min());
+}
+
+const PriceLevel* PriceLadder::best() const {
+    return firstAtOrAfter(std::numeric_limits<int64_t>::min());
+}
+
+// Next worse occupied level after the given one
+PriceLevel* PriceLadder::next(const PriceLevel& level) {
+    return firstAtOrAfter(keyOf(level.tick) + 1);
+}
+
+const PriceLevel* PriceLadder::next(const PriceLevel& level) const {
+    return firstAtOrAfter(keyOf(level.tick) + 1);
+}
+
+// Find an occupied level by tick
+PriceLevel* PriceLadder::find(int64_t tick) {
+    int64_t key = keyOf(tick);
+    if (inWindow(key)) {
+        size_t index = static_cast<size_t>(key - baseKey);
+        bool occupied = (occupancy[index >> 6] >> (index & 63)) & 1;
+        return occupied ? &window[index] : nullptr;
+    }
+    auto it = sparse.find(key);
+    return (it != sparse.end()) ? &it->second : nullptr;
+}
+
+// Find or create the level for a tick
+PriceLevel& PriceLadder::getOrCreate(int64_t tick, double price) {
+    int64_t key = keyOf(tick);
+    if (!inWindow(key)) {
+        // Keep the window on the touch: an empty window follows the new level,
+        // and one the touch has drifted away from is re-based on it
+        if (windowLevelCount == 0) {
+            recenter(key);
+        } else {
+            int64_t touch = std::min(key, keyOf(best()->tick));
+            if (key - touch < static_cast<int64_t>(WINDOW_SIZE / 2)) {
+                recenter(touch);
+            }
+        }
+    }
+
+    if (inWindow(key)) {
+        size_t index = static_cast<size_t>(key - baseKey);
+        PriceLevel& level = window[index];
+        if (!((occupancy[index >> 6] >> (index & 63)) & 1)) {
+            level.tick = tick;
+            level.price = price;
+            setOccupied(index);
+            ++windowLevelCount;
+            ++levelCount;
+        }
+        return level;
+    }
+
+    auto result = sparse.emplace(key, PriceLevel());
+    if (result.second) {
+        result.first->second.tick = tick;
+        result.first->second.price = price;
+        ++levelCount;
+    }
+    return result.first->second;
+}
+
+// Remove a level (normally once its last order has gone)
+void PriceLadder::removeLevel(PriceLevel& level) {
+    int64_t key = keyOf(level.tick);
+    if (inWindow(key)) {
+        size_t index = static_cast<size_t>(key - baseKey);
+        if ((occupancy[index >> 6] >> (index & 63)) & 1) {
+            window[index] = PriceLevel();
+            clearOccupied(index);
+            --windowLevelCount;
+            --levelCount;
+        }
+        return;
+    }
+    if (sparse.erase(key) > 0) {
+        --levelCount;
+    }
+}
+
+// Append an order to a level of this ladder
+void PriceLadder::insertOrder(PriceLevel& level, Order* order) {
+    level.append(order);
+    ++orderCount;
+    totalQuantity += order->quantity;
+    if (listener) {
+        report(level.orderCount == 1 ? LevelUpdate::ADD : LevelUpdate::CHANGE,
+               level.tick, level.price, level.totalQuantity, level.orderCount);
+    }
+}
+
+// Unlink a resting order, removing its level if that was the last order
+void PriceLadder::removeOrder(Order* order) {
+    PriceLevel* level = order->level;
+    if (!level) {
+        return;
+    }
+    level->remove(order);
+    --orderCount;
+    totalQuantity -= order->quantity;
+    if (level->empty()) {
+        int64_t tick = level->tick;
+        double price = level->price;
+        removeLevel(*level);
+        if (listener) {
+            report(LevelUpdate::DELETE, tick, price, 0, 0);
+        }
+    } else if (listener) {
+        report(LevelUpdate::CHANGE, level->tick, level->price, level->totalQuantity, level->orderCount);
+    }
+}
+
+// Take executed (or modified-away) quantity off a resting order in place,
+// keeping its queue position; an order left with nothing is unlinked (the
+// caller still owns releasing it)
+bool PriceLadder::reduceOrder(Order* order, int quantity) {
+    quantity = std::min(quantity, order->quantity);
+    if (quantity > 0) {
+        order->quantity -= quantity;
+        if (order->level) {
+            order->level->totalQuantity -= quantity;
+        }
+        totalQuantity -= quantity;
+    }
+    if (order->quantity == 0) {
+        removeOrder(order);
+        return true;
+    }
+    if (listener && quantity > 0 && order->level) {
+        PriceLevel* level = order->level;
+        report(LevelUpdate::CHANGE, level->tick, level->price, level->totalQuantity, level->orderCount);
+    }
+    return false;
+}
+
+// Tell the listener about one level change
+void PriceLadder::report(LevelUpdate::Type type, int64_t tick, double price,
+                         int64_t quantity, size_t orders) const {
+    LevelUpdate update;
+    update.symbolId = listenerSymbol;
+    update.side = descending ? OrderSide::BUY : OrderSide::SELL;
+    update.type = type;
+    update.tick = tick;
+    update.price = price;
+    update.quantity = quantity;
+    update.orderCount = orders;
+    listener->onLevelUpdate(update);
+}
+
+// First occupied level whose key is >= key
+PriceLevel* PriceLadder::firstAtOrAfter(int64_t key) const {
+    PriceLadder* self = const_cast<PriceLadder*>(this);
+    int64_t windowEnd = baseKey + static_cast<int64_t>(WINDOW_SIZE);
+
+    if (!anchored) {
+        auto it = self->sparse.lower_bound(key);
+        return (it != self->sparse.end()) ? &it->second : nullptr;
+    }
+
+    // Sparse levels better than the window
+    if (key < baseKey) {
+        if (!sparse.empty()) {
+            auto it = self->sparse.lower_bound(key);
+            if (it != self->sparse.end() && it->first < baseKey) {
+                return &it->second;
+            }
+        }
+        key = baseKey;
+    }
+
+    // Window levels via the occupancy bitmap
+    if (key < windowEnd) {
+        size_t index = findNextOccupied(static_cast<size_t>(key - baseKey));
+        if (index < WINDOW_SIZE) {
+            return &self->window[index];
+        }
+        key = windowEnd;
+    }
+
+    // Sparse levels worse than the window
+    if (sparse.empty()) {
+        return nullptr;
+    }
+    auto it = self->sparse.lower_bound(key);
+    return (it != self->sparse.end()) ? &it->second : nullptr;
+}
+
+// Index of the first occupied window slot at or after index
+size_t PriceLadder::findNextOccupied(size_t index) const {
+    size_t word = index >> 6;
+    uint64_t bits = occupancy[word] & (~0ULL << (index & 63));
+    if (bits) {
+        return (word << 6) + __builtin_ctzll(bits);
+    }
+    if (word + 1 >= occupancy.size()) {
+        return WINDOW_SIZE;
+    }
+    uint64_t words = summary & (~0ULL << (word + 1));
+    if (!words) {
+        return WINDOW_SIZE;
+    }
+    word = __builtin_ctzll(words);
+    return (word << 6) + __builtin_ctzll(occupancy[word]);
+}
+
+void PriceLadder::setOccupied(size_t index) {
+    occupancy[index >> 6] |= (1ULL << (index & 63));
+    summary |= (1ULL << (index >> 6));
+}
+
+void PriceLadder::clearOccupied(size_t index) {
+    uint64_t& word = occupancy[index >> 6];
+    word &= ~(1ULL << (index & 63));
+    if (!word) {
+        summary &= ~(1ULL << (index >> 6));
+    }
+}
+
+// Re-base the window so that it is centered on key. Window levels that fall
+// outside it move to the sparse map and sparse levels now inside it move in;
+// resting orders are re-pointed at their level's new slot either way.
+void PriceLadder::recenter(int64_t key) {
+    int64_t oldBase = baseKey;
+    int64_t newBase = key - static_cast<int64_t>(WINDOW_SIZE / 2);
+    if (anchored && windowLevelCount > 0 && newBase != oldBase) {
+        // Walk the old occupancy in the direction of the shift, so a level is
+        // only ever moved onto a slot that has already been vacated
+        uint64_t occupied[WINDOW_SIZE / 64];
+        std::copy(occupancy.begin(), occupancy.end(), occupied);
+        std::fill(occupancy.begin(), occupancy.end(), 0);
+        summary = 0;
+        windowLevelCount = 0;
+        baseKey = newBase;
+        bool upward = newBase > oldBase;
+        for (size_t n = 0; n < WINDOW_SIZE / 64; ++n) {
+            size_t word = upward ? n : WINDOW_SIZE / 64 - 1 - n;
+            uint64_t bits = occupied[word];
+            while (bits) {
+                size_t bit = upward ? __builtin_ctzll(bits) : 63 - __builtin_clzll(bits);
+                bits &= ~(1ULL << bit);
+                size_t index = (word << 6) + bit;
+                int64_t levelKey = oldBase + static_cast<int64_t>(index);
+                PriceLevel level = window[index];
+                window[index] = PriceLevel();
+                PriceLevel* home;
+                if (inWindow(levelKey)) {
+                    size_t target = static_cast<size_t>(levelKey - newBase);
+                    window[target] = level;
+                    setOccupied(target);
+                    ++windowLevelCount;
+                    home = &window[target];
+                } else {
+                    home = &sparse.emplace(levelKey, level).first->second;
+                }
+                relink(*home);
+            }
+        }
+    }
+    anchored = true;
+    baseKey = newBase;
+
+    auto it = sparse.lower_bound(baseKey);
+    while (it != sparse.end() && inWindow(it->first)) {
+        size_t index = static_cast<size_t>(it->first - baseKey);
+        window[index] = it->second;
+        relink(window[index]);
+        setOccupied(index);
+        ++windowLevelCount;
+        it = sparse.erase(it);
+    }
+}
+
+// Point a moved level's orders back at it
+void PriceLadder::relink(PriceLevel& level) {
+    for (Order* order = level.head; order; order = order->nextInLevel) {
+        order->level = &level;
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef PRICELADDER_H
+#define PRICELADDER_H
+
+#include "Order.h"
+#include "MarketDataListener.h"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// All resting orders at a single price, in time priority.
+// Orders are kept in an intrusive doubly linked FIFO queue threaded through
+// Order::prevInLevel/nextInLevel, so append, pop-front and unlink are O(1)
+// and never allocate. orderCount and totalQuantity are kept current so depth
+// queries never walk the queue.
+struct PriceLevel {
+    int64_t tick;
+    double price;
+    Order* head;
+    Order* tail;
+    size_t orderCount;
+    int64_t totalQuantity;
+
+    PriceLevel() : tick(0), price(0.0), head(nullptr), tail(nullptr), orderCount(0), totalQuantity(0) {}
+
+    bool empty() const { return head == nullptr; }
+    Order* front() const { return head; }
+
+    // Append at the back of the queue (newest order)
+    void append(Order* order) {
+        order->level = this;
+        order->prevInLevel = tail;
+        order->nextInLevel = nullptr;
+        if (tail) {
+            tail->nextInLevel = order;
+        } else {
+            head = order;
+        }
+        tail = order;
+        ++orderCount;
+        totalQuantity += order->quantity;
+    }
+
+    // Unlink an order from anywhere in the queue
+    void remove(Order* order) {
+        if (order->prevInLevel) {
+            order->prevInLevel->nextInLevel = order->nextInLevel;
+        } else {
+            head = order->nextInLevel;
+        }
+        if (order->nextInLevel) {
+            order->nextInLevel->prevInLevel = order->prevInLevel;
+        } else {
+            tail = order->prevInLevel;
+        }
+        order->prevInLevel = nullptr;
+        order->nextInLevel = nullptr;
+        order->level = nullptr;
+        --orderCount;
+        totalQuantity -= order->quantity;
+    }
+};
+
+// One side of an order book, keyed by integer price ticks.
+// Levels close to the touch live in a contiguous window indexed by tick and
+// tracked by a two-level occupancy bitmap; prices outside the window fall back
+// to a sparse map. The window is re-based on the touch when a new level near
+// it would land outside, which moves levels between the window and the map,
+// so getOrCreate invalidates other PriceLevel pointers into the ladder.
+// Internally levels are ranked by key (tick for asks, -tick for bids) so that
+// the lowest key is always the best price on either side.
+// Resting orders should change through insertOrder/removeOrder/reduceOrder,
+// which keep the per-level and per-side totals current and report each level
+// change to the ladder's MarketDataListener, if any.
+class PriceLadder {
+public:
+    static const size_t WINDOW_SIZE = 4096; // 64 words x 64 bits
+
+    // Constructor
+    explicit PriceLadder(bool descending);
+    
+    // Non-copyable: resting orders point back at their level
+    PriceLadder(const PriceLadder&) = delete;
+    PriceLadder& operator=(const PriceLadder&) = delete;
+
+    // Level access
+    PriceLevel* best();
+    const PriceLevel* best() const;
+    PriceLevel* next(const PriceLevel& level);
+    const PriceLevel* next(const PriceLevel& level) const;
+    PriceLevel* find(int64_t tick);
+    PriceLevel& getOrCreate(int64_t tick, double price);
+    void removeLevel(PriceLevel& level);
+
+    // Resting order changes
+    void insertOrder(PriceLevel& level, Order* order);
+    void removeOrder(Order* order);                 // drops the level once it is empty
+    bool reduceOrder(Order* order, int quantity);   // execution or size-down; true when the order reached 0 and was removed
+
+    // Level change reporting (null listener = off)
+    void setListener(MarketDataListener* levelListener, SymbolId symbol) {
+        listener = levelListener;
+        listenerSymbol = symbol;
+    }
+
+    // Utility functions
+    bool empty() const { return levelCount == 0; }
+    size_t getLevelCount() const { return levelCount; }
+    size_t getOrderCount() const { return orderCount; }
+    int64_t getTotalQuantity() const { return totalQuantity; }
+    bool isDescending() const { return descending; }
+
+private:
+    bool descending;
+    bool anchored;
+    int64_t baseKey; // key stored at window index 0
+    size_t levelCount;
+    size_t windowLevelCount;
+    size_t orderCount;
+    int64_t totalQuantity;
+    std::vector<PriceLevel> window;
+    uint64_t summary;                   // bit i set when occupancy[i] != 0
+    std::vector<uint64_t> occupancy;    // bit per window slot
+    std::map<int64_t, PriceLevel> sparse;
+    MarketDataListener* listener;
+    SymbolId listenerSymbol;
+
+    int64_t keyOf(int64_t tick) const { return descending ? -tick : tick; }
+    bool inWindow(int64_t key) const {
+        return anchored && key >= baseKey && key < baseKey + static_cast<int64_t>(WINDOW_SIZE);
+    }
+
+    PriceLevel* firstAtOrAfter(int64_t key) const;
+    size_t findNextOccupied(size_t index) const;
+    void setOccupied(size_t index);
+    void clearOccupied(size_t index);
+    void recenter(int64_t key);
+    static void relink(PriceLevel& level);
+    void report(LevelUpdate::Type type, int64_t tick, double price, int64_t quantity, size_t orders) const;
+};
+
+#endif // PRICELADDER_H
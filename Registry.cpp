@@ -0,0 +1,80 @@
+#include "Registry.h"
+
+namespace {
+    const std::string UNKNOWN_NAME = "?";
+}
+
+// Intern tables (constructed on first use)
+Registry::InternTable& Registry::symbols() {
+    static InternTable table;
+    return table;
+}
+
+Registry::InternTable& Registry::users() {
+    static InternTable table;
+    return table;
+}
+
+// Interning
+SymbolId Registry::internSymbol(const std::string& name) {
+    return symbols().intern(name);
+}
+
+UserId Registry::internUser(const std::string& name) {
+    return users().intern(name);
+}
+
+// Lookup without interning
+SymbolId Registry::findSymbol(const std::string& name) {
+    return symbols().find(name);
+}
+
+UserId Registry::findUser(const std::string& name) {
+    return users().find(name);
+}
+
+// Reverse lookup
+const std::string& Registry::symbolName(SymbolId id) {
+    return symbols().name(id);
+}
+
+const std::string& Registry::userName(UserId id) {
+    return users().name(id);
+}
+
+size_t Registry::getSymbolCount() {
+    return symbols().size();
+}
+
+size_t Registry::getUserCount() {
+    return users().size();
+}
+
+// InternTable implementation
+uint32_t Registry::InternTable::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    ids.emplace(name, id);
+    return id;
+}
+
+uint32_t Registry::InternTable::find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(name);
+    return (it != ids.end()) ? it->second : INVALID_ID;
+}
+
+const std::string& Registry::InternTable::name(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (id < names.size()) ? names[id] : UNKNOWN_NAME;
+}
+
+size_t Registry::InternTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return names.size();
+}
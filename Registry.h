@@ -0,0 +1,61 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Dense integer handles for interned names
+typedef uint32_t SymbolId;
+typedef uint32_t UserId;
+
+// Order ids are not names: dense and increasing from 1 (0 = none), and 64 bits
+// wide so a long session never wraps
+typedef uint64_t OrderId;
+
+// Process-wide interning of symbol and user names.
+// Names are assigned a dense id once (at login / addSymbol time) and the hot
+// path only ever carries the id; strings are looked up again at the display
+// and I/O edges. Ids are never reused and names stay at a stable address, so
+// the returned references remain valid for the life of the process.
+class Registry {
+public:
+    static const uint32_t INVALID_ID = 0xFFFFFFFFu;
+
+    // Interning (returns the existing id when already known)
+    static SymbolId internSymbol(const std::string& name);
+    static UserId internUser(const std::string& name);
+
+    // Lookup without interning (INVALID_ID when unknown)
+    static SymbolId findSymbol(const std::string& name);
+    static UserId findUser(const std::string& name);
+
+    // Reverse lookup for display
+    static const std::string& symbolName(SymbolId id);
+    static const std::string& userName(UserId id);
+
+    // Number of ids handed out so far
+    static size_t getSymbolCount();
+    static size_t getUserCount();
+
+private:
+    class InternTable {
+    public:
+        uint32_t intern(const std::string& name);
+        uint32_t find(const std::string& name) const;
+        const std::string& name(uint32_t id) const;
+        size_t size() const;
+
+    private:
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, uint32_t> ids;
+        std::deque<std::string> names; // deque keeps element addresses stable
+    };
+
+    static InternTable& symbols();
+    static InternTable& users();
+};
+
+#endif // REGISTRY_H
@@ -0,0 +1,155 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Round a requested capacity up to a power of two (minimum 2)
+inline size_t roundUpToPowerOfTwo(size_t value) {
+    size_t capacity = 2;
+    while (capacity < value) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Bounded lock-free multi-producer / single-consumer queue.
+// Each cell carries a sequence number (Vyukov's bounded queue), so producers
+// claim a slot with one CAS and the consumer never writes shared counters
+// other than the cell it has just drained. T must be default constructible
+// and copy assignable.
+template <typename T>
+class MpscRing {
+public:
+    // Constructor
+    explicit MpscRing(size_t requestedCapacity)
+        : capacity(roundUpToPowerOfTwo(requestedCapacity)), mask(capacity - 1),
+          cells(new Cell[capacity]), enqueuePos(0), dequeuePos(0) {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Non-copyable
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Producer side (any thread); returns false when the ring is full
+    bool tryPush(const T& value) {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side (single thread); returns false when the ring is empty
+    bool tryPop(T& value) {
+        Cell* cell = &cells[dequeuePos & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePos + 1) < 0) {
+            return false;
+        }
+        value = cell->data;
+        cell->sequence.store(dequeuePos + capacity, std::memory_order_release);
+        ++dequeuePos;
+        return true;
+    }
+
+    size_t getCapacity() const { return capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    const size_t capacity;
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    char padBefore[64];
+    std::atomic<size_t> enqueuePos;  // shared by producers
+    char padBetween[64];
+    size_t dequeuePos;               // owned by the consumer
+};
+
+// Bounded lock-free single-producer / single-consumer queue.
+// Each side keeps a cached copy of the other side's index and only reloads
+// the shared atomic when the cache says the ring looks full (producer) or
+// empty (consumer), so the common case touches no shared cache line.
+template <typename T>
+class SpscRing {
+public:
+    // Constructor
+    explicit SpscRing(size_t requestedCapacity)
+        : capacity(roundUpToPowerOfTwo(requestedCapacity)), mask(capacity - 1),
+          slots(new T[capacity]), head(0), cachedTail(0), tail(0), cachedHead(0) {
+    }
+
+    // Non-copyable
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side; returns false when the ring is full
+    bool tryPush(const T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        if (pos - cachedTail >= capacity) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (pos - cachedTail >= capacity) {
+                return false;
+            }
+        }
+        slots[pos & mask] = value;
+        head.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false when the ring is empty
+    bool tryPop(T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        if (pos == cachedHead) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (pos == cachedHead) {
+                return false;
+            }
+        }
+        value = slots[pos & mask];
+        tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t getCapacity() const { return capacity; }
+
+    // Total pushed / popped so far (any thread; monotonic)
+    size_t getPushedCount() const { return head.load(std::memory_order_acquire); }
+    size_t getPoppedCount() const { return tail.load(std::memory_order_acquire); }
+
+private:
+    const size_t capacity;
+    const size_t mask;
+    std::unique_ptr<T[]> slots;
+    char padBefore[64];
+    std::atomic<size_t> head;   // written by the producer
+    size_t cachedTail;          // producer's view of tail
+    char padBetween[64];
+    std::atomic<size_t> tail;   // written by the consumer
+    size_t cachedHead;          // consumer's view of head
+};
+
+#endif // RINGBUFFER_H
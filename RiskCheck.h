@@ -0,0 +1,30 @@
+#ifndef RISKCHECK_H
+#define RISKCHECK_H
+
+#include <cstdint>
+
+// Outcome of a pre-trade check: the first limit an order breaks
+enum class RiskCheck : uint8_t {
+    PASSED,
+    ORDER_QUANTITY,
+    ORDER_NOTIONAL,
+    POSITION_LIMIT,
+    OPEN_NOTIONAL,
+    BUYING_POWER,
+    COUNT
+};
+
+inline const char* getRiskCheckName(RiskCheck check) {
+    switch (check) {
+        case RiskCheck::PASSED: return "passed";
+        case RiskCheck::ORDER_QUANTITY: return "order quantity";
+        case RiskCheck::ORDER_NOTIONAL: return "order notional";
+        case RiskCheck::POSITION_LIMIT: return "position limit";
+        case RiskCheck::OPEN_NOTIONAL: return "open notional";
+        case RiskCheck::BUYING_POWER: return "buying power";
+        case RiskCheck::COUNT: break;
+    }
+    return "unknown";
+}
+
+#endif // RISKCHECK_H
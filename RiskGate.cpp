@@ -0,0 +1,198 @@
+#include "RiskGate.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+RiskGate::RiskGate(const RiskLimits& riskLimits) : limits(riskLimits), checks(0) {
+    std::fill(rejects, rejects + static_cast<size_t>(RiskCheck::COUNT), 0);
+}
+
+RiskGate::Account& RiskGate::account(UserId user) {
+    if (user >= accounts.size()) {
+        accounts.resize(static_cast<size_t>(user) + 1, Account{ 0.0, 0.0, 0.0, 0, {} });
+    }
+    return accounts[user];
+}
+
+RiskGate::Exposure& RiskGate::exposure(Account& holder, SymbolId symbol) {
+    if (symbol >= holder.exposures.size()) {
+        holder.exposures.resize(static_cast<size_t>(symbol) + 1, Exposure{ 0, 0, 0, 0.0, 0.0 });
+    }
+    return holder.exposures[symbol];
+}
+
+RiskCheck RiskGate::reject(RiskCheck reason) {
+    ++rejects[static_cast<size_t>(reason)];
+    return reason;
+}
+
+// Limits in order of cost; the order is counted as open only if all pass
+RiskCheck RiskGate::checkOrder(UserId user, SymbolId symbol, OrderSide side, int quantity, double price) {
+    ++checks;
+    double notional = quantity * price;
+    if (limits.maxOrderQuantity > 0 && quantity > limits.maxOrderQuantity) {
+        return reject(RiskCheck::ORDER_QUANTITY);
+    }
+    if (limits.maxOrderNotional > 0 && notional > limits.maxOrderNotional) {
+        return reject(RiskCheck::ORDER_NOTIONAL);
+    }
+    Account& holder = account(user);
+    Exposure& held = exposure(holder, symbol);
+    bool buy = side == OrderSide::BUY;
+    if (limits.maxPosition > 0) {
+        // Worst case: every resting order on this side fills too
+        int64_t reach = buy ? held.position + held.openBuy + quantity : held.openSell + quantity - held.position;
+        if (reach > limits.maxPosition) {
+            return reject(RiskCheck::POSITION_LIMIT);
+        }
+    }
+    if (limits.maxOpenNotional > 0 && holder.openBuyNotional + holder.openSellNotional + notional > limits.maxOpenNotional) {
+        return reject(RiskCheck::OPEN_NOTIONAL);
+    }
+    if (limits.requireBuyingPower && buy && holder.openBuyNotional + notional > holder.cash) {
+        return reject(RiskCheck::BUYING_POWER);
+    }
+    addOpen(user, symbol, side, quantity, price);
+    return RiskCheck::PASSED;
+}
+
+void RiskGate::addOpen(UserId user, SymbolId symbol, OrderSide side, int quantity, double price) {
+    Account& holder = account(user);
+    Exposure& held = exposure(holder, symbol);
+    double notional = quantity * price;
+    if (side == OrderSide::BUY) {
+        held.openBuy += quantity;
+        held.openBuyNotional += notional;
+        holder.openBuyNotional += notional;
+    } else {
+        held.openSell += quantity;
+        held.openSellNotional += notional;
+        holder.openSellNotional += notional;
+    }
+    holder.openQuantity += quantity;
+}
+
+void RiskGate::releaseOpen(UserId user, SymbolId symbol, OrderSide side, int quantity, double price) {
+    if (user >= accounts.size() || symbol >= accounts[user].exposures.size()) {
+        return;
+    }
+    Account& holder = accounts[user];
+    Exposure& held = holder.exposures[symbol];
+    double notional = quantity * price;
+    if (side == OrderSide::BUY) {
+        held.openBuy -= quantity;
+        held.openBuyNotional = held.openBuy > 0 ? held.openBuyNotional - notional : 0.0;
+        holder.openBuyNotional -= notional;
+    } else {
+        held.openSell -= quantity;
+        held.openSellNotional = held.openSell > 0 ? held.openSellNotional - notional : 0.0;
+        holder.openSellNotional -= notional;
+    }
+    // Rounding must not leave exposure behind once nothing is open
+    holder.openQuantity -= quantity;
+    if (holder.openQuantity <= 0) {
+        holder.openQuantity = 0;
+        holder.openBuyNotional = 0.0;
+        holder.openSellNotional = 0.0;
+    }
+}
+
+void RiskGate::clearOpen(SymbolId symbol) {
+    for (Account& holder : accounts) {
+        if (symbol >= holder.exposures.size()) {
+            continue;
+        }
+        Exposure& held = holder.exposures[symbol];
+        holder.openBuyNotional -= held.openBuyNotional;
+        holder.openSellNotional -= held.openSellNotional;
+        holder.openQuantity -= held.openBuy + held.openSell;
+        if (holder.openQuantity <= 0) {
+            holder.openQuantity = 0;
+            holder.openBuyNotional = 0.0;
+            holder.openSellNotional = 0.0;
+        }
+        held.openBuy = 0;
+        held.openSell = 0;
+        held.openBuyNotional = 0.0;
+        held.openSellNotional = 0.0;
+    }
+}
+
+void RiskGate::applyFill(const Fill& fill) {
+    double notional = fill.quantity * fill.price;
+    Account& buyer = account(fill.buyUserId);
+    buyer.cash -= notional;
+    exposure(buyer, fill.symbolId).position += fill.quantity;
+    Account& seller = account(fill.sellUserId);
+    seller.cash += notional;
+    exposure(seller, fill.symbolId).position -= fill.quantity;
+}
+
+void RiskGate::setCash(UserId user, double balance) {
+    account(user).cash = balance;
+}
+
+void RiskGate::setPosition(UserId user, SymbolId symbol, int64_t quantity) {
+    Account& holder = account(user);
+    exposure(holder, symbol).position = quantity;
+}
+
+void RiskGate::clear() {
+    accounts.clear();
+}
+
+double RiskGate::getOpenNotional(UserId user) const {
+    return user < accounts.size() ? accounts[user].openBuyNotional + accounts[user].openSellNotional : 0.0;
+}
+
+int64_t RiskGate::getPosition(UserId user, SymbolId symbol) const {
+    if (user >= accounts.size() || symbol >= accounts[user].exposures.size()) {
+        return 0;
+    }
+    return accounts[user].exposures[symbol].position;
+}
+
+int64_t RiskGate::getOpenQuantity(UserId user, SymbolId symbol, OrderSide side) const {
+    if (user >= accounts.size() || symbol >= accounts[user].exposures.size()) {
+        return 0;
+    }
+    const Exposure& held = accounts[user].exposures[symbol];
+    return side == OrderSide::BUY ? held.openBuy : held.openSell;
+}
+
+uint64_t RiskGate::getRejectCount() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < static_cast<size_t>(RiskCheck::COUNT); ++i) {
+        total += rejects[i];
+    }
+    return total;
+}
+
+bool RiskGate::parseLimits(const std::string& text, RiskLimits& parsed) {
+    RiskLimits result;
+    std::stringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t equals = item.find('=');
+        std::string key = item.substr(0, equals);
+        std::string value = (equals == std::string::npos) ? "" : item.substr(equals + 1);
+        char* end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        bool numeric = !value.empty() && end && *end == '\0' && number >= 0;
+        if (key == "cash" && value.empty()) {
+            result.requireBuyingPower = true;
+        } else if (key == "qty" && numeric) {
+            result.maxOrderQuantity = static_cast<int>(number);
+        } else if (key == "notional" && numeric) {
+            result.maxOrderNotional = number;
+        } else if (key == "position" && numeric) {
+            result.maxPosition = static_cast<int64_t>(number);
+        } else if (key == "open" && numeric) {
+            result.maxOpenNotional = number;
+        } else {
+            return false;
+        }
+    }
+    parsed = result;
+    return true;
+}
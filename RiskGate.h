@@ -0,0 +1,104 @@
+#ifndef RISKGATE_H
+#define RISKGATE_H
+
+#include "Order.h"
+#include "Trade.h"
+#include "Registry.h"
+#include "RiskCheck.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pre-trade limits, the same for every account (0 = no limit)
+struct RiskLimits {
+    int maxOrderQuantity;
+    double maxOrderNotional;
+    int64_t maxPosition;        // per symbol, long or short, counting resting orders
+    double maxOpenNotional;     // one account's resting orders, both sides
+    bool requireBuyingPower;    // a buy needs cash for itself and the account's resting buys
+
+    RiskLimits()
+        : maxOrderQuantity(0), maxOrderNotional(0.0), maxPosition(0), maxOpenNotional(0.0),
+          requireBuyingPower(false) {}
+};
+
+// Pre-trade risk checks in front of the matching engine.
+//
+// Each account is one compact record indexed by UserId: cash, the quantity
+// and notional of its resting orders, and per symbol (indexed by SymbolId)
+// its filled position and resting buy and sell quantity. An order is checked
+// against those counters and, if it passes, counted as open right away.
+// Fills move cash and position and release the filled quantity; cancels and
+// expiries release the rest. A check is two indexed loads and a handful of
+// compares, with no walk over orders or trades.
+// Open notional is counted at each order's limit price (market orders at the
+// worst opposite level they reach when they arrive). Matching-thread only.
+class RiskGate {
+public:
+    explicit RiskGate(const RiskLimits& limits = RiskLimits());
+
+    // Non-copyable: attached to one system
+    RiskGate(const RiskGate&) = delete;
+    RiskGate& operator=(const RiskGate&) = delete;
+
+    void setLimits(const RiskLimits& newLimits) { limits = newLimits; }
+    const RiskLimits& getLimits() const { return limits; }
+
+    // Check an order; one that passes is counted as open
+    RiskCheck checkOrder(UserId user, SymbolId symbol, OrderSide side, int quantity, double price);
+
+    // Resting orders
+    void addOpen(UserId user, SymbolId symbol, OrderSide side, int quantity, double price);
+    void releaseOpen(UserId user, SymbolId symbol, OrderSide side, int quantity, double price);
+    void clearOpen(SymbolId symbol);    // the symbol's book was emptied or is being recounted
+
+    // Settled state: a fill moves both accounts' cash and position (open quantity is released separately)
+    void applyFill(const Fill& fill);
+    void setCash(UserId user, double balance);
+    void setPosition(UserId user, SymbolId symbol, int64_t quantity);
+    void clear();                       // no accounts
+
+    // Per-account queries (0 for unknown accounts)
+    double getCash(UserId user) const { return user < accounts.size() ? accounts[user].cash : 0.0; }
+    double getOpenNotional(UserId user) const;
+    int64_t getPosition(UserId user, SymbolId symbol) const;
+    int64_t getOpenQuantity(UserId user, SymbolId symbol, OrderSide side) const;
+
+    // Statistics
+    uint64_t getCheckCount() const { return checks; }
+    uint64_t getRejectCount(RiskCheck reason) const { return rejects[static_cast<size_t>(reason)]; }
+    uint64_t getRejectCount() const;
+
+    // "qty=N,notional=X,position=N,open=X,cash" (any subset, in any order)
+    static bool parseLimits(const std::string& text, RiskLimits& limits);
+
+private:
+    // One account's position in one symbol
+    struct Exposure {
+        int64_t position;
+        int64_t openBuy;
+        int64_t openSell;
+        double openBuyNotional;
+        double openSellNotional;
+    };
+
+    struct Account {
+        double cash;
+        double openBuyNotional;     // totals over exposures
+        double openSellNotional;
+        int64_t openQuantity;       // both sides; notional is reset to exactly 0 when it reaches 0
+        std::vector<Exposure> exposures;    // indexed by SymbolId
+    };
+
+    RiskLimits limits;
+    std::vector<Account> accounts;      // indexed by UserId
+    uint64_t checks;
+    uint64_t rejects[static_cast<size_t>(RiskCheck::COUNT)];
+
+    Account& account(UserId user);
+    Exposure& exposure(Account& holder, SymbolId symbol);
+    RiskCheck reject(RiskCheck reason);
+};
+
+#endif // RISKGATE_H
@@ -0,0 +1,96 @@
+#include "SettlementPipeline.h"
+#include "TradeBookingSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+    const size_t SETTLE_BATCH = 256;    // fills applied per pass
+}
+
+SettlementPipeline::SettlementPipeline(size_t ringCapacity, unsigned idle)
+    : ring(new SpscRing<SettlementRecord>(ringCapacity)), idleMicros(std::max(1u, idle)), system(nullptr),
+      running(false), published(0), fullStalls(0), settled(0), batchCount(0) {
+}
+
+SettlementPipeline::~SettlementPipeline() {
+    stop();
+}
+
+void SettlementPipeline::start(TradeBookingSystem& target) {
+    if (settler.joinable()) {
+        return;
+    }
+    system = &target;
+    running.store(true, std::memory_order_release);
+    settler = std::thread(&SettlementPipeline::settlerLoop, this);
+}
+
+void SettlementPipeline::stop() {
+    if (!settler.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.store(false, std::memory_order_release);
+    }
+    wake.notify_one();
+    settler.join();
+    system = nullptr;
+}
+
+// Ring full: the settler is behind, so wake it and give it the CPU
+void SettlementPipeline::pushBlocked(const SettlementRecord& record) {
+    ++fullStalls;
+    while (!ring->tryPush(record)) {
+        wake.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+void SettlementPipeline::waitSlow(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.notify_one();
+    applied.wait(lock, [&] {
+        return settled.load(std::memory_order_acquire) >= sequence || !settler.joinable();
+    });
+}
+
+// Settlement thread: apply whatever is queued in batches, then sleep until
+// woken or the idle window passes (publish itself never signals)
+void SettlementPipeline::settlerLoop() {
+    std::vector<SettlementRecord> batch;
+    batch.reserve(SETTLE_BATCH);
+    uint64_t done = settled.load(std::memory_order_relaxed);
+    auto window = std::chrono::microseconds(idleMicros);
+
+    for (;;) {
+        bool stopping = !running.load(std::memory_order_acquire);
+        SettlementRecord record;
+        while (batch.size() < SETTLE_BATCH && ring->tryPop(record)) {
+            batch.push_back(record);
+        }
+        bool idle = batch.size() < SETTLE_BATCH;
+        if (!batch.empty()) {
+            system->settleFills(batch.data(), batch.size());
+            done += batch.size();
+            batchCount.fetch_add(1, std::memory_order_relaxed);
+            batch.clear();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                settled.store(done, std::memory_order_release);
+            }
+            applied.notify_all();
+        }
+        if (!idle) {
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        if (running.load(std::memory_order_acquire) && ring->getPushedCount() == ring->getPoppedCount()) {
+            wake.wait_for(lock, window);
+        }
+    }
+}
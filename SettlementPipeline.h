@@ -0,0 +1,96 @@
+#ifndef SETTLEMENTPIPELINE_H
+#define SETTLEMENTPIPELINE_H
+
+#include "Trade.h"
+#include "RingBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class TradeBookingSystem;
+
+// A fill waiting to be settled, with the arrival time of the event that produced it
+struct SettlementRecord {
+    Fill fill;
+    uint64_t eventTicks;    // EngineClock reading; stamps the fill's Trade
+};
+
+// Post-trade settlement off the matching thread.
+//
+// The matching thread publishes each fill into a lock-free ring and moves on
+// to the next order. A settlement thread drains the ring in batches and
+// applies them to portfolios, statistics and valuation
+// (TradeBookingSystem::settleFills). Fills are numbered 1, 2, 3, ... in
+// publish order. waitFor(n) returns once the first n are applied, so a reader
+// that needs a consistent view waits for the last sequence it published.
+// publish and waitFor must come from one thread (the matching thread).
+class SettlementPipeline {
+public:
+    static const size_t DEFAULT_RING_CAPACITY = 65536;
+
+    explicit SettlementPipeline(size_t ringCapacity = DEFAULT_RING_CAPACITY, unsigned idleMicros = 100);
+    ~SettlementPipeline();  // settles everything published, then stops
+
+    // Non-copyable: owns the settlement thread
+    SettlementPipeline(const SettlementPipeline&) = delete;
+    SettlementPipeline& operator=(const SettlementPipeline&) = delete;
+
+    // Started and stopped by TradeBookingSystem::setSettlementPipeline
+    void start(TradeBookingSystem& system);
+    void stop();    // settles everything published first
+    bool isRunning() const { return settler.joinable(); }
+
+    // Matching thread: queue a fill (waits while the ring is full); returns its sequence
+    uint64_t publish(const Fill& fill, uint64_t eventTicks) {
+        SettlementRecord record;
+        record.fill = fill;
+        record.eventTicks = eventTicks;
+        if (!ring->tryPush(record)) {
+            pushBlocked(record);
+        }
+        return ++published;
+    }
+
+    // Matching thread: wait until every fill up to sequence is applied
+    void waitFor(uint64_t sequence) {
+        if (settled.load(std::memory_order_acquire) < sequence) {
+            waitSlow(sequence);
+        }
+    }
+    void sync() { waitFor(published); }
+
+    // Statistics
+    uint64_t getPublishedSequence() const { return published; }
+    uint64_t getSettledSequence() const { return settled.load(std::memory_order_acquire); }
+    uint64_t getBatchCount() const { return batchCount.load(std::memory_order_relaxed); }
+    uint64_t getFullStallCount() const { return fullStalls; }
+    size_t getRingCapacity() const { return ring->getCapacity(); }
+
+private:
+    std::unique_ptr<SpscRing<SettlementRecord>> ring;
+    unsigned idleMicros;
+    TradeBookingSystem* system;
+    std::thread settler;
+    std::atomic<bool> running;
+
+    // Matching thread only
+    uint64_t published;
+    uint64_t fullStalls;
+
+    // Settlement thread -> waiters
+    std::atomic<uint64_t> settled;
+    std::atomic<uint64_t> batchCount;
+    std::mutex mutex;
+    std::condition_variable wake;       // matching thread -> settler
+    std::condition_variable applied;    // settler -> matching thread
+
+    void pushBlocked(const SettlementRecord& record);
+    void waitSlow(uint64_t sequence);
+    void settlerLoop();
+};
+
+#endif // SETTLEMENTPIPELINE_H
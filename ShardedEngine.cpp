@@ -0,0 +1,240 @@
+#include "ShardedEngine.h"
+#include <algorithm>
+
+namespace {
+    // Totals one order's fills and forwards each to the engine's listener
+    struct ShardFillTotals : public ExecutionListener {
+        ExecutionListener* forward;
+        double volume;
+
+        explicit ShardFillTotals(ExecutionListener* forward) : forward(forward), volume(0.0) {}
+
+        void onFill(const Fill& fill) override {
+            volume += fill.quantity * fill.price;
+            if (forward) {
+                forward->onFill(fill);
+            }
+        }
+    };
+}
+
+// Constructor
+ShardedEngine::ShardedEngine(size_t numShards, size_t queueCapacity)
+    : running(false), executionListener(nullptr) {
+    if (numShards == 0) {
+        numShards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < numShards; ++i) {
+        shards.push_back(std::make_unique<Shard>(queueCapacity));
+    }
+}
+
+// Destructor
+ShardedEngine::~ShardedEngine() {
+    stop();
+}
+
+// Start one matching thread per shard
+void ShardedEngine::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    for (auto& shard : shards) {
+        Shard* target = shard.get();
+        shard->thread = std::thread([this, target]() { runShard(*target); });
+    }
+}
+
+// Drain outstanding commands and join the shard threads
+void ShardedEngine::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    for (auto& shard : shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+
+// Submit a new order; returns the order ID it will carry
+OrderId ShardedEngine::submitNewOrder(UserId userId, SymbolId symbol, OrderSide side,
+                                      int quantity, double price, OrderType type) {
+    OrderCommand command;
+    command.type = OrderCommand::NEW_ORDER;
+    command.side = side;
+    command.orderType = type;
+    command.symbol = symbol;
+    command.userId = userId;
+    command.orderId = Order::allocateOrderId();
+    command.quantity = quantity;
+    command.price = price;
+    submit(command);
+    return command.orderId;
+}
+
+// Submit a cancel for an order on the given symbol
+void ShardedEngine::submitCancel(SymbolId symbol, OrderId orderId) {
+    OrderCommand command;
+    command.type = OrderCommand::CANCEL_ORDER;
+    command.side = OrderSide::BUY;
+    command.orderType = OrderType::LIMIT;
+    command.symbol = symbol;
+    command.userId = Registry::INVALID_ID;
+    command.orderId = orderId;
+    command.quantity = 0;
+    command.price = 0.0;
+    submit(command);
+}
+
+// Submit a modify (new quantity and price) for an order on the given symbol
+void ShardedEngine::submitModify(SymbolId symbol, OrderId orderId, int quantity, double price) {
+    OrderCommand command;
+    command.type = OrderCommand::MODIFY_ORDER;
+    command.side = OrderSide::BUY;
+    command.orderType = OrderType::LIMIT;
+    command.symbol = symbol;
+    command.userId = Registry::INVALID_ID;
+    command.orderId = orderId;
+    command.quantity = quantity;
+    command.price = price;
+    submit(command);
+}
+
+// Open a symbol's call auction, or uncross it
+void ShardedEngine::submitAuction(SymbolId symbol, OrderCommand::Type type) {
+    OrderCommand command;
+    command.type = type;
+    command.side = OrderSide::BUY;
+    command.orderType = OrderType::LIMIT;
+    command.symbol = symbol;
+    command.userId = Registry::INVALID_ID;
+    command.orderId = 0;
+    command.quantity = 0;
+    command.price = 0.0;
+    submit(command);
+}
+
+// Route a command to its shard
+void ShardedEngine::submit(const OrderCommand& command) {
+    Shard& shard = *shards[shardFor(command.symbol)];
+    shard.submitted.fetch_add(1, std::memory_order_relaxed);
+    while (!shard.inbox.tryPush(command)) {
+        std::this_thread::yield(); // back-pressure: the shard is behind
+    }
+}
+
+// Wait for every shard to catch up with its submissions
+void ShardedEngine::waitUntilIdle() const {
+    for (const auto& shard : shards) {
+        while (shard->processed.load(std::memory_order_acquire) <
+               shard->submitted.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Statistics
+uint64_t ShardedEngine::getCommandsProcessed() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard->processed.load(std::memory_order_acquire);
+    }
+    return total;
+}
+
+uint64_t ShardedEngine::getTradesExecuted() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard->tradesExecuted.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double ShardedEngine::getVolumeTraded() const {
+    double total = 0.0;
+    for (const auto& shard : shards) {
+        total += shard->volumeTraded.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t ShardedEngine::getRestingOrderCount() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        for (const auto& book : shard->books) {
+            if (book) {
+                total += book->getTotalOrderCount();
+            }
+        }
+    }
+    return total;
+}
+
+// Single-writer matching loop for one shard
+void ShardedEngine::runShard(Shard& shard) {
+    OrderCommand command;
+    for (;;) {
+        if (shard.inbox.tryPop(command)) {
+            processCommand(shard, command);
+            shard.processed.fetch_add(1, std::memory_order_release);
+        } else if (!running.load(std::memory_order_acquire)) {
+            // Stopped: exit once everything submitted so far is done
+            if (shard.processed.load(std::memory_order_relaxed) >=
+                shard.submitted.load(std::memory_order_acquire)) {
+                break;
+            }
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Apply one command to the shard's books
+void ShardedEngine::processCommand(Shard& shard, const OrderCommand& command) {
+    bool needsBook = command.type == OrderCommand::CANCEL_ORDER || command.type == OrderCommand::MODIFY_ORDER ||
+                     command.type == OrderCommand::UNCROSS;
+    if (command.symbol >= shard.books.size()) {
+        if (needsBook) {
+            return;
+        }
+        shard.books.resize(command.symbol + 1);
+    }
+
+    std::unique_ptr<OrderBook>& book = shard.books[command.symbol];
+
+    if (!book && needsBook) {
+        return;
+    }
+    if (command.type == OrderCommand::CANCEL_ORDER) {
+        book->cancelOrder(command.orderId);
+        return;
+    }
+
+    if (!book) {
+        book = std::make_unique<OrderBook>(command.symbol, shard.directory);
+    }
+    if (command.type == OrderCommand::OPEN_CALL) {
+        book->setInCall(true);
+        return;
+    }
+
+    ShardFillTotals totals(executionListener);
+    size_t fills = 0;
+    if (command.type == OrderCommand::UNCROSS) {
+        AuctionIndicative result;
+        fills = book->isInCall() ? MatchingEngine::uncross(*book, totals, result) : 0;
+    } else if (command.type == OrderCommand::MODIFY_ORDER) {
+        MatchingEngine::modifyOrder(*book, command.orderId, command.quantity, command.price, totals, fills);
+    } else {
+        Order* order = book->createOrder(command.orderId, command.side, command.quantity,
+                                         command.price, command.userId, command.orderType);
+        fills = MatchingEngine::matchOrder(*book, order, totals);
+    }
+
+    if (fills > 0) {
+        shard.tradesExecuted.fetch_add(fills, std::memory_order_relaxed);
+        shard.volumeTraded.store(shard.volumeTraded.load(std::memory_order_relaxed) + totals.volume,
+                                 std::memory_order_relaxed);
+    }
+}
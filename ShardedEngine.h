@@ -0,0 +1,101 @@
+#ifndef SHARDEDENGINE_H
+#define SHARDEDENGINE_H
+
+#include "OrderBook.h"
+#include "MatchingEngine.h"
+#include "RingBuffer.h"
+#include "Registry.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Inbound message routed to a matching shard
+struct OrderCommand {
+    enum Type : uint8_t { NEW_ORDER, CANCEL_ORDER, MODIFY_ORDER, OPEN_CALL, UNCROSS };
+
+    Type type;
+    OrderSide side;
+    OrderType orderType;
+    SymbolId symbol;
+    UserId userId;
+    OrderId orderId;
+    int quantity;
+    double price;
+};
+
+// Multi-threaded matching engine partitioned by symbol.
+// Every shard owns a disjoint set of OrderBooks and runs a single-writer
+// matching loop on its own thread, fed by a lock-free MPSC ring. Any thread
+// may submit; a symbol always routes to the same shard, so per-symbol order
+// is preserved and books never need locking. Order ids are reserved at
+// submit time so callers can cancel without waiting for the shard.
+class ShardedEngine {
+public:
+    static const size_t DEFAULT_QUEUE_CAPACITY = 65536;
+
+    // Constructor (numShards == 0 picks one shard per hardware thread)
+    explicit ShardedEngine(size_t numShards = 0,
+                           size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+    // Destructor - stops and joins the shard threads
+    ~ShardedEngine();
+
+    // Non-copyable
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    // Lifecycle
+    // Listener is called on the shard threads for every fill (set before start)
+    void setExecutionListener(ExecutionListener* listener) { executionListener = listener; }
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Order entry (safe from any thread; spins while the shard's ring is full)
+    OrderId submitNewOrder(UserId userId, SymbolId symbol, OrderSide side, int quantity, double price,
+                           OrderType type = OrderType::LIMIT);
+    void submitCancel(SymbolId symbol, OrderId orderId);
+    void submitModify(SymbolId symbol, OrderId orderId, int quantity, double price);
+    void submitAuction(SymbolId symbol, OrderCommand::Type type);   // OPEN_CALL or UNCROSS
+    void submit(const OrderCommand& command);
+
+    // Block until every submitted command has been processed
+    void waitUntilIdle() const;
+
+    // Routing
+    size_t getShardCount() const { return shards.size(); }
+    size_t shardFor(SymbolId symbol) const { return symbol % shards.size(); }
+
+    // Statistics (aggregated across shards)
+    uint64_t getCommandsProcessed() const;
+    uint64_t getTradesExecuted() const;
+    double getVolumeTraded() const;
+    size_t getRestingOrderCount() const; // only meaningful when idle
+
+private:
+    struct Shard {
+        MpscRing<OrderCommand> inbox;
+        OrderDirectory directory;                       // resting orders of the shard's books
+        std::vector<std::unique_ptr<OrderBook>> books; // indexed by SymbolId, shard-owned
+        std::thread thread;
+        std::atomic<uint64_t> submitted;
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> tradesExecuted;
+        std::atomic<double> volumeTraded;
+
+        explicit Shard(size_t queueCapacity)
+            : inbox(queueCapacity), submitted(0), processed(0),
+              tradesExecuted(0), volumeTraded(0.0) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<bool> running;
+    ExecutionListener* executionListener;
+
+    void runShard(Shard& shard);
+    void processCommand(Shard& shard, const OrderCommand& command);
+};
+
+#endif // SHARDEDENGINE_H
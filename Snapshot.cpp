@@ -0,0 +1,535 @@
+#include "Snapshot.h"
+#include "TradeBookingSystem.h"
+#include "Journal.h"
+#include "EngineClock.h"
+#include "NameTable.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    const size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+    // Buffered writes straight to a descriptor through a caller-owned buffer,
+    // so writing allocates nothing and takes no stdio lock
+    class SnapshotOutput {
+    public:
+        SnapshotOutput(int descriptor, std::vector<char>& buffer) : fd(descriptor), buffer(buffer), used(0) {}
+
+        bool write(const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                if (used == buffer.size() && !flush()) {
+                    return false;
+                }
+                size_t count = std::min(size, buffer.size() - used);
+                std::memcpy(&buffer[used], bytes, count);
+                used += count;
+                bytes += count;
+                size -= count;
+            }
+            return true;
+        }
+
+        bool flush() {
+            const char* data = buffer.data();
+            while (used > 0) {
+                ssize_t count = ::write(fd, data, used);
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += count;
+                used -= static_cast<size_t>(count);
+            }
+            return true;
+        }
+
+    private:
+        int fd;
+        std::vector<char>& buffer;
+        size_t used;
+    };
+
+    template <typename T>
+    bool writeRecord(SnapshotOutput& file, const T& record) {
+        return file.write(&record, sizeof(record));
+    }
+
+    // Bounds-checked cursor over the mapped file
+    class SnapshotCursor {
+    public:
+        SnapshotCursor(const char* data, size_t size) : position(data), end(data + size) {}
+
+        template <typename T>
+        const T* take(uint64_t count) {
+            if (count > static_cast<uint64_t>(end - position) / sizeof(T)) {
+                return nullptr;
+            }
+            const T* records = reinterpret_cast<const T*>(position);
+            position += count * sizeof(T);
+            return records;
+        }
+
+        // count name entries (see NameTable.h)
+        bool takeNames(uint32_t count, std::vector<std::string>& names) {
+            size_t offset = 0;
+            if (!readNames(position, static_cast<size_t>(end - position), offset, count, names)) {
+                return false;
+            }
+            position += offset;
+            return true;
+        }
+
+        bool atEnd() const { return position == end; }
+
+    private:
+        const char* position;
+        const char* end;
+    };
+
+    // Every count adds up to the header's totals and every index, order id and
+    // code is in range; checked before load() changes anything
+    bool checkSections(const SnapshotHeader& header, const SnapshotBook* books, const SnapshotOrder* orders,
+                       const SnapshotPortfolio* portfolios, const SnapshotPosition* positions,
+                       const SnapshotTrade* trades) {
+        uint64_t orderTotal = 0;
+        for (uint32_t b = 0; b < header.bookCount; ++b) {
+            if (books[b].symbol >= header.symbolCount || books[b].orderCount > header.orderCount - orderTotal) {
+                return false;
+            }
+            orderTotal += books[b].orderCount;
+        }
+        uint64_t positionTotal = 0;
+        uint64_t tradeTotal = 0;
+        for (uint32_t p = 0; p < header.portfolioCount; ++p) {
+            if (portfolios[p].user >= header.userCount
+                || portfolios[p].positionCount > header.positionCount - positionTotal
+                || portfolios[p].tradeCount > header.tradeCount - tradeTotal) {
+                return false;
+            }
+            positionTotal += portfolios[p].positionCount;
+            tradeTotal += portfolios[p].tradeCount;
+        }
+        if (orderTotal != header.orderCount || positionTotal != header.positionCount
+            || tradeTotal != header.tradeCount) {
+            return false;
+        }
+
+        std::vector<OrderId> orderIds;
+        orderIds.reserve(static_cast<size_t>(header.orderCount));
+        for (uint64_t i = 0; i < header.orderCount; ++i) {
+            const SnapshotOrder& order = orders[i];
+            if (order.user >= header.userCount || order.side > 1 || !isOrderTypeCode(order.type)
+                || order.orderId == 0 || order.orderId >= header.nextOrderId) {
+                return false;
+            }
+            orderIds.push_back(order.orderId);
+        }
+        std::sort(orderIds.begin(), orderIds.end());
+        if (std::adjacent_find(orderIds.begin(), orderIds.end()) != orderIds.end()) {
+            return false;
+        }
+
+        for (uint64_t i = 0; i < header.positionCount; ++i) {
+            if (positions[i].symbol >= header.symbolCount) {
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < header.tradeCount; ++i) {
+            if (trades[i].symbol >= header.symbolCount || trades[i].buyUser >= header.userCount
+                || trades[i].sellUser >= header.userCount) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Copy the name tables (on the engine thread, so a forked child never touches the Registry lock)
+void SystemSnapshot::collectNames(SnapshotNames& names) {
+    names.symbolCount = static_cast<uint32_t>(Registry::getSymbolCount());
+    names.userCount = static_cast<uint32_t>(Registry::getUserCount());
+    names.symbols.clear();
+    names.users.clear();
+    for (SymbolId id = 0; id < names.symbolCount; ++id) {
+        appendName(names.symbols, Registry::symbolName(id));
+    }
+    for (UserId id = 0; id < names.userCount; ++id) {
+        appendName(names.users, Registry::userName(id));
+    }
+}
+
+bool SystemSnapshot::write(const TradeBookingSystem& system, const std::string& path, uint64_t journalSequence) {
+    SnapshotNames names;
+    collectNames(names);
+    std::vector<char> buffer(WRITE_BUFFER_BYTES);
+    // writeFile reads portfolios and statistics without waiting for settlement
+    system.awaitSettlement();
+    if (!writeFile(system, path, path + ".tmp", journalSequence, names, buffer)) {
+        std::cerr << "Cannot write snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Write to temporaryPath, sync, then rename over path. Everything it needs is
+// allocated by the caller and it only makes system calls, takes no locks and
+// prints nothing, so it is safe in a child forked from a multi-threaded process.
+// Portfolios and statistics are read directly, never through the getters that
+// wait for settlement; the caller settles every fill first.
+bool SystemSnapshot::writeFile(const TradeBookingSystem& system, const std::string& path,
+                               const std::string& temporaryPath, uint64_t journalSequence,
+                               const SnapshotNames& names, std::vector<char>& buffer) {
+    uint32_t symbolCount = names.symbolCount;
+    uint32_t userCount = names.userCount;
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.journalSequence = journalSequence;
+    header.totalTrades = system.totalTradesExecuted;
+    header.totalVolume = system.totalVolumeTraded;
+    header.nextOrderId = Order::getNextOrderId();
+    header.nextTradeId = Trade::getNextTradeId();
+    header.symbolCount = symbolCount;
+    header.userCount = userCount;
+    for (SymbolId symbol = 0; symbol < symbolCount; ++symbol) {
+        const OrderBook* book = system.getOrderBook(symbol);
+        if (book && (!book->isEmpty() || book->isInCall())) {
+            ++header.bookCount;
+            header.orderCount += book->getTotalOrderCount();
+        }
+    }
+    for (UserId user = 0; user < userCount; ++user) {
+        const Portfolio* portfolio = system.portfolioAt(user);
+        if (portfolio) {
+            ++header.portfolioCount;
+            header.positionCount += portfolio->getPositions().size();
+            header.tradeCount += portfolio->getTradeCount();
+        }
+    }
+
+    int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    SnapshotOutput file(fd, buffer);
+    bool ok = writeRecord(file, header)
+              && file.write(names.symbols.data(), names.symbols.size())
+              && file.write(names.users.data(), names.users.size());
+
+    for (SymbolId symbol = 0; ok && symbol < symbolCount; ++symbol) {
+        ok = writeRecord(file, system.getMarketPrice(symbol));
+    }
+
+    // Books, then their orders best level first and FIFO within a level
+    for (SymbolId symbol = 0; ok && symbol < symbolCount; ++symbol) {
+        const OrderBook* book = system.getOrderBook(symbol);
+        if (book && (!book->isEmpty() || book->isInCall())) {
+            uint32_t flags = book->isInCall() ? static_cast<uint32_t>(SnapshotBook::IN_CALL) : 0u;
+            SnapshotBook entry = { symbol, flags, book->getTotalOrderCount() };
+            ok = writeRecord(file, entry);
+        }
+    }
+    for (SymbolId symbol = 0; ok && symbol < symbolCount; ++symbol) {
+        const OrderBook* book = system.getOrderBook(symbol);
+        if (!book || book->isEmpty()) {
+            continue;
+        }
+        for (const PriceLadder* ladder : { &book->getBuyOrders(), &book->getSellOrders() }) {
+            for (const PriceLevel* level = ladder->best(); ok && level; level = ladder->next(*level)) {
+                for (const Order* order = level->head; ok && order; order = order->nextInLevel) {
+                    SnapshotOrder record = {};
+                    record.orderId = order->orderId;
+                    record.user = order->userId;
+                    record.quantity = order->quantity;
+                    record.side = order->side == OrderSide::BUY ? 0 : 1;
+                    record.type = getOrderTypeCode(order->type);
+                    record.price = order->price;
+                    ok = writeRecord(file, record);
+                }
+            }
+        }
+    }
+
+    // Portfolios, then all their positions, then all their trades
+    for (UserId user = 0; ok && user < userCount; ++user) {
+        const Portfolio* portfolio = system.portfolioAt(user);
+        if (portfolio) {
+            SnapshotPortfolio entry = { user, static_cast<uint32_t>(portfolio->getPositions().size()),
+                                        portfolio->getTradeCount(), portfolio->getCashBalance() };
+            ok = writeRecord(file, entry);
+        }
+    }
+    for (UserId user = 0; ok && user < userCount; ++user) {
+        const Portfolio* portfolio = system.portfolioAt(user);
+        if (!portfolio) {
+            continue;
+        }
+        for (const Position& position : portfolio->getPositions()) {
+            SnapshotPosition record = { position.symbol, position.quantity, position.averageCost, position.realizedPnL };
+            if (!(ok = writeRecord(file, record))) {
+                break;
+            }
+        }
+    }
+    for (UserId user = 0; ok && user < userCount; ++user) {
+        const Portfolio* portfolio = system.portfolioAt(user);
+        if (!portfolio) {
+            continue;
+        }
+        for (const Trade& trade : portfolio->getTradeHistory()) {
+            SnapshotTrade record = {};
+            record.tradeId = trade.tradeId;
+            record.symbol = trade.symbolId;
+            record.buyOrderId = trade.buyOrderId;
+            record.sellOrderId = trade.sellOrderId;
+            record.buyUser = trade.buyUserId;
+            record.sellUser = trade.sellUserId;
+            record.quantity = trade.quantity;
+            record.price = trade.price;
+            record.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                trade.timestamp.time_since_epoch()).count();
+            if (!(ok = writeRecord(file, record))) {
+                break;
+            }
+        }
+    }
+
+    ok = ok && file.flush() && fdatasync(fd) == 0;
+    ok = (::close(fd) == 0) && ok;
+    ok = ok && ::rename(temporaryPath.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        ::unlink(temporaryPath.c_str());
+    }
+    return ok;
+}
+
+// Map the file and rebuild every book and portfolio from it
+bool SystemSnapshot::load(const std::string& path, TradeBookingSystem& system, SnapshotInfo& info) {
+    info = SnapshotInfo();
+    uint64_t start = EngineClock::now();
+    system.awaitSettlement();   // portfolios are replaced below
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SnapshotHeader)) {
+        std::cerr << "Snapshot is truncated: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Cannot map snapshot: " << path << std::endl;
+        return false;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    SnapshotCursor cursor(static_cast<const char*>(mapping), size);
+    const SnapshotHeader* header = cursor.take<SnapshotHeader>(1);
+    bool valid = std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0
+                 && header->version == SNAPSHOT_VERSION && header->headerSize == sizeof(SnapshotHeader);
+    std::vector<std::string> symbolNames;
+    std::vector<std::string> userNames;
+    bool named = valid && cursor.takeNames(header->symbolCount, symbolNames)
+                 && cursor.takeNames(header->userCount, userNames);
+    const double* prices = named ? cursor.take<double>(header->symbolCount) : nullptr;
+    const SnapshotBook* books = prices ? cursor.take<SnapshotBook>(header->bookCount) : nullptr;
+    const SnapshotOrder* orders = books ? cursor.take<SnapshotOrder>(header->orderCount) : nullptr;
+    const SnapshotPortfolio* portfolios = orders ? cursor.take<SnapshotPortfolio>(header->portfolioCount) : nullptr;
+    const SnapshotPosition* positions = portfolios ? cursor.take<SnapshotPosition>(header->positionCount) : nullptr;
+    const SnapshotTrade* trades = positions ? cursor.take<SnapshotTrade>(header->tradeCount) : nullptr;
+    if (!trades || !cursor.atEnd()
+        || !checkSections(*header, books, orders, portfolios, positions, trades)) {
+        std::cerr << "Not a valid snapshot: " << path << std::endl;
+        munmap(mapping, size);
+        return false;
+    }
+
+    // Snapshot indexes -> this process's ids
+    std::vector<SymbolId> symbols(header->symbolCount);
+    std::vector<UserId> users(header->userCount);
+    for (uint32_t i = 0; i < header->symbolCount; ++i) {
+        symbols[i] = Registry::internSymbol(symbolNames[i]);
+        if (prices[i] > 0) {
+            system.updateMarketPrice(symbols[i], prices[i]);
+        }
+    }
+    for (uint32_t i = 0; i < header->userCount; ++i) {
+        users[i] = Registry::internUser(userNames[i]);
+    }
+
+    // Orders arrive in priority order, so appending each one rebuilds every queue exactly
+    const SnapshotOrder* order = orders;
+    for (uint32_t b = 0; b < header->bookCount; ++b) {
+        SymbolId symbol = symbols[books[b].symbol];
+        system.ensureSymbolSlot(symbol);
+        OrderBook& book = system.resetOrderBook(symbol);
+        book.setInCall((books[b].flags & SnapshotBook::IN_CALL) != 0);
+        for (uint64_t i = 0; i < books[b].orderCount; ++i, ++order) {
+            book.addOrder(book.createOrder(order->orderId, order->side == 0 ? OrderSide::BUY : OrderSide::SELL,
+                                           order->quantity, order->price, users[order->user],
+                                           getOrderTypeFromCode(order->type)));
+        }
+        ++info.books;
+        info.orders += books[b].orderCount;
+    }
+
+    const SnapshotPosition* position = positions;
+    const SnapshotTrade* trade = trades;
+    for (uint32_t p = 0; p < header->portfolioCount; ++p) {
+        UserId user = users[portfolios[p].user];
+        system.ensureUserSlot(user);
+        system.portfolios[user] = std::make_unique<Portfolio>(user, portfolios[p].cash);
+        Portfolio& portfolio = *system.portfolios[user];
+        for (uint32_t i = 0; i < portfolios[p].positionCount; ++i, ++position) {
+            Position held(symbols[position->symbol]);
+            held.quantity = position->position;
+            held.averageCost = position->averageCost;
+            held.realizedPnL = position->realizedPnL;
+            portfolio.restorePosition(held);
+        }
+        portfolio.reserveTradeHistory(portfolios[p].tradeCount);
+        for (uint64_t i = 0; i < portfolios[p].tradeCount; ++i, ++trade) {
+            Fill fill = { trade->tradeId, symbols[trade->symbol], trade->buyOrderId, trade->sellOrderId,
+                          users[trade->buyUser], users[trade->sellUser], trade->quantity, trade->price };
+            std::chrono::system_clock::time_point time(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(trade->timestampNs)));
+            portfolio.restoreTrade(Trade(fill, time));
+        }
+        ++info.portfolios;
+        info.trades += portfolios[p].tradeCount;
+    }
+
+    system.totalTradesExecuted = static_cast<size_t>(header->totalTrades);
+    system.totalVolumeTraded = header->totalVolume;
+    Order::advanceNextOrderId(header->nextOrderId);
+    Trade::advanceNextTradeId(header->nextTradeId);
+    info.journalSequence = header->journalSequence;
+    munmap(mapping, size);
+    info.seconds = static_cast<double>(EngineClock::elapsedNanos(start, EngineClock::now())) / 1e9;
+    return true;
+}
+
+void SystemSnapshot::printLoad(const SnapshotInfo& info) {
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Snapshot: loaded " << info.orders << " resting orders in " << info.books << " books, "
+              << info.portfolios << " portfolios (" << info.trades << " trades) in "
+              << std::fixed << std::setprecision(3) << info.seconds << " s";
+    if (info.journalSequence > 0) {
+        std::cout << ", journal sequence " << info.journalSequence;
+    }
+    std::cout << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+// ---- SnapshotWriter ----
+
+SnapshotWriter::SnapshotWriter(TradeBookingSystem& tradingSystem, const std::string& snapshotPath)
+    : system(tradingSystem), path(snapshotPath), interval(0), eventsSinceSnapshot(0), child(-1),
+      snapshotCount(0), failureCount(0), lastSucceeded(true) {
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    wait();
+}
+
+// Synchronous snapshot on the engine thread
+bool SnapshotWriter::write() {
+    wait();
+    lastSucceeded = SystemSnapshot::write(system, path, currentJournalSequence());
+    ++(lastSucceeded ? snapshotCount : failureCount);
+    return lastSucceeded;
+}
+
+// Fork; the child writes from its copy-on-write image and exits
+bool SnapshotWriter::startBackground() {
+    if (isBusy()) {
+        return false;
+    }
+    uint64_t journalSequence = currentJournalSequence();
+    SnapshotNames names;
+    SystemSnapshot::collectNames(names);
+    std::string temporaryPath = path + ".tmp";
+    std::vector<char> buffer(WRITE_BUFFER_BYTES);
+    // The child has no settlement thread, so every fill must be applied before the fork
+    system.awaitSettlement();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        bool ok = SystemSnapshot::writeFile(system, path, temporaryPath, journalSequence, names, buffer);
+        _exit(ok ? 0 : 1);
+    }
+    if (pid < 0) {
+        std::cerr << "Cannot start background snapshot: fork failed" << std::endl;
+        ++failureCount;
+        lastSucceeded = false;
+        return false;
+    }
+    child = pid;
+    return true;
+}
+
+bool SnapshotWriter::isBusy() {
+    if (child > 0) {
+        int status = 0;
+        if (waitpid(child, &status, WNOHANG) == child) {
+            finish(status);
+        }
+    }
+    return child > 0;
+}
+
+bool SnapshotWriter::wait() {
+    if (child > 0) {
+        int status = 0;
+        if (waitpid(child, &status, 0) == child) {
+            finish(status);
+        } else {
+            child = -1;
+            ++failureCount;
+            lastSucceeded = false;
+        }
+    }
+    return lastSucceeded;
+}
+
+// The snapshot must not get ahead of what the journal has on disk
+uint64_t SnapshotWriter::currentJournalSequence() {
+    Journal* journal = system.getJournal();
+    if (!journal || !journal->isOpen()) {
+        return 0;
+    }
+    journal->sync();
+    return journal->getLastSequence();
+}
+
+void SnapshotWriter::finish(int status) {
+    child = -1;
+    lastSucceeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (lastSucceeded) {
+        ++snapshotCount;
+    } else {
+        ++failureCount;
+        std::cerr << "Background snapshot failed: " << path << std::endl;
+    }
+}
@@ -0,0 +1,190 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Registry.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+class TradeBookingSystem;
+
+// Binary snapshot of the whole system state.
+//
+// File layout (native little-endian, no padding between sections):
+//   SnapshotHeader
+//   symbolCount    x name entry                symbol names (see below)
+//   userCount      x name entry                user names
+//   symbolCount    x double                    market prices (0 = unset)
+//   bookCount      x SnapshotBook
+//   orderCount     x SnapshotOrder             per book: bids then asks, each in priority order
+//   portfolioCount x SnapshotPortfolio
+//   positionCount  x SnapshotPosition          per portfolio, in portfolio order
+//   tradeCount     x SnapshotTrade             per portfolio, oldest first
+//
+// Name entries are encoded as in NameTable.h, so the sections after the
+// tables stay aligned. Symbols and users are referred to by their index in
+// the name tables, so a snapshot is independent of the ids a particular
+// process assigns. The file is written under a temporary name and renamed
+// into place, so a reader only ever sees a complete snapshot.
+
+static const char SNAPSHOT_MAGIC[8] = { 'T', 'B', 'S', 'S', 'N', 'A', 'P', '1' };
+static const uint32_t SNAPSHOT_VERSION = 4;   // 2: realized P&L per position, 3: 64-bit order ids, 4: order type codes
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t journalSequence;   // last journal record reflected (0 = none)
+    uint64_t totalTrades;
+    double totalVolume;
+    uint64_t nextOrderId;
+    int32_t nextTradeId;
+    uint32_t symbolCount;
+    uint32_t userCount;
+    uint32_t bookCount;
+    uint32_t portfolioCount;
+    uint32_t reserved;
+    uint64_t orderCount;
+    uint64_t positionCount;
+    uint64_t tradeCount;
+};
+
+struct SnapshotBook {
+    enum Flags : uint32_t { IN_CALL = 1 };  // call auction phase (see MatchingEngine::uncross)
+
+    uint32_t symbol;
+    uint32_t flags;
+    uint64_t orderCount;
+};
+
+struct SnapshotOrder {
+    uint64_t orderId;
+    uint32_t user;
+    int32_t quantity;
+    uint8_t side;           // 0 = BUY, 1 = SELL
+    uint8_t type;           // getOrderTypeCode (0 = LIMIT)
+    uint16_t reserved;
+    uint32_t padding;
+    double price;
+};
+
+struct SnapshotPortfolio {
+    uint32_t user;
+    uint32_t positionCount;
+    uint64_t tradeCount;
+    double cash;
+};
+
+struct SnapshotPosition {
+    uint32_t symbol;
+    int32_t position;
+    double averageCost;
+    double realizedPnL;
+};
+
+struct SnapshotTrade {
+    int32_t tradeId;
+    uint32_t symbol;
+    uint64_t buyOrderId;
+    uint64_t sellOrderId;
+    uint32_t buyUser;
+    uint32_t sellUser;
+    int32_t quantity;
+    uint32_t reserved;
+    double price;
+    int64_t timestampNs;    // system_clock time since the epoch
+};
+
+static_assert(sizeof(SnapshotHeader) == 96, "SnapshotHeader must stay fixed width");
+static_assert(sizeof(SnapshotOrder) == 32, "SnapshotOrder must stay fixed width");
+static_assert(sizeof(SnapshotPosition) == 24, "SnapshotPosition must stay fixed width");
+static_assert(sizeof(SnapshotTrade) == 56, "SnapshotTrade must stay fixed width");
+
+// Encoded name tables, copied on the engine thread before a snapshot is written
+struct SnapshotNames {
+    uint32_t symbolCount;
+    uint32_t userCount;
+    std::vector<char> symbols;
+    std::vector<char> users;
+
+    SnapshotNames() : symbolCount(0), userCount(0) {}
+};
+
+// What load() restored
+struct SnapshotInfo {
+    uint64_t journalSequence;
+    size_t books;
+    size_t orders;
+    size_t portfolios;
+    size_t trades;
+    double seconds;
+
+    SnapshotInfo() : journalSequence(0), books(0), orders(0), portfolios(0), trades(0), seconds(0.0) {}
+};
+
+// Whole-system snapshot save and load
+class SystemSnapshot {
+public:
+    // Write the current state (journalSequence = last journal record it reflects)
+    static bool write(const TradeBookingSystem& system, const std::string& path, uint64_t journalSequence);
+
+    // Restore into a freshly constructed system; false if the file is missing or invalid
+    static bool load(const std::string& path, TradeBookingSystem& system, SnapshotInfo& info);
+    static void printLoad(const SnapshotInfo& info);
+
+private:
+    static bool writeFile(const TradeBookingSystem& system, const std::string& path,
+                          const std::string& temporaryPath, uint64_t journalSequence,
+                          const SnapshotNames& names, std::vector<char>& buffer);
+    static void collectNames(SnapshotNames& names);
+    friend class SnapshotWriter;
+};
+
+// Takes snapshots for one system, either on the calling thread or in a
+// forked child that writes from its copy-on-write image while matching goes
+// on. Calls must come from the thread that changes the system, between
+// events, so every snapshot is consistent and matches one journal sequence.
+class SnapshotWriter {
+public:
+    SnapshotWriter(TradeBookingSystem& tradingSystem, const std::string& snapshotPath);
+    ~SnapshotWriter();  // waits for a background snapshot in progress
+
+    // Non-copyable: tracks a child process
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    bool write();               // synchronous
+    bool startBackground();     // false if one is still running or fork failed
+    bool isBusy();              // reaps a finished background snapshot
+    bool wait();                // false if the last background snapshot failed
+
+    // Background snapshot every interval events (0 = never); call onEvent after each one
+    void setInterval(size_t events) { interval = events; }
+    void onEvent() {
+        if (interval > 0 && ++eventsSinceSnapshot >= interval && startBackground()) {
+            eventsSinceSnapshot = 0;
+        }
+    }
+
+    // Statistics
+    size_t getSnapshotCount() const { return snapshotCount; }
+    size_t getFailureCount() const { return failureCount; }
+    const std::string& getPath() const { return path; }
+
+private:
+    TradeBookingSystem& system;
+    std::string path;
+    size_t interval;
+    size_t eventsSinceSnapshot;
+    pid_t child;
+    size_t snapshotCount;
+    size_t failureCount;
+    bool lastSucceeded;
+
+    uint64_t currentJournalSequence();
+    void finish(int status);
+};
+
+#endif // SNAPSHOT_H
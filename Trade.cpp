@@ -1,20 +1,35 @@
 #include "Trade.h"
+#include "EngineClock.h"
 
 // Initialize static member
-int Trade::nextTradeId = 1;
+std::atomic<int> Trade::nextTradeId(1);
 
 // Constructor
-Trade::Trade(const std::string& sym, int buyId, int sellId,
-             const std::string& buyUser, const std::string& sellUser,
+Trade::Trade(SymbolId sym, OrderId buyId, OrderId sellId,
+             UserId buyUser, UserId sellUser,
              int qty, double p)
-    : tradeId(nextTradeId++), symbol(sym), buyOrderId(buyId), sellOrderId(sellId),
+    : tradeId(nextTradeId.fetch_add(1, std::memory_order_relaxed)), symbolId(sym), buyOrderId(buyId), sellOrderId(sellId),
       buyUserId(buyUser), sellUserId(sellUser), quantity(qty), price(p),
-      timestamp(std::chrono::system_clock::now()) {
+      timestamp(EngineClock::wallTime()) {
+}
+
+// Constructor from a fill
+Trade::Trade(const Fill& fill)
+    : tradeId(fill.tradeId), symbolId(fill.symbolId), buyOrderId(fill.buyOrderId),
+      sellOrderId(fill.sellOrderId), buyUserId(fill.buyUserId), sellUserId(fill.sellUserId),
+      quantity(fill.quantity), price(fill.price), timestamp(EngineClock::wallTime()) {
+}
+
+// Constructor from a fill with its original timestamp
+Trade::Trade(const Fill& fill, const std::chrono::system_clock::time_point& time)
+    : tradeId(fill.tradeId), symbolId(fill.symbolId), buyOrderId(fill.buyOrderId),
+      sellOrderId(fill.sellOrderId), buyUserId(fill.buyUserId), sellUserId(fill.sellUserId),
+      quantity(fill.quantity), price(fill.price), timestamp(time) {
 }
 
 // Copy constructor
 Trade::Trade(const Trade& other)
-    : tradeId(other.tradeId), symbol(other.symbol), buyOrderId(other.buyOrderId),
+    : tradeId(other.tradeId), symbolId(other.symbolId), buyOrderId(other.buyOrderId),
       sellOrderId(other.sellOrderId), buyUserId(other.buyUserId), 
       sellUserId(other.sellUserId), quantity(other.quantity), price(other.price),
       timestamp(other.timestamp) {
@@ -24,7 +39,7 @@ Trade::Trade(const Trade& other)
 Trade& Trade::operator=(const Trade& other) {
     if (this != &other) {
         tradeId = other.tradeId;
-        symbol = other.symbol;
+        symbolId = other.symbolId;
         buyOrderId = other.buyOrderId;
         sellOrderId = other.sellOrderId;
         buyUserId = other.buyUserId;
@@ -38,7 +53,7 @@ Trade& Trade::operator=(const Trade& other) {
 
 // String representation
 std::string Trade::toString() const {
-    return "Trade[" + std::to_string(tradeId) + "]: " + symbol + 
+    return "Trade[" + std::to_string(tradeId) + "]: " + Registry::symbolName(symbolId) + 
            " " + std::to_string(quantity) + "@" + std::to_string(price) +
-           " Buyer: " + buyUserId + " Seller: " + sellUserId;
+           " Buyer: " + Registry::userName(buyUserId) + " Seller: " + Registry::userName(sellUserId);
 }
\ No newline at end of file
@@ -1,29 +1,50 @@
 #ifndef TRADE_H
 #define TRADE_H
 
+#include "Registry.h"
+#include <atomic>
 #include <string>
 #include <chrono>
 
+// Compact record of one execution, handed to an ExecutionListener as it
+// happens. Plain data only: no strings, no clock read, nothing to free.
+struct Fill {
+    int tradeId;
+    SymbolId symbolId;
+    OrderId buyOrderId;
+    OrderId sellOrderId;
+    UserId buyUserId;
+    UserId sellUserId;
+    int quantity;
+    double price;
+};
+
 class Trade {
 private:
-    static int nextTradeId;
+    static std::atomic<int> nextTradeId;
     
 public:
     int tradeId;
-    std::string symbol;
-    int buyOrderId;
-    int sellOrderId;
-    std::string buyUserId;
-    std::string sellUserId;
+    SymbolId symbolId;
+    OrderId buyOrderId;
+    OrderId sellOrderId;
+    UserId buyUserId;
+    UserId sellUserId;
     int quantity;
     double price;
     std::chrono::system_clock::time_point timestamp;
     
     // Constructor
-    Trade(const std::string& sym, int buyId, int sellId, 
-          const std::string& buyUser, const std::string& sellUser,
+    Trade(SymbolId sym, OrderId buyId, OrderId sellId, 
+          UserId buyUser, UserId sellUser,
           int qty, double p);
     
+    // From a fill (keeps the fill's trade id, stamps the current time)
+    explicit Trade(const Fill& fill);
+    
+    // From a fill with a known execution time (restoring saved state)
+    Trade(const Fill& fill, const std::chrono::system_clock::time_point& time);
+    
     // Copy constructor
     Trade(const Trade& other);
     
@@ -38,17 +59,28 @@ public:
     
     // Getters
     int getTradeId() const { return tradeId; }
-    const std::string& getSymbol() const { return symbol; }
-    int getBuyOrderId() const { return buyOrderId; }
-    int getSellOrderId() const { return sellOrderId; }
-    const std::string& getBuyUserId() const { return buyUserId; }
-    const std::string& getSellUserId() const { return sellUserId; }
+    SymbolId getSymbolId() const { return symbolId; }
+    const std::string& getSymbol() const { return Registry::symbolName(symbolId); }
+    OrderId getBuyOrderId() const { return buyOrderId; }
+    OrderId getSellOrderId() const { return sellOrderId; }
+    UserId getBuyUserId() const { return buyUserId; }
+    UserId getSellUserId() const { return sellUserId; }
     int getQuantity() const { return quantity; }
     double getPrice() const { return price; }
     const std::chrono::system_clock::time_point& getTimestamp() const { return timestamp; }
     
     // Static method to get next trade ID
-    static int getNextTradeId() { return nextTradeId; }
+    static int getNextTradeId() { return nextTradeId.load(std::memory_order_relaxed); }
+    
+    // Reserve a trade ID (fills are numbered from the same sequence as trades)
+    static int allocateTradeId() { return nextTradeId.fetch_add(1, std::memory_order_relaxed); }
+    
+    // Make later IDs start at next or above (used when restoring saved state)
+    static void advanceNextTradeId(int next) {
+        int current = nextTradeId.load(std::memory_order_relaxed);
+        while (current < next && !nextTradeId.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+        }
+    }
 };
 
 #endif // TRADE_H
\ No newline at end of file
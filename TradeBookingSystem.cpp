@@ -1,11 +1,19 @@
 #include "TradeBookingSystem.h"
+#include "EngineClock.h"
+#include "AsyncLogger.h"
+#include "Journal.h"
+#include <fstream>
 #include <iomanip>
 #include <algorithm>
 #include <sstream>
 #include <ctime>
 
 // Constructor
-TradeBookingSystem::TradeBookingSystem() : totalTradesExecuted(0), totalVolumeTraded(0.0) {
+TradeBookingSystem::TradeBookingSystem()
+    : totalTradesExecuted(0), totalVolumeTraded(0.0), verbose(true), marketData(nullptr),
+      journal(nullptr), valuation(nullptr), settlement(nullptr), riskGate(nullptr), currentOrderId(0), currentFillCount(0), currentFilledQuantity(0),
+      currentSettlementNanos(0), currentOutputNanos(0), currentJournalNanos(0),
+      currentEventTicks(0), currentOrderPrice(0.0) {
     initializeDefaultSymbols();
     initializeDefaultPrices();
 }
@@ -13,20 +21,128 @@ TradeBookingSystem::TradeBookingSystem() : totalTradesExecuted(0), totalVolumeTr
 // Initialize default trading symbols
 void TradeBookingSystem::initializeDefaultSymbols() {
     availableSymbols = {"AAPL", "GOOGL", "MSFT", "TSLA", "AMZN", "META", "NVDA", "JPM", "V", "JNJ"};
+    for (const auto& symbol : availableSymbols) {
+        SymbolId id = Registry::internSymbol(symbol);
+        ensureSymbolSlot(id);
+        symbolAvailable[id] = 1;
+    }
 }
 
 // Initialize default market prices
 void TradeBookingSystem::initializeDefaultPrices() {
-    currentMarketPrices["AAPL"] = 150.0;
-    currentMarketPrices["GOOGL"] = 2500.0;
-    currentMarketPrices["MSFT"] = 300.0;
-    currentMarketPrices["TSLA"] = 200.0;
-    currentMarketPrices["AMZN"] = 3000.0;
-    currentMarketPrices["META"] = 250.0;
-    currentMarketPrices["NVDA"] = 400.0;
-    currentMarketPrices["JPM"] = 140.0;
-    currentMarketPrices["V"] = 220.0;
-    currentMarketPrices["JNJ"] = 160.0;
+    updateMarketPrice("AAPL", 150.0);
+    updateMarketPrice("GOOGL", 2500.0);
+    updateMarketPrice("MSFT", 300.0);
+    updateMarketPrice("TSLA", 200.0);
+    updateMarketPrice("AMZN", 3000.0);
+    updateMarketPrice("META", 250.0);
+    updateMarketPrice("NVDA", 400.0);
+    updateMarketPrice("JPM", 140.0);
+    updateMarketPrice("V", 220.0);
+    updateMarketPrice("JNJ", 160.0);
+}
+
+// Grow the symbol-indexed tables to cover a new id
+void TradeBookingSystem::ensureSymbolSlot(SymbolId symbol) {
+    if (symbol >= orderBooks.size()) {
+        orderBooks.resize(symbol + 1);
+        symbolAvailable.resize(symbol + 1, 0);
+        currentMarketPrices.resize(symbol + 1, 0.0);
+    }
+}
+
+// Publish L2 market data for every book, current and future
+void TradeBookingSystem::setMarketDataPublisher(MarketDataPublisher* publisher) {
+    for (auto& book : orderBooks) {
+        if (book && marketData) {
+            marketData->detach(*book);
+        }
+    }
+    marketData = publisher;
+    for (auto& book : orderBooks) {
+        if (book && marketData) {
+            marketData->attach(*book);
+        }
+    }
+}
+
+// Stop settling on a thread before the portfolios it updates go away
+TradeBookingSystem::~TradeBookingSystem() {
+    setSettlementPipeline(nullptr);
+}
+
+// Mirror every portfolio and price into the valuation engine and keep it current
+void TradeBookingSystem::setValuationEngine(ValuationEngine* engine) {
+    awaitSettlement();
+    valuation = engine;
+    if (!valuation) {
+        return;
+    }
+    valuation->clearPositions();
+    for (SymbolId symbol = 0; symbol < currentMarketPrices.size(); ++symbol) {
+        valuation->setPrice(symbol, currentMarketPrices[symbol]);
+    }
+    for (const auto& portfolio : portfolios) {
+        if (portfolio) {
+            valuation->setCash(portfolio->getUserId(), portfolio->getCashBalance());
+            for (const Position& held : portfolio->getPositions()) {
+                valuation->setPosition(portfolio->getUserId(), held.symbol, held.quantity, held.averageCost);
+            }
+        }
+    }
+    valuation->revalue();
+}
+
+// Load every account's cash and positions and every resting order into the risk gate
+void TradeBookingSystem::setRiskGate(RiskGate* gate) {
+    awaitSettlement();
+    riskGate = gate;
+    if (!riskGate) {
+        return;
+    }
+    riskGate->clear();
+    for (const auto& portfolio : portfolios) {
+        if (portfolio) {
+            riskGate->setCash(portfolio->getUserId(), portfolio->getCashBalance());
+            for (const Position& held : portfolio->getPositions()) {
+                riskGate->setPosition(portfolio->getUserId(), held.symbol, held.quantity);
+            }
+        }
+    }
+    for (const auto& book : orderBooks) {
+        if (book) {
+            countOpenOrders(*book);
+        }
+    }
+}
+
+// Hand fills to a settlement thread from now on; the previous one settles its backlog first
+void TradeBookingSystem::setSettlementPipeline(SettlementPipeline* pipeline) {
+    if (settlement) {
+        settlement->stop();
+    }
+    settlement = pipeline;
+    if (settlement) {
+        settlement->start(*this);
+    }
+}
+
+// Replace a symbol's book with an empty one (attached to market data)
+OrderBook& TradeBookingSystem::resetOrderBook(SymbolId symbol) {
+    ensureSymbolSlot(symbol);
+    std::unique_ptr<OrderBook> book = std::make_unique<OrderBook>(symbol, orderDirectory);
+    if (marketData) {
+        marketData->attach(*book);
+    }
+    orderBooks[symbol] = std::move(book);
+    return *orderBooks[symbol];
+}
+
+// Grow the user-indexed tables to cover a new id
+void TradeBookingSystem::ensureUserSlot(UserId userId) {
+    if (userId >= portfolios.size()) {
+        portfolios.resize(userId + 1);
+    }
 }
 
 // Main system loop
@@ -44,6 +160,8 @@ void TradeBookingSystem::run() {
     
     int choice;
     while (true) {
+        // Let queued order/trade messages land before the next prompt
+        AsyncLogger::flush();
         displayMenu();
         std::cin >> choice;
         
@@ -97,15 +215,31 @@ void TradeBookingSystem::handleUserChoice(int choice, const std::string& current
 
 // User login
 bool TradeBookingSystem::loginUser(const std::string& userId) {
-    return portfolios.find(userId) != portfolios.end();
+    return getPortfolio(userId) != nullptr;
 }
 
 // Create new user
-void TradeBookingSystem::createUserIfNotExists(const std::string& userId) {
-    if (portfolios.find(userId) == portfolios.end()) {
-        portfolios[userId] = std::make_unique<Portfolio>(userId);
-        std::cout << "New user account created for: " << userId << std::endl;
+UserId TradeBookingSystem::createUserIfNotExists(const std::string& userId) {
+    UserId id = Registry::internUser(userId);
+    if (!portfolioAt(id)) {
+        awaitSettlement();  // the settlement thread reads the portfolio table
+        ensureUserSlot(id);
+        portfolios[id] = std::make_unique<Portfolio>(id);
+        if (valuation) {
+            valuation->setCash(id, portfolios[id]->getCashBalance());
+        }
+        if (riskGate) {
+            riskGate->setCash(id, portfolios[id]->getCashBalance());
+        }
+        if (journal) {
+            journal->logAccount(id);
+            journal->commit();
+        }
+        if (verbose) {
+            std::cout << "New user account created for: " << userId << std::endl;
+        }
     }
+    return id;
 }
 
 // Place order interface
@@ -144,61 +278,301 @@ void TradeBookingSystem::placeOrder(const std::string& userId) {
     placeOrderDirect(userId, symbol, side, quantity, price);
 }
 
-// Place order directly
-void TradeBookingSystem::placeOrderDirect(const std::string& userId, const std::string& symbol, 
-                                        OrderSide side, int quantity, double price) {
+// Place order directly by name (resolves ids once at the edge)
+OrderId TradeBookingSystem::placeOrderDirect(const std::string& userId, const std::string& symbol, 
+                                        OrderSide side, int quantity, double price, OrderType type) {
+    return placeOrderDirect(Registry::internUser(userId), Registry::internSymbol(symbol),
+                     side, quantity, price, type);
+}
+
+// Place order directly; returns the new order's ID (orderId 0 = allocate one, otherwise reuse it)
+OrderId TradeBookingSystem::placeOrderDirect(UserId userId, SymbolId symbol, OrderSide side, int quantity,
+                                             double price, OrderType type, OrderId orderId) {
+    uint64_t start = EngineClock::now();
+    
     // Create order book if it doesn't exist
-    if (orderBooks.find(symbol) == orderBooks.end()) {
-        orderBooks[symbol] = std::make_unique<OrderBook>(symbol);
+    ensureSymbolSlot(symbol);
+    OrderBook& orderBook = orderBooks[symbol] ? *orderBooks[symbol] : resetOrderBook(symbol);
+    uint64_t lookedUp = EngineClock::now();
+    stageLatency[STAGE_BOOK_LOOKUP].record(EngineClock::elapsedNanos(start, lookedUp));
+    
+    // Create the order in the book's pool and validate it
+    Order* order = orderId ? orderBook.createOrder(orderId, side, quantity, price, userId, type)
+                           : orderBook.createOrder(side, quantity, price, userId, type);
+    orderId = order->orderId;
+    bool valid = order->isValid();
+    
+    // Pre-trade risk: a rejected order never reaches the journal or the book
+    if (valid && riskGate) {
+        currentOrderPrice = riskPrice(orderBook, side, type, quantity, price);
+        RiskCheck check = riskGate->checkOrder(userId, symbol, side, quantity, currentOrderPrice);
+        if (check != RiskCheck::PASSED) {
+            if (verbose) {
+                AsyncLogger::logEvent(LogLevel::INFO, LogRecord::RISK_REJECTED, symbol, orderId,
+                                      static_cast<int>(check));
+            }
+            orderBook.releaseOrder(order);
+            uint64_t end = EngineClock::now();
+            stageLatency[STAGE_VALIDATION].record(EngineClock::elapsedNanos(lookedUp, end));
+            stageLatency[STAGE_TOTAL].record(EngineClock::elapsedNanos(start, end));
+            return 0;
+        }
     }
+    uint64_t validated = EngineClock::now();
+    stageLatency[STAGE_VALIDATION].record(EngineClock::elapsedNanos(lookedUp, validated));
     
-    // Create the order
-    auto order = std::make_shared<Order>(symbol, side, quantity, price, userId);
-    std::cout << "\nPlacing: " << order->toString() << std::endl;
+    // Journal the order before it can change any state
+    if (journal) {
+        journal->logNewOrder(*order);
+    }
+    uint64_t journaled = EngineClock::now();
     
-    // Use matching engine to process the order
-    auto trades = MatchingEngine::matchOrder(*orderBooks[symbol], order);
+    if (verbose) {
+        AsyncLogger::logOrder(LogLevel::INFO, LogRecord::ORDER_PLACED, *order);
+    }
+    if (!valid) {
+        AsyncLogger::logOrder(LogLevel::WARN, LogRecord::ORDER_REJECTED, *order);
+        orderBook.releaseOrder(order);
+        uint64_t output = EngineClock::now();
+        if (journal) {
+            journal->commit();
+        }
+        uint64_t end = EngineClock::now();
+        stageLatency[STAGE_JOURNAL].record(EngineClock::elapsedNanos(validated, journaled)
+                                           + EngineClock::elapsedNanos(output, end));
+        stageLatency[STAGE_OUTPUT].record(EngineClock::elapsedNanos(journaled, output));
+        stageLatency[STAGE_TOTAL].record(EngineClock::elapsedNanos(start, end));
+        return orderId;
+    }
+    uint64_t matchStart = EngineClock::now();
     
-    // Process trade results
-    processTradeResults(trades);
+    // Use matching engine to process the order (the book now owns it);
+    // each fill is settled and reported by onFill as it happens
+    currentOrderId = orderId;
+    currentFillCount = 0;
+    currentFilledQuantity = 0;
+    currentSettlementNanos = 0;
+    currentOutputNanos = 0;
+    currentJournalNanos = 0;
+    currentEventTicks = start;
+    MatchingEngine::matchOrder(orderBook, order, *this);
+    // What neither filled nor rested (market, IOC, FOK) is no longer open
+    if (riskGate && currentFilledQuantity < quantity && !orderDirectory.find(orderId)) {
+        riskGate->releaseOpen(userId, symbol, side, quantity - currentFilledQuantity, currentOrderPrice);
+    }
+    uint64_t matched = EngineClock::now();
+    uint64_t matchingNanos = EngineClock::elapsedNanos(matchStart, matched);
+    uint64_t fillNanos = std::min(matchingNanos, currentSettlementNanos + currentOutputNanos + currentJournalNanos);
+    stageLatency[STAGE_MATCHING].record(matchingNanos - fillNanos);
+    stageLatency[STAGE_SETTLEMENT].record(currentSettlementNanos);
     
-    if (trades.empty()) {
-        std::cout << "Order placed in book (no immediate matches)" << std::endl;
-    } else {
-        std::cout << "Order processed with " << trades.size() << " trade(s)" << std::endl;
+    if (verbose) {
+        if (currentFillCount > 0) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::ORDER_FILLED, symbol, orderId, currentFillCount);
+        }
+        if (type != OrderType::LIMIT && currentFilledQuantity < quantity) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::ORDER_EXPIRED, symbol, orderId,
+                                  quantity - currentFilledQuantity);
+        } else if (currentFillCount == 0) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::ORDER_RESTED, symbol, orderId);
+        }
+    }
+    uint64_t output = EngineClock::now();
+    if (journal) {
+        journal->commit();
     }
+    uint64_t end = EngineClock::now();
+    stageLatency[STAGE_JOURNAL].record(EngineClock::elapsedNanos(validated, journaled) + currentJournalNanos
+                                       + EngineClock::elapsedNanos(output, end));
+    stageLatency[STAGE_OUTPUT].record(EngineClock::elapsedNanos(journaled, matchStart) + currentOutputNanos
+                                      + EngineClock::elapsedNanos(matched, output));
+    stageLatency[STAGE_TOTAL].record(EngineClock::elapsedNanos(start, end));
+    return orderId;
 }
 
 // Cancel order interface
 void TradeBookingSystem::cancelOrder() {
-    std::string symbol;
-    int orderId;
-    
-    std::cout << "Enter symbol: ";
-    std::cin >> symbol;
-    
-    if (!validateSymbolInput(symbol)) {
-        return;
-    }
+    OrderId orderId;
     
     std::cout << "Enter order ID to cancel: ";
     std::cin >> orderId;
     
-    cancelOrderDirect(symbol, orderId);
+    cancelOrderDirect(orderId);
+}
+
+// Cancel order directly by ID alone
+bool TradeBookingSystem::cancelOrderDirect(OrderId orderId) {
+    const Order* order = orderDirectory.find(orderId);
+    if (!order) {
+        if (verbose) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::CANCEL_NOT_FOUND, Registry::INVALID_ID, orderId);
+        }
+        return false;
+    }
+    return cancelOrderDirect(order->symbolId, orderId);
+}
+
+// Cancel order directly by symbol name
+bool TradeBookingSystem::cancelOrderDirect(const std::string& symbol, OrderId orderId) {
+    return cancelOrderDirect(Registry::findSymbol(symbol), orderId);
+}
+
+// Cancel order directly; returns true if the order was resting and is now gone
+bool TradeBookingSystem::cancelOrderDirect(SymbolId symbol, OrderId orderId) {
+    OrderBook* orderBook = getOrderBook(symbol);
+    if (!orderBook) {
+        if (verbose) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::NO_ORDER_BOOK, symbol, orderId);
+        }
+        return false;
+    }
+    
+    if (journal) {
+        journal->logCancel(symbol, orderId);
+    }
+    if (riskGate) {
+        const Order* resting = orderBook->getOrder(orderId);
+        if (resting) {
+            releaseRisk(*resting);
+        }
+    }
+    bool cancelled = orderBook->cancelOrder(orderId);
+    if (cancelled && orderBook->isInCall()) {
+        MatchingEngine::publishIndicative(*orderBook);
+    }
+    if (journal) {
+        journal->commit();
+    }
+    if (verbose) {
+        AsyncLogger::logEvent(LogLevel::INFO, cancelled ? LogRecord::ORDER_CANCELLED : LogRecord::CANCEL_NOT_FOUND,
+                              symbol, orderId);
+    }
+    return cancelled;
 }
 
-// Cancel order directly
-void TradeBookingSystem::cancelOrderDirect(const std::string& symbol, int orderId) {
-    auto it = orderBooks.find(symbol);
-    if (it != orderBooks.end()) {
-        if (it->second->cancelOrder(orderId)) {
-            std::cout << "Order " << orderId << " cancelled successfully!" << std::endl;
+// Change a resting order's quantity and price in place (see MatchingEngine::modifyOrder);
+// returns true if the order was resting and the new values are valid
+bool TradeBookingSystem::modifyOrderDirect(SymbolId symbol, OrderId orderId, int quantity, double price) {
+    OrderBook* orderBook = getOrderBook(symbol);
+    if (!orderBook) {
+        if (verbose) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::NO_ORDER_BOOK, symbol, orderId);
+        }
+        return false;
+    }
+    
+    // Risk: count the order again at its new size and price; a rejected modify leaves it as it was
+    const Order* resting = riskGate ? orderBook->getOrder(orderId) : nullptr;
+    bool recounted = resting && quantity > 0 && price > 0;
+    UserId owner = resting ? resting->userId : Registry::INVALID_ID;
+    OrderSide side = resting ? resting->side : OrderSide::BUY;
+    int previousQuantity = resting ? resting->quantity : 0;
+    double previousPrice = resting ? resting->price : 0.0;
+    if (recounted) {
+        releaseRisk(*resting);
+        currentOrderPrice = riskPrice(*orderBook, side, OrderType::LIMIT, quantity, price);
+        RiskCheck check = riskGate->checkOrder(owner, symbol, side, quantity, currentOrderPrice);
+        if (check != RiskCheck::PASSED) {
+            riskGate->addOpen(owner, symbol, side, previousQuantity, previousPrice);
+            if (verbose) {
+                AsyncLogger::logEvent(LogLevel::INFO, LogRecord::RISK_REJECTED, symbol, orderId,
+                                      static_cast<int>(check));
+            }
+            return false;
+        }
+    }
+    
+    if (journal) {
+        journal->logModify(symbol, orderId, quantity, price);
+    }
+    currentOrderId = orderId;
+    currentFillCount = 0;
+    currentFilledQuantity = 0;
+    currentSettlementNanos = 0;
+    currentOutputNanos = 0;
+    currentJournalNanos = 0;
+    currentEventTicks = EngineClock::now();
+    size_t fills = 0;
+    bool modified = MatchingEngine::modifyOrder(*orderBook, orderId, quantity, price, *this, fills);
+    if (recounted && !modified) {
+        riskGate->releaseOpen(owner, symbol, side, quantity, currentOrderPrice);
+        riskGate->addOpen(owner, symbol, side, previousQuantity, previousPrice);
+    }
+    if (journal) {
+        journal->commit();
+    }
+    if (verbose) {
+        if (modified) {
+            AsyncLogger::logModify(LogLevel::INFO, symbol, orderId, quantity, price);
         } else {
-            std::cout << "Order " << orderId << " not found!" << std::endl;
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::CANCEL_NOT_FOUND, symbol, orderId);
+        }
+        if (fills > 0) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::ORDER_FILLED, symbol, orderId, currentFillCount);
         }
-    } else {
-        std::cout << "No order book exists for symbol " << symbol << std::endl;
     }
+    return modified;
+}
+
+// Start a call phase for a symbol (creating its book if needed)
+bool TradeBookingSystem::openCallAuction(SymbolId symbol) {
+    ensureSymbolSlot(symbol);
+    OrderBook& orderBook = orderBooks[symbol] ? *orderBooks[symbol] : resetOrderBook(symbol);
+    if (orderBook.isInCall()) {
+        return false;
+    }
+    if (journal) {
+        journal->logCallOpened(symbol);
+    }
+    orderBook.setInCall(true);
+    MatchingEngine::publishIndicative(orderBook);
+    if (journal) {
+        journal->commit();
+    }
+    if (verbose) {
+        AsyncLogger::logEvent(LogLevel::INFO, LogRecord::CALL_OPENED, symbol, 0);
+    }
+    return true;
+}
+
+// End a symbol's call phase at its equilibrium price; fills settle through onFill
+size_t TradeBookingSystem::uncrossAuction(SymbolId symbol) {
+    OrderBook* orderBook = getOrderBook(symbol);
+    if (!orderBook || !orderBook->isInCall()) {
+        return 0;
+    }
+    if (journal) {
+        journal->logUncross(symbol);
+    }
+    currentOrderId = 0;
+    currentFillCount = 0;
+    currentFilledQuantity = 0;
+    currentEventTicks = EngineClock::now();
+    AuctionIndicative result;
+    size_t fills = MatchingEngine::uncross(*orderBook, *this, result);
+    if (riskGate) {
+        // Auction fills are not at the orders' limits: count what still rests from scratch
+        riskGate->clearOpen(symbol);
+        countOpenOrders(*orderBook);
+    }
+    if (journal) {
+        journal->commit();
+    }
+    if (verbose) {
+        AsyncLogger::logAuction(LogLevel::INFO, LogRecord::AUCTION_UNCROSSED, symbol, result.price, result.volume,
+                                static_cast<int>(fills));
+    }
+    return fills;
+}
+
+bool TradeBookingSystem::getIndicative(SymbolId symbol, AuctionIndicative& result) const {
+    const OrderBook* orderBook = getOrderBook(symbol);
+    if (!orderBook) {
+        result = AuctionIndicative();
+        result.symbolId = symbol;
+        return false;
+    }
+    return MatchingEngine::findEquilibrium(*orderBook, result);
 }
 
 // View order book interface
@@ -214,9 +588,16 @@ void TradeBookingSystem::viewOrderBook() {
 
 // View order book directly
 void TradeBookingSystem::viewOrderBookDirect(const std::string& symbol) {
-    auto it = orderBooks.find(symbol);
-    if (it != orderBooks.end()) {
-        it->second->displayOrderBook();
+    const OrderBook* orderBook = getOrderBook(symbol);
+    if (orderBook) {
+        orderBook->displayOrderBook();
+        AuctionIndicative indicative;
+        if (orderBook->isInCall() && MatchingEngine::findEquilibrium(*orderBook, indicative)) {
+            std::cout << "Call auction: indicative " << indicative.volume << " @ " << std::fixed
+                      << std::setprecision(2) << indicative.price << std::endl;
+        } else if (orderBook->isInCall()) {
+            std::cout << "Call auction: not crossed" << std::endl;
+        }
     } else {
         std::cout << "No order book exists for symbol " << symbol << std::endl;
         std::cout << "Place an order first to create the order book." << std::endl;
@@ -225,15 +606,16 @@ void TradeBookingSystem::viewOrderBookDirect(const std::string& symbol) {
 
 // View portfolio
 void TradeBookingSystem::viewPortfolio(const std::string& userId) {
-    auto it = portfolios.find(userId);
-    if (it != portfolios.end()) {
-        it->second->displayPortfolio();
+    const Portfolio* portfolio = getPortfolio(userId);
+    if (portfolio) {
+        portfolio->displayPortfolio();
         
         // Show unrealized P&L with current market prices
-        double unrealizedPnL = it->second->calculateUnrealizedPnL(currentMarketPrices);
-        double totalValue = it->second->getTotalPortfolioValue(currentMarketPrices);
+        double unrealizedPnL = portfolio->calculateUnrealizedPnL(currentMarketPrices);
+        double totalValue = portfolio->getTotalPortfolioValue(currentMarketPrices);
         
         std::cout << "\nMARKET VALUATION:" << std::endl;
+        std::cout << "Realized P&L: $" << std::fixed << std::setprecision(2) << portfolio->calculateRealizedPnL() << std::endl;
         std::cout << "Unrealized P&L: $" << std::fixed << std::setprecision(2) << unrealizedPnL << std::endl;
         std::cout << "Total Portfolio Value: $" << std::fixed << std::setprecision(2) << totalValue << std::endl;
     } else {
@@ -255,66 +637,226 @@ void TradeBookingSystem::displayAvailableSymbols() {
 
 // Display system statistics
 void TradeBookingSystem::displaySystemStatistics() {
+    awaitSettlement();
     std::cout << "\n=== System Statistics ===" << std::endl;
     std::cout << "Total Trades Executed: " << totalTradesExecuted << std::endl;
     std::cout << "Total Volume Traded: $" << std::fixed << std::setprecision(2) << totalVolumeTraded << std::endl;
-    std::cout << "Active Users: " << portfolios.size() << std::endl;
-    std::cout << "Active Order Books: " << orderBooks.size() << std::endl;
+    size_t activeUsers = 0;
+    for (const auto& portfolio : portfolios) {
+        if (portfolio) ++activeUsers;
+    }
+    std::cout << "Active Users: " << activeUsers << std::endl;
     
     // Show total orders in all books
+    size_t activeBooks = 0;
     size_t totalOrders = 0;
-    for (std::unordered_map<std::string, std::unique_ptr<OrderBook>>::const_iterator it = orderBooks.begin(); it != orderBooks.end(); ++it) {
-        totalOrders += it->second->getTotalOrderCount();
+    for (const auto& orderBook : orderBooks) {
+        if (orderBook) {
+            ++activeBooks;
+            totalOrders += orderBook->getTotalOrderCount();
+        }
     }
+    std::cout << "Active Order Books: " << activeBooks << std::endl;
     std::cout << "Total Pending Orders: " << totalOrders << std::endl;
+    if (valuation) {
+        std::cout << "Firm Unrealized P&L: $" << std::fixed << std::setprecision(2)
+                  << valuation->getTotalUnrealizedPnL() << std::endl;
+        std::cout << "Firm Equity: $" << std::fixed << std::setprecision(2) << valuation->getTotalEquity() << std::endl;
+    }
     
     displayMarketPrices();
+    displayLatencyStatistics();
+}
+
+// Stage label used in reports
+const char* TradeBookingSystem::getStageName(LatencyStage stage) {
+    static const char* const names[STAGE_COUNT] = {
+        "Book lookup", "Validation", "Journal", "Matching", "Settlement", "Output", "Total"
+    };
+    return names[stage];
+}
+
+// Display per-stage order latency percentiles
+void TradeBookingSystem::displayLatencyStatistics() const {
+    std::cout << "\nOrder Latency by Stage (" << (EngineClock::usesTsc() ? "TSC" : "steady_clock")
+              << " clock):" << std::endl;
+    if (stageLatency[STAGE_TOTAL].getCount() == 0) {
+        std::cout << "  No orders placed yet" << std::endl;
+        return;
+    }
+    LatencyHistogram::printHeader(std::cout);
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        stageLatency[stage].printSummary(getStageName(static_cast<LatencyStage>(stage)), std::cout);
+    }
+}
+
+// Clear every stage histogram
+void TradeBookingSystem::resetLatencyStatistics() {
+    for (auto& histogram : stageLatency) {
+        histogram.reset();
+    }
+}
+
+// Write per-stage summaries and full distributions to a file
+bool TradeBookingSystem::writeLatencyReport(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Cannot write latency report: " << path << std::endl;
+        return false;
+    }
+    file << "# Order latency by stage, nanoseconds ("
+         << (EngineClock::usesTsc() ? "TSC" : "steady_clock") << " clock)" << std::endl;
+    LatencyHistogram::printHeader(file);
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        stageLatency[stage].printSummary(getStageName(static_cast<LatencyStage>(stage)), file);
+    }
+    file << std::endl << "# Distributions: bucket-upper-bound count cumulative-percent" << std::endl;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        stageLatency[stage].writeDistribution(getStageName(static_cast<LatencyStage>(stage)), file);
+        file << std::endl;
+    }
+    return static_cast<bool>(file);
 }
 
 // Display current market prices
 void TradeBookingSystem::displayMarketPrices() {
     std::cout << "\nCurrent Market Prices:" << std::endl;
-    for (const auto& pair : currentMarketPrices) {
-    std::cout << "  " << pair.first << ": $" << std::fixed << std::setprecision(2) << pair.second << std::endl;
+    for (SymbolId symbol = 0; symbol < currentMarketPrices.size(); ++symbol) {
+        if (currentMarketPrices[symbol] > 0) {
+            std::cout << "  " << Registry::symbolName(symbol) << ": $" << std::fixed << std::setprecision(2)
+                      << currentMarketPrices[symbol] << std::endl;
+        }
     }
 }
 
-// Process trade results
-void TradeBookingSystem::processTradeResults(const std::vector<Trade>& trades) {
-    if (trades.empty()) return;
-    
-    updatePortfoliosWithTrades(trades);
-    updateSystemStatistics(trades);
+// Settle one fill from the matching engine, then report it
+void TradeBookingSystem::onFill(const Fill& fill) {
+    uint64_t start = EngineClock::now();
+    if (riskGate) {
+        updateRisk(fill);
+    }
+    if (settlement) {
+        settlement->publish(fill, currentEventTicks);
+    } else {
+        updatePortfoliosWithFill(fill, currentEventTicks);
+        updateSystemStatistics(fill);
+    }
+    uint64_t settled = EngineClock::now();
+    currentSettlementNanos += EngineClock::elapsedNanos(start, settled);
     
-    std::cout << "\n=== Trade Execution Summary ===" << std::endl;
-    for (const auto& trade : trades) {
-        std::cout << trade.toString() << std::endl;
+    if (journal) {
+        journal->logFill(fill);
+        uint64_t journaled = EngineClock::now();
+        currentJournalNanos += EngineClock::elapsedNanos(settled, journaled);
+        settled = journaled;
+    }
+    if (verbose) {
+        if (currentFillCount == 0) {
+            AsyncLogger::logEvent(LogLevel::INFO, LogRecord::EXECUTION_SUMMARY, fill.symbolId, currentOrderId);
+        }
+        AsyncLogger::logFill(LogLevel::INFO, LogRecord::TRADE, fill);
+        currentOutputNanos += EngineClock::elapsedNanos(settled, EngineClock::now());
+    }
+    ++currentFillCount;
+    currentFilledQuantity += fill.quantity;
+}
+
+// A batch from one sweep, settled in order without a virtual call per fill
+void TradeBookingSystem::onFills(const Fill* fills, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        TradeBookingSystem::onFill(fills[i]);
+    }
+}
+
+// A batch from the settlement pipeline, applied in publish order
+void TradeBookingSystem::settleFills(const SettlementRecord* records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        updatePortfoliosWithFill(records[i].fill, records[i].eventTicks);
+        updateSystemStatistics(records[i].fill);
+    }
+}
+
+// Update buyer and seller portfolios with a fill
+void TradeBookingSystem::updatePortfoliosWithFill(const Fill& fill, uint64_t eventTicks) {
+    Portfolio* buyer = portfolioAt(fill.buyUserId);
+    Portfolio* seller = portfolioAt(fill.sellUserId);
+    if (!buyer && !seller) {
+        return;
+    }
+    Trade trade(fill, EngineClock::toWallTime(eventTicks));
+    if (buyer) {
+        buyer->addTrade(trade, true); // true = buyer side
+    }
+    if (seller) {
+        seller->addTrade(trade, false); // false = seller side
+    }
+    if (valuation) {
+        updateValuation(fill.buyUserId, fill.symbolId);
+        updateValuation(fill.sellUserId, fill.symbolId);
+    }
+}
+
+// Copy one account's cash and position in a symbol to the valuation engine
+void TradeBookingSystem::updateValuation(UserId userId, SymbolId symbol) {
+    const Portfolio* portfolio = portfolioAt(userId);
+    if (portfolio) {
+        const Position* held = portfolio->findPosition(symbol);
+        valuation->setCash(userId, portfolio->getCashBalance());
+        valuation->setPosition(userId, symbol, held ? held->quantity : 0, held ? held->averageCost : 0.0);
     }
 }
 
-// Update portfolios with executed trades
-void TradeBookingSystem::updatePortfoliosWithTrades(const std::vector<Trade>& trades) {
-    for (const auto& trade : trades) {
-        // Update buyer's portfolio
-        auto buyerIt = portfolios.find(trade.buyUserId);
-        if (buyerIt != portfolios.end()) {
-            buyerIt->second->addTrade(trade, true); // true = buyer side
+// Price an order is counted at by the risk gate: its limit on the book's tick grid,
+// or for a market order the worst opposite level its quantity reaches, so a sweep
+// is never counted cheaper than it can fill (0 when that side is empty)
+double TradeBookingSystem::riskPrice(const OrderBook& book, OrderSide side, OrderType type, int quantity,
+                                     double price) const {
+    if (type == OrderType::MARKET) {
+        const PriceLadder& opposite = side == OrderSide::BUY ? book.getSellOrders() : book.getBuyOrders();
+        double worst = 0.0;
+        int64_t reached = 0;
+        for (const PriceLevel* level = opposite.best(); level && reached < quantity; level = opposite.next(*level)) {
+            worst = level->price;
+            reached += level->totalQuantity;
         }
-        
-        // Update seller's portfolio
-        auto sellerIt = portfolios.find(trade.sellUserId);
-        if (sellerIt != portfolios.end()) {
-            sellerIt->second->addTrade(trade, false); // false = seller side
+        return worst;
+    }
+    return book.tickToPrice(book.priceToTick(price));
+}
+
+// Move cash and positions, and release the filled quantity from both orders'
+// open counts: the current order at the price it was counted at, the resting
+// one at its limit, which is the fill price
+void TradeBookingSystem::updateRisk(const Fill& fill) {
+    riskGate->applyFill(fill);
+    if (currentOrderId == 0) {
+        return;     // an uncross recounts its book afterwards
+    }
+    riskGate->releaseOpen(fill.buyUserId, fill.symbolId, OrderSide::BUY, fill.quantity,
+                          fill.buyOrderId == currentOrderId ? currentOrderPrice : fill.price);
+    riskGate->releaseOpen(fill.sellUserId, fill.symbolId, OrderSide::SELL, fill.quantity,
+                          fill.sellOrderId == currentOrderId ? currentOrderPrice : fill.price);
+}
+
+void TradeBookingSystem::releaseRisk(const Order& order) {
+    riskGate->releaseOpen(order.userId, order.symbolId, order.side, order.quantity, order.price);
+}
+
+// Count every order resting in a book as open
+void TradeBookingSystem::countOpenOrders(const OrderBook& book) {
+    for (const PriceLadder* ladder : { &book.getBuyOrders(), &book.getSellOrders() }) {
+        for (const PriceLevel* level = ladder->best(); level; level = ladder->next(*level)) {
+            for (const Order* order = level->head; order; order = order->nextInLevel) {
+                riskGate->addOpen(order->userId, order->symbolId, order->side, order->quantity, order->price);
+            }
         }
     }
 }
 
 // Update system statistics
-void TradeBookingSystem::updateSystemStatistics(const std::vector<Trade>& trades) {
-    for (const auto& trade : trades) {
-        totalTradesExecuted++;
-        totalVolumeTraded += trade.quantity * trade.price;
-    }
+void TradeBookingSystem::updateSystemStatistics(const Fill& fill) {
+    totalTradesExecuted++;
+    totalVolumeTraded += fill.quantity * fill.price;
 }
 
 // Validation functions
@@ -345,71 +887,137 @@ bool TradeBookingSystem::validateQuantityInput(int quantity) {
 
 // Symbol management
 bool TradeBookingSystem::isSymbolAvailable(const std::string& symbol) const {
-    return std::find(availableSymbols.begin(), availableSymbols.end(), symbol) != availableSymbols.end();
+    return isSymbolAvailable(Registry::findSymbol(symbol));
 }
 
-void TradeBookingSystem::addSymbol(const std::string& symbol) {
-    if (!isSymbolAvailable(symbol)) {
+SymbolId TradeBookingSystem::addSymbol(const std::string& symbol) {
+    SymbolId id = Registry::internSymbol(symbol);
+    if (!isSymbolAvailable(id)) {
+        ensureSymbolSlot(id);
+        symbolAvailable[id] = 1;
         availableSymbols.push_back(symbol);
-        currentMarketPrices[symbol] = 100.0; // Default price
+        currentMarketPrices[id] = 100.0; // Default price
         std::cout << "Symbol " << symbol << " added to trading system" << std::endl;
     }
+    return id;
 }
 
 // Market data management
 void TradeBookingSystem::updateMarketPrice(const std::string& symbol, double price) {
     if (price > 0) {
+        updateMarketPrice(Registry::internSymbol(symbol), price);
+    }
+}
+
+void TradeBookingSystem::updateMarketPrice(SymbolId symbol, double price) {
+    if (price > 0) {
+        ensureSymbolSlot(symbol);
         currentMarketPrices[symbol] = price;
+        if (valuation) {
+            awaitSettlement();  // the settlement thread re-marks the same columns
+            valuation->setPrice(symbol, price);
+        }
     }
 }
 
 double TradeBookingSystem::getMarketPrice(const std::string& symbol) const {
-    auto it = currentMarketPrices.find(symbol);
-    return (it != currentMarketPrices.end()) ? it->second : 0.0;
+    return getMarketPrice(Registry::findSymbol(symbol));
+}
+
+double TradeBookingSystem::getMarketPrice(SymbolId symbol) const {
+    return (symbol < currentMarketPrices.size()) ? currentMarketPrices[symbol] : 0.0;
 }
 
 // Access functions
 Portfolio* TradeBookingSystem::getPortfolio(const std::string& userId) {
-    auto it = portfolios.find(userId);
-    return (it != portfolios.end()) ? it->second.get() : nullptr;
+    return getPortfolio(Registry::findUser(userId));
 }
 
 const Portfolio* TradeBookingSystem::getPortfolio(const std::string& userId) const {
-    auto it = portfolios.find(userId);
-    return (it != portfolios.end()) ? it->second.get() : nullptr;
+    return getPortfolio(Registry::findUser(userId));
+}
+
+// Portfolios trail matching when settlement runs on its thread: wait for it
+Portfolio* TradeBookingSystem::getPortfolio(UserId userId) {
+    awaitSettlement();
+    return portfolioAt(userId);
+}
+
+const Portfolio* TradeBookingSystem::getPortfolio(UserId userId) const {
+    awaitSettlement();
+    return portfolioAt(userId);
 }
 
 OrderBook* TradeBookingSystem::getOrderBook(const std::string& symbol) {
-    auto it = orderBooks.find(symbol);
-    return (it != orderBooks.end()) ? it->second.get() : nullptr;
+    return getOrderBook(Registry::findSymbol(symbol));
 }
 
 const OrderBook* TradeBookingSystem::getOrderBook(const std::string& symbol) const {
-    auto it = orderBooks.find(symbol);
-    return (it != orderBooks.end()) ? it->second.get() : nullptr;
+    return getOrderBook(Registry::findSymbol(symbol));
+}
+
+OrderBook* TradeBookingSystem::getOrderBook(SymbolId symbol) {
+    return (symbol < orderBooks.size()) ? orderBooks[symbol].get() : nullptr;
+}
+
+const OrderBook* TradeBookingSystem::getOrderBook(SymbolId symbol) const {
+    return (symbol < orderBooks.size()) ? orderBooks[symbol].get() : nullptr;
 }
 
 // Utility functions
 void TradeBookingSystem::clearAllOrders() {
-    for (auto& pair : orderBooks) {
-    const std::string& symbol = pair.first;
-    pair.second = std::make_unique<OrderBook>(symbol);
-}
-std::cout << "All orders cleared from system" << std::endl;
+    for (SymbolId symbol = 0; symbol < orderBooks.size(); ++symbol) {
+        if (orderBooks[symbol]) {
+            if (journal) {
+                journal->logBookCleared(symbol);
+            }
+            resetOrderBook(symbol);
+            if (riskGate) {
+                riskGate->clearOpen(symbol);
+            }
+        }
+    }
+    if (journal) {
+        journal->commit();
+    }
+    std::cout << "All orders cleared from system" << std::endl;
 }
 
 void TradeBookingSystem::clearOrdersForSymbol(const std::string& symbol) {
-    auto it = orderBooks.find(symbol);
-    if (it != orderBooks.end()) {
-        it->second = std::make_unique<OrderBook>(symbol);
+    SymbolId id = Registry::findSymbol(symbol);
+    if (getOrderBook(id)) {
+        if (journal) {
+            journal->logBookCleared(id);
+            journal->commit();
+        }
+        resetOrderBook(id);
+        if (riskGate) {
+            riskGate->clearOpen(id);
+        }
         std::cout << "Orders cleared for symbol " << symbol << std::endl;
     }
 }
 
 void TradeBookingSystem::resetSystem() {
-    orderBooks.clear();
-    portfolios.clear();
+    awaitSettlement();
+    if (journal) {
+        journal->logReset();
+        journal->commit();
+    }
+    for (auto& orderBook : orderBooks) {
+        orderBook.reset();
+    }
+    for (auto& portfolio : portfolios) {
+        portfolio.reset();
+    }
+    if (valuation) {
+        valuation->clearPositions();
+    }
+    if (riskGate) {
+        riskGate->clear();
+    }
     totalTradesExecuted = 0;
     totalVolumeTraded = 0.0;
+    resetLatencyStatistics();
     std::cout << "System reset completed" << std::endl;
 }
\ No newline at end of file
@@ -2,38 +2,101 @@
 #define TRADEBOOKINGSYSTEM_H
 
 #include "OrderBook.h"
+#include "OrderDirectory.h"
 #include "Portfolio.h"
 #include "MatchingEngine.h"
+#include "ExecutionListener.h"
+#include "MarketDataPublisher.h"
+#include "ValuationEngine.h"
+#include "Registry.h"
+#include "LatencyHistogram.h"
+#include "SettlementPipeline.h"
+#include "RiskGate.h"
 #include <iostream>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include <string>
 
-class TradeBookingSystem {
+class Journal;
+
+// Receives fills from the matching engine privately (see onFill)
+class TradeBookingSystem : private ExecutionListener {
+    friend class SystemSnapshot;    // restores books, portfolios and statistics directly
+    friend class SettlementPipeline;    // applies fills on its thread (settleFills)
+    
+public:
+    // Order lifecycle stages timed by placeOrderDirect
+    enum LatencyStage {
+        STAGE_BOOK_LOOKUP,
+        STAGE_VALIDATION,   // order fields and pre-trade risk checks
+        STAGE_JOURNAL,      // order, fill and commit records (zero without a journal)
+        STAGE_MATCHING,     // matching engine only, settlement, journal and output excluded
+        STAGE_SETTLEMENT,   // onFill: portfolios and statistics, or the hand-off to the settlement thread
+        STAGE_OUTPUT,       // console output (near zero when not verbose)
+        STAGE_TOTAL,
+        STAGE_COUNT
+    };
+    
 private:
-    // Order books for each symbol
-    std::unordered_map<std::string, std::unique_ptr<OrderBook>> orderBooks;
+    // Every resting order by ID, shared by all books (declared before them:
+    // a book takes its orders out as it is destroyed)
+    OrderDirectory orderDirectory;
     
-    // User portfolios
-    std::unordered_map<std::string, std::unique_ptr<Portfolio>> portfolios;
+    // Order books for each symbol (indexed by SymbolId, null until first order)
+    std::vector<std::unique_ptr<OrderBook>> orderBooks;
     
-    // Available trading symbols
+    // User portfolios (indexed by UserId, null for unknown users)
+    std::vector<std::unique_ptr<Portfolio>> portfolios;
+    
+    // Available trading symbols (names for display, flags indexed by SymbolId)
     std::vector<std::string> availableSymbols;
+    std::vector<char> symbolAvailable;
     
-    // Current market prices for P&L calculations
-    std::unordered_map<std::string, double> currentMarketPrices;
+    // Current market prices for P&L calculations (indexed by SymbolId, 0 = unset)
+    std::vector<double> currentMarketPrices;
     
     // System statistics
     size_t totalTradesExecuted;
     double totalVolumeTraded;
     
+    // Per-order console output (off for headless runs)
+    bool verbose;
+    
+    // L2 market data for every book (null = off)
+    MarketDataPublisher* marketData;
+    
+    // Write-ahead journal of inbound events and fills (null = off)
+    Journal* journal;
+    
+    // Firm-wide mark-to-market of every account (null = off)
+    ValuationEngine* valuation;
+    
+    // Settles fills on its own thread (null = inline in onFill)
+    SettlementPipeline* settlement;
+    
+    // Pre-trade risk checks in front of matching (null = off)
+    RiskGate* riskGate;
+    
+    // Per-stage order latency (indexed by LatencyStage)
+    LatencyHistogram stageLatency[STAGE_COUNT];
+    
+    // State of the order currently being matched, updated by onFill
+    OrderId currentOrderId;
+    int currentFillCount;
+    int currentFilledQuantity;
+    uint64_t currentSettlementNanos;
+    uint64_t currentOutputNanos;
+    uint64_t currentJournalNanos;
+    uint64_t currentEventTicks;     // EngineClock reading at arrival; stamps every trade of the event
+    double currentOrderPrice;       // price the risk gate counted the current order's open quantity at
+    
 public:
     // Constructor
     TradeBookingSystem();
     
-    // Destructor
-    ~TradeBookingSystem() = default;
+    // Destructor (stops an attached settlement thread)
+    ~TradeBookingSystem();
     
     // Main system interface
     void run();
@@ -41,14 +104,28 @@ public:
     
     // User management
     bool loginUser(const std::string& userId);
-    void createUserIfNotExists(const std::string& userId);
+    UserId createUserIfNotExists(const std::string& userId);
     
     // Order management
     void placeOrder(const std::string& userId);
-    void placeOrderDirect(const std::string& userId, const std::string& symbol, 
-                         OrderSide side, int quantity, double price);
+    OrderId placeOrderDirect(const std::string& userId, const std::string& symbol, 
+                             OrderSide side, int quantity, double price, OrderType type = OrderType::LIMIT);
+    OrderId placeOrderDirect(UserId userId, SymbolId symbol, OrderSide side, int quantity, double price,
+                             OrderType type = OrderType::LIMIT, OrderId orderId = 0);
     void cancelOrder();
-    void cancelOrderDirect(const std::string& symbol, int orderId);
+    bool cancelOrderDirect(OrderId orderId);    // any symbol: the directory finds the book
+    bool cancelOrderDirect(const std::string& symbol, OrderId orderId);
+    bool cancelOrderDirect(SymbolId symbol, OrderId orderId);
+    bool modifyOrderDirect(SymbolId symbol, OrderId orderId, int quantity, double price);
+    
+    // A resting order by ID alone (null once it is filled or cancelled)
+    const Order* findOrder(OrderId orderId) const { return orderDirectory.find(orderId); }
+    size_t getRestingOrderCount() const { return orderDirectory.size(); }
+    
+    // Call auctions: a symbol's orders accumulate without matching until it uncrosses
+    bool openCallAuction(SymbolId symbol);      // false if the call is already open
+    size_t uncrossAuction(SymbolId symbol);     // fills executed (0 when no call is open)
+    bool getIndicative(SymbolId symbol, AuctionIndicative& result) const;  // false if nothing crosses
     
     // Display functions
     void viewOrderBook();
@@ -58,37 +135,100 @@ public:
     void displaySystemStatistics();
     
     // Symbol management
-    void addSymbol(const std::string& symbol);
+    SymbolId addSymbol(const std::string& symbol);
     bool isSymbolAvailable(const std::string& symbol) const;
+    bool isSymbolAvailable(SymbolId symbol) const {
+        return symbol < symbolAvailable.size() && symbolAvailable[symbol];
+    }
     const std::vector<std::string>& getAvailableSymbols() const { return availableSymbols; }
     
     // Market data
     void updateMarketPrice(const std::string& symbol, double price);
+    void updateMarketPrice(SymbolId symbol, double price);
     double getMarketPrice(const std::string& symbol) const;
+    double getMarketPrice(SymbolId symbol) const;
     void displayMarketPrices();
     
     // Portfolio management
     Portfolio* getPortfolio(const std::string& userId);
     const Portfolio* getPortfolio(const std::string& userId) const;
+    Portfolio* getPortfolio(UserId userId);
+    const Portfolio* getPortfolio(UserId userId) const;
     
     // Order book access
     OrderBook* getOrderBook(const std::string& symbol);
     const OrderBook* getOrderBook(const std::string& symbol) const;
+    OrderBook* getOrderBook(SymbolId symbol);
+    const OrderBook* getOrderBook(SymbolId symbol) const;
     
     // System utilities
     void clearAllOrders();
     void clearOrdersForSymbol(const std::string& symbol);
     void resetSystem();
     
-    // Statistics
-    size_t getTotalTradesExecuted() const { return totalTradesExecuted; }
-    double getTotalVolumeTraded() const { return totalVolumeTraded; }
+    // Statistics (wait for pending settlement)
+    size_t getTotalTradesExecuted() const { awaitSettlement(); return totalTradesExecuted; }
+    double getTotalVolumeTraded() const { awaitSettlement(); return totalVolumeTraded; }
+    
+    // Latency statistics
+    const LatencyHistogram& getStageLatency(LatencyStage stage) const { return stageLatency[stage]; }
+    static const char* getStageName(LatencyStage stage);
+    void displayLatencyStatistics() const;
+    void resetLatencyStatistics();
+    bool writeLatencyReport(const std::string& path) const;
+    
+    // Output control
+    void setVerbose(bool enabled) { verbose = enabled; }
+    bool isVerbose() const { return verbose; }
+    
+    // Market data (attaches every current and future book; must outlive them or be reset to null)
+    void setMarketDataPublisher(MarketDataPublisher* publisher);
+    MarketDataPublisher* getMarketDataPublisher() const { return marketData; }
+    
+    // Journal (must stay open while attached; recover before attaching)
+    void setJournal(Journal* target) { journal = target; }
+    Journal* getJournal() const { return journal; }
+    
+    // Valuation (loaded from every portfolio and price, then kept current by fills and price updates)
+    void setValuationEngine(ValuationEngine* engine);
+    ValuationEngine* getValuationEngine() const { return valuation; }
+    
+    // Risk gate (loaded from every portfolio and resting order, then kept current by
+    // orders, fills and cancels). Orders it rejects are neither journaled nor matched.
+    void setRiskGate(RiskGate* gate);
+    RiskGate* getRiskGate() const { return riskGate; }
+    
+    // Settlement pipeline (starts its thread; null = settle inline again). With
+    // one attached, portfolios, statistics and valuation trail matching: the
+    // read APIs above wait until every fill published so far is applied.
+    void setSettlementPipeline(SettlementPipeline* pipeline);
+    SettlementPipeline* getSettlementPipeline() const { return settlement; }
+    uint64_t getFillSequence() const { return settlement ? settlement->getPublishedSequence() : 0; }
+    void awaitSettlement(uint64_t fillSequence) const {
+        if (settlement) {
+            settlement->waitFor(fillSequence);
+        }
+    }
+    void awaitSettlement() const {
+        if (settlement) {
+            settlement->sync();
+        }
+    }
     
 private:
-    // Helper functions
-    void processTradeResults(const std::vector<Trade>& trades);
-    void updatePortfoliosWithTrades(const std::vector<Trade>& trades);
-    void updateSystemStatistics(const std::vector<Trade>& trades);
+    // Fill handling: settles and reports each fill as the engine produces it
+    void onFill(const Fill& fill) override;
+    void onFills(const Fill* fills, size_t count) override;
+    void settleFills(const SettlementRecord* records, size_t count);   // settlement thread
+    void updatePortfoliosWithFill(const Fill& fill, uint64_t eventTicks);
+    void updateSystemStatistics(const Fill& fill);
+    void updateValuation(UserId userId, SymbolId symbol);
+    
+    // Risk gate bookkeeping (see setRiskGate)
+    double riskPrice(const OrderBook& book, OrderSide side, OrderType type, int quantity, double price) const;
+    void updateRisk(const Fill& fill);
+    void releaseRisk(const Order& order);
+    void countOpenOrders(const OrderBook& book);
     
     // Input validation
     bool validateSymbolInput(const std::string& symbol);
@@ -102,6 +242,16 @@ private:
     // Initialization
     void initializeDefaultSymbols();
     void initializeDefaultPrices();
+    
+    // Portfolio by id without waiting for settlement (settlement side)
+    Portfolio* portfolioAt(UserId userId) const {
+        return (userId < portfolios.size()) ? portfolios[userId].get() : nullptr;
+    }
+    
+    // Id-indexed table management
+    void ensureSymbolSlot(SymbolId symbol);
+    OrderBook& resetOrderBook(SymbolId symbol);
+    void ensureUserSlot(UserId userId);
 };
 
 #endif // TRADEBOOKINGSYSTEM_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef UTIL_H
+#define UTIL_H
+
+#include "EngineClock.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Small helpers shared by the order-log replayer, the load generator and the
+// benchmarks. Digests and seeded runs depend on them, so each exists once.
+
+// xorshift64*: the same stream on every platform for a given seed
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// FNV-1a
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Fold the bytes of a fixed-width value
+template <typename T>
+inline void fnvMix(uint64_t& hash, const T& value) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+// Fold one 64-bit word in a single step
+inline void fnvMixWord(uint64_t& hash, uint64_t word) {
+    hash = (hash ^ word) * FNV_PRIME;
+}
+
+// Wait until targetNanos after startTicks (EngineClock). Sleep for long gaps
+// and spin for the last stretch so short gaps stay accurate.
+inline void waitUntil(uint64_t startTicks, uint64_t targetNanos) {
+    const uint64_t spinNanos = 200000;
+    uint64_t elapsed = EngineClock::elapsedNanos(startTicks, EngineClock::now());
+    if (targetNanos > elapsed + spinNanos) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(targetNanos - elapsed - spinNanos));
+    }
+    while (EngineClock::elapsedNanos(startTicks, EngineClock::now()) < targetNanos) {
+    }
+}
+
+#endif // UTIL_H
@@ -0,0 +1,191 @@
+#include "ValuationEngine.h"
+#include "EngineClock.h"
+#include <algorithm>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Users revalued together against every column, sized to stay in L1
+    const size_t BLOCK_USERS = 512;
+    // Below this many users per thread, spawning costs more than it saves
+    const size_t MIN_USERS_PER_THREAD = 8192;
+
+    // value[i] += q[i] * a; unrealized[i] += q[i] * a - w * basis[i] over [begin, end)
+    void accumulate(const double* quantity, const double* basis, double a, double w,
+                    double* value, double* unrealized, size_t begin, size_t end) {
+        size_t i = begin;
+#ifdef __SSE2__
+        const __m128d va = _mm_set1_pd(a);
+        const __m128d vw = _mm_set1_pd(w);
+        for (; i + 2 <= end; i += 2) {
+            __m128d marked = _mm_mul_pd(_mm_loadu_pd(quantity + i), va);
+            __m128d cost = _mm_mul_pd(_mm_loadu_pd(basis + i), vw);
+            _mm_storeu_pd(value + i, _mm_add_pd(_mm_loadu_pd(value + i), marked));
+            _mm_storeu_pd(unrealized + i, _mm_add_pd(_mm_loadu_pd(unrealized + i), _mm_sub_pd(marked, cost)));
+        }
+#endif
+        for (; i < end; ++i) {
+            double marked = quantity[i] * a;
+            value[i] += marked;
+            unrealized[i] += marked - w * basis[i];
+        }
+    }
+}
+
+ValuationEngine::ValuationEngine(size_t threads)
+    : threadCount(threads > 0 ? threads : 1), userCount(0), lastRevalueNanos(0) {
+}
+
+// Grow the per-user arrays and every column to cover a new id
+void ValuationEngine::ensureUser(UserId user) {
+    if (user >= cash.size()) {
+        size_t capacity = std::max<size_t>(std::max<size_t>(user + 1, cash.size() * 2), 64);
+        cash.resize(capacity, 0.0);
+        marketValue.resize(capacity, 0.0);
+        unrealized.resize(capacity, 0.0);
+        for (Column& column : columns) {
+            if (!column.quantity.empty()) {
+                column.quantity.resize(capacity, 0.0);
+                column.basis.resize(capacity, 0.0);
+            }
+        }
+    }
+    userCount = std::max<size_t>(userCount, user + 1);
+}
+
+ValuationEngine::Column& ValuationEngine::ensureColumn(SymbolId symbol) {
+    if (symbol >= columns.size()) {
+        columns.resize(symbol + 1);
+        prices.resize(symbol + 1, 0.0);
+    }
+    Column& column = columns[symbol];
+    if (column.quantity.empty()) {
+        column.quantity.assign(cash.size(), 0.0);
+        column.basis.assign(cash.size(), 0.0);
+    }
+    return column;
+}
+
+// Re-mark one column against the new price
+void ValuationEngine::setPrice(SymbolId symbol, double price) {
+    if (symbol >= prices.size()) {
+        columns.resize(symbol + 1);
+        prices.resize(symbol + 1, 0.0);
+    }
+    double previous = prices[symbol];
+    prices[symbol] = price;
+    const Column& column = columns[symbol];
+    if (column.quantity.empty() || previous == price) {
+        return;
+    }
+    // Unset prices contribute nothing, so moving to or from 0 adds or removes the basis
+    double a = price - previous;
+    double w = 0.0;
+    if (previous <= 0) {
+        a = price;
+        w = 1.0;
+    } else if (price <= 0) {
+        a = -previous;
+        w = -1.0;
+    }
+    accumulate(column.quantity.data(), column.basis.data(), a, w,
+               marketValue.data(), unrealized.data(), 0, userCount);
+}
+
+// Replace one cell, moving the user's totals by the difference
+void ValuationEngine::setPosition(UserId user, SymbolId symbol, int quantity, double averageCost) {
+    ensureUser(user);
+    Column& column = ensureColumn(symbol);
+    double price = prices[symbol];
+    if (price > 0) {
+        double before = column.quantity[user] * price;
+        marketValue[user] -= before;
+        unrealized[user] -= before - column.basis[user];
+    }
+    column.quantity[user] = quantity;
+    column.basis[user] = quantity * averageCost;
+    if (price > 0) {
+        double after = column.quantity[user] * price;
+        marketValue[user] += after;
+        unrealized[user] += after - column.basis[user];
+    }
+}
+
+void ValuationEngine::setCash(UserId user, double balance) {
+    ensureUser(user);
+    cash[user] = balance;
+}
+
+void ValuationEngine::clearPositions() {
+    for (Column& column : columns) {
+        column.quantity.clear();
+        column.basis.clear();
+    }
+    std::fill(cash.begin(), cash.end(), 0.0);
+    std::fill(marketValue.begin(), marketValue.end(), 0.0);
+    std::fill(unrealized.begin(), unrealized.end(), 0.0);
+    userCount = 0;
+}
+
+// Totals for users [begin, end), one cache-sized block at a time
+void ValuationEngine::revalueRange(size_t begin, size_t end) {
+    for (size_t block = begin; block < end; block += BLOCK_USERS) {
+        size_t blockEnd = std::min(block + BLOCK_USERS, end);
+        std::fill(marketValue.begin() + block, marketValue.begin() + blockEnd, 0.0);
+        std::fill(unrealized.begin() + block, unrealized.begin() + blockEnd, 0.0);
+        for (SymbolId symbol = 0; symbol < columns.size(); ++symbol) {
+            const Column& column = columns[symbol];
+            if (!column.quantity.empty() && prices[symbol] > 0) {
+                accumulate(column.quantity.data(), column.basis.data(), prices[symbol], 1.0,
+                           marketValue.data(), unrealized.data(), block, blockEnd);
+            }
+        }
+    }
+}
+
+// Whole blocks of users per thread; the calling thread takes the first share
+void ValuationEngine::revalue() {
+    uint64_t start = EngineClock::now();
+    size_t threads = std::min(threadCount, std::max<size_t>(userCount / MIN_USERS_PER_THREAD, 1));
+    if (threads <= 1) {
+        revalueRange(0, userCount);
+    } else {
+        size_t blocks = (userCount + BLOCK_USERS - 1) / BLOCK_USERS;
+        size_t share = (blocks + threads - 1) / threads * BLOCK_USERS;
+        std::vector<std::thread> workers;
+        for (size_t begin = share; begin < userCount; begin += share) {
+            workers.emplace_back(&ValuationEngine::revalueRange, this, begin, std::min(begin + share, userCount));
+        }
+        revalueRange(0, std::min(share, userCount));
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+    lastRevalueNanos = EngineClock::elapsedNanos(start, EngineClock::now());
+}
+
+double ValuationEngine::getTotalUnrealizedPnL() const {
+    double total = 0.0;
+    for (size_t user = 0; user < userCount; ++user) {
+        total += unrealized[user];
+    }
+    return total;
+}
+
+double ValuationEngine::getTotalEquity() const {
+    double total = 0.0;
+    for (size_t user = 0; user < userCount; ++user) {
+        total += cash[user] + marketValue[user];
+    }
+    return total;
+}
+
+size_t ValuationEngine::getColumnCount() const {
+    size_t count = 0;
+    for (const Column& column : columns) {
+        count += column.quantity.empty() ? 0 : 1;
+    }
+    return count;
+}
@@ -0,0 +1,76 @@
+#ifndef VALUATIONENGINE_H
+#define VALUATIONENGINE_H
+
+#include "Registry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Firm-wide mark-to-market for every account.
+//
+// Positions are mirrored in struct-of-arrays form: one column per symbol,
+// holding quantity and signed cost basis (quantity x average cost) for every
+// UserId. Per-user market value and unrealized P&L are kept as running
+// totals, so:
+//   - a fill re-marks one (user, symbol) cell in O(1)
+//   - a price change re-marks one column, a vectorized pass over the users
+//   - revalue() recomputes every total from the columns, SSE2 kernels over
+//     blocks of users, split across threads
+// Unrealized P&L of a cell is quantity x price - basis, which covers long and
+// short positions alike. Symbols without a price (0) contribute nothing.
+// Incremental updates accumulate rounding; revalue() starts from zero again.
+class ValuationEngine {
+public:
+    explicit ValuationEngine(size_t threadCount = 1);
+
+    // Non-copyable: owns the column storage
+    ValuationEngine(const ValuationEngine&) = delete;
+    ValuationEngine& operator=(const ValuationEngine&) = delete;
+
+    // Inputs (matching thread)
+    void setPrice(SymbolId symbol, double price);
+    void setPosition(UserId user, SymbolId symbol, int quantity, double averageCost);
+    void setCash(UserId user, double balance);
+    void clearPositions();      // every account flat with no cash; prices are kept
+
+    // Recompute every account from the columns
+    void revalue();
+
+    // Per-account results (0 for unknown users)
+    double getMarketValue(UserId user) const { return user < userCount ? marketValue[user] : 0.0; }
+    double getUnrealizedPnL(UserId user) const { return user < userCount ? unrealized[user] : 0.0; }
+    double getEquity(UserId user) const { return user < userCount ? cash[user] + marketValue[user] : 0.0; }
+
+    // Firm totals
+    double getTotalUnrealizedPnL() const;
+    double getTotalEquity() const;
+
+    // Configuration and statistics
+    void setThreadCount(size_t threads) { threadCount = threads > 0 ? threads : 1; }
+    size_t getThreadCount() const { return threadCount; }
+    size_t getUserCount() const { return userCount; }
+    size_t getColumnCount() const;
+    uint64_t getLastRevalueNanos() const { return lastRevalueNanos; }
+
+private:
+    // One symbol's positions, indexed by UserId (empty until the symbol is held)
+    struct Column {
+        std::vector<double> quantity;
+        std::vector<double> basis;
+    };
+
+    size_t threadCount;
+    size_t userCount;       // users covered by the per-user arrays and every column
+    uint64_t lastRevalueNanos;
+    std::vector<Column> columns;        // indexed by SymbolId
+    std::vector<double> prices;         // indexed by SymbolId, 0 = unset
+    std::vector<double> cash;           // indexed by UserId
+    std::vector<double> marketValue;
+    std::vector<double> unrealized;
+
+    void ensureUser(UserId user);
+    Column& ensureColumn(SymbolId symbol);
+    void revalueRange(size_t begin, size_t end);
+};
+
+#endif // VALUATIONENGINE_H
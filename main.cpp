@@ -1,9 +1,195 @@
 #include "TradeBookingSystem.h"
+#include "BatchDriver.h"
+#include "CommandLine.h"
+#include "LoadGenerator.h"
+#include "OrderLog.h"
+#include "Snapshot.h"
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 
-int main() {
+int main(int argc, char* argv[]) {
     // Just the entry point - no function definitions
+    CommandLineOptions options;
+    if (!parseCommandLine(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    // Background log writer; drained and stopped automatically at exit
+    AsyncLogger::start(options.logging);
+    
+    if (options.mode == RunMode::REPLAY) {
+        OrderLogReplayer replayer;
+        if (!replayer.open(options.inputPath)) {
+            return 1;
+        }
+        OrderLogReplayer::printReport(replayer.replay(options.timed ? OrderLogReplayer::Pacing::ORIGINAL_TIMING
+                                                                    : OrderLogReplayer::Pacing::MAX_SPEED));
+        return 0;
+    }
+    
+    // Declared before system so the journal, settlement thread, valuation engine
+    // and risk gate outlive it: its destructor drains the settlement ring, which
+    // still updates valuation
+    Journal journal;
+    SettlementPipeline settlement;
+    ValuationEngine valuation(options.valuationThreads);
+    RiskGate risk(options.riskLimits);
     TradeBookingSystem system;
-    system.run();
+    
+    // Warm start: the latest snapshot, then the journal records written after it
+    bool restoring = options.mode != RunMode::CONVERT_LOG;
+    SnapshotInfo snapshotInfo;
+    if (!options.snapshotPath.empty() && restoring) {
+        std::ifstream existing(options.snapshotPath);
+        if (existing && !SystemSnapshot::load(options.snapshotPath, system, snapshotInfo)) {
+            return 1;
+        }
+        if (existing) {
+            SystemSnapshot::printLoad(snapshotInfo);
+        }
+    }
+    SnapshotWriter snapshots(system, options.snapshotPath);
+    snapshots.setInterval(options.snapshotEvery);
+    
+    // Rebuild state from the journal, then keep appending to it
+    if (!options.journalPath.empty() && restoring) {
+        JournalRecoveryResult recovered;
+        if (!journal.recover(options.journalPath, options.journal, system, recovered,
+                             snapshotInfo.journalSequence)) {
+            return 1;
+        }
+        if (recovered.records > 0) {
+            Journal::printRecovery(recovered);
+        }
+    }
+    
+    // Optional L2 market data file (declared after system so it detaches first)
+    MarketDataFileWriter marketDataFile;
+    MarketDataPublisher marketData(options.snapshotInterval);
+    if (!options.marketDataPath.empty() && restoring) {
+        if (!marketDataFile.open(options.marketDataPath)) {
+            return 1;
+        }
+        marketData.addSubscriber(&marketDataFile);
+        system.setMarketDataPublisher(&marketData);
+    }
+    
+    // Optional firm-wide valuation, loaded from the restored portfolios
+    if (options.valuationThreads > 0 && restoring) {
+        system.setValuationEngine(&valuation);
+    }
+    
+    // Optional pre-trade risk checks, loaded from the restored portfolios and books
+    if (options.riskChecks && restoring) {
+        system.setRiskGate(&risk);
+    }
+    
+    // Optional settlement thread, attached once recovery has rebuilt the portfolios
+    if (options.settlementThread && restoring) {
+        system.setSettlementPipeline(&settlement);
+    }
+    
+    if (options.mode == RunMode::CONVERT_LOG) {
+        system.setVerbose(false);
+        BatchDriver driver(system);
+        if (!driver.load(options.inputPath)) {
+            return 1;
+        }
+        if (driver.getParseErrorCount() > 0) {
+            std::cerr << "Skipped " << driver.getParseErrorCount() << " malformed line(s)" << std::endl;
+        }
+        if (!driver.exportOrderLog(options.outputPath)) {
+            return 1;
+        }
+        std::cout << "Wrote " << driver.getCommandCount() << " events to " << options.outputPath << std::endl;
+        return 0;
+    }
+    
+    if (options.mode == RunMode::BATCH || options.mode == RunMode::GENERATE) {
+        system.setVerbose(options.verbose);
+        if (options.mode == RunMode::BATCH) {
+            BatchDriver driver(system);
+            if (!driver.load(options.inputPath)) {
+                return 1;
+            }
+            if (driver.getParseErrorCount() > 0) {
+                std::cerr << "Skipped " << driver.getParseErrorCount() << " malformed line(s)" << std::endl;
+            }
+            if (!options.snapshotPath.empty()) {
+                driver.setSnapshotWriter(&snapshots);
+            }
+            BatchStatistics stats = driver.run(options.shards);
+            AsyncLogger::flush();
+            BatchDriver::printReport(stats);
+        } else {
+            LoadGenerator generator(system, options.load);
+            if (!options.snapshotPath.empty()) {
+                generator.setSnapshotWriter(&snapshots);
+            }
+            LoadResult result = generator.run();
+            AsyncLogger::flush();
+            LoadGenerator::printReport(result, generator.getServiceLatency(), generator.getArrivalLatency());
+        }
+        if (marketDataFile.isOpen()) {
+            marketData.flush();
+            std::cout << "Market data: " << marketDataFile.getMessageCount() << " messages, "
+                      << marketData.getSnapshotCount() << " snapshots" << std::endl;
+        }
+        if (journal.isOpen()) {
+            journal.sync();
+            std::cout << "Journal: " << journal.getRecordCount() << " records, " << journal.getSyncCount()
+                      << " syncs (" << Journal::getSyncName(journal.getSyncPolicy()) << "), last sequence "
+                      << journal.getLastSequence() << std::endl;
+        }
+        if (system.getSettlementPipeline()) {
+            system.awaitSettlement();
+            std::cout << "Settlement: " << settlement.getSettledSequence() << " fills in " << settlement.getBatchCount()
+                      << " batches, " << settlement.getFullStallCount() << " full-ring stalls" << std::endl;
+        }
+        if (system.getRiskGate()) {
+            std::cout << "Risk: " << risk.getCheckCount() << " checks, " << risk.getRejectCount() << " rejected";
+            const char* separator = " (";
+            for (size_t reason = 1; reason < static_cast<size_t>(RiskCheck::COUNT); ++reason) {
+                uint64_t count = risk.getRejectCount(static_cast<RiskCheck>(reason));
+                if (count > 0) {
+                    std::cout << separator << getRiskCheckName(static_cast<RiskCheck>(reason)) << " " << count;
+                    separator = ", ";
+                }
+            }
+            std::cout << (risk.getRejectCount() > 0 ? ")" : "") << std::endl;
+        }
+        if (system.getValuationEngine()) {
+            valuation.revalue();
+            std::ios::fmtflags flags = std::cout.flags();
+            std::streamsize precision = std::cout.precision();
+            std::cout << "Valuation: " << valuation.getUserCount() << " accounts x " << valuation.getColumnCount()
+                      << " symbols, unrealized P&L " << std::fixed << std::setprecision(2)
+                      << valuation.getTotalUnrealizedPnL() << ", equity " << valuation.getTotalEquity()
+                      << ", full revalue " << std::setprecision(1) << valuation.getLastRevalueNanos() / 1000.0
+                      << " us on up to " << valuation.getThreadCount() << " thread(s)" << std::endl;
+            std::cout.flags(flags);
+            std::cout.precision(precision);
+        }
+    } else {
+        system.run();
+    }
+    
+    if (!options.snapshotPath.empty()) {
+        snapshots.wait();
+        if (!snapshots.write()) {
+            return 1;
+        }
+        std::cout << "Snapshot: " << snapshots.getSnapshotCount() << " written to " << snapshots.getPath();
+        if (snapshots.getFailureCount() > 0) {
+            std::cout << ", " << snapshots.getFailureCount() << " failed";
+        }
+        std::cout << std::endl;
+    }
+    
+    if (!options.latencyReportPath.empty() && !system.writeLatencyReport(options.latencyReportPath)) {
+        return 1;
+    }
     return 0;
 }